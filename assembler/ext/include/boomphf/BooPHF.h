@@ -313,6 +313,12 @@ class bitVector {
         return r;
     }
 
+    // prefetch the words touched by rank(pos)
+    void prefetch(uint64_t pos) const {
+        __builtin_prefetch(_bitArray + pos / 64ULL);
+        __builtin_prefetch(_ranks.data() + pos / _nb_bits_per_rank_sample);
+    }
+
     void save(std::ostream& os) const {
         os.write(reinterpret_cast<char const*>(&_size), sizeof(_size));
         os.write(reinterpret_cast<char const*>(&_nchar), sizeof(_nchar));
@@ -366,6 +372,10 @@ class level{
         return bitset.get(hashi);
     }
 
+    void prefetch(uint64_t hash_raw) const {
+        bitset.prefetch(fastrange64(hash_raw, hash_domain));
+    }
+
     uint64_t hash_domain;
     bitVector bitset;
 };
@@ -466,10 +476,29 @@ class mphf {
     uint64_t lookup(const elem_t &elem) const {
         if (!_built) return NOT_FOUND;
 
+        return lookup_hash(hash(elem));
+    }
+
+    // Lookup split into stages: hash(), prefetch() and lookup_hash(). Doing the
+    // first two for a batch of elements before resolving them allows the cache
+    // misses on the first level bitset to overlap.
+    template<class elem_t>
+    hash_pair_t hash(const elem_t &elem) const {
+        return _hasher.hashpair128(elem);
+    }
+
+    void prefetch(const hash_pair_t &bbhash) const {
+        if (!_built) return;
+
+        _levels[0].prefetch(bbhash[0]);
+    }
+
+    uint64_t lookup_hash(hash_pair_t bbhash) const {
+        if (!_built) return NOT_FOUND;
+
         uint64_t non_minimal_hp;
         unsigned level;
 
-        hash_pair_t bbhash = _hasher.hashpair128(elem);
         uint64_t level_hash = getLevel(bbhash, &level, _nb_levels);
 
         if (level == (_nb_levels-1)) {
@@ -49,18 +49,21 @@ def show_kmidx(file):
         print(id, offset, count)
 
 
+def unpack_seq(bytes, length):
+    nucs = ['A', 'C', 'G', 'T']
+    for byte in bytes:
+        tmp = byte
+        for _ in range(min(4, length)):
+            yield nucs[tmp & 3]
+            tmp = tmp >> 2
+        length -= 4
+
+def read_packed_seq(file, length):
+    return Seq("".join(unpack_seq(file.read((length + ST_NUC - 1) // ST_NUC * ST_SIZE), length)))
+
 def read_seq(file):
-    def unpack_seq(bytes, length):
-        nucs = ['A', 'C', 'G', 'T']
-        for byte in bytes:
-            tmp = byte
-            for _ in range(min(4, length)):
-                yield nucs[tmp & 3]
-                tmp = tmp >> 2
-            length -= 4
     length = read_int(file, 8)
-    seq = "".join(unpack_seq(file.read((length + ST_NUC - 1) // ST_NUC * ST_SIZE), length))
-    return Seq(seq)
+    return read_packed_seq(file, length)
 
 #---- De Bruijn graph ----------------------------------------------------------
 def show_grp(file, show_seq=False):
@@ -92,6 +95,59 @@ def show_grp(file, show_seq=False):
                 print("Edge", edge, ":", start, "->", end, ", l =", len(seq), "~", edge_conj, ".")
                 print("Edge", edge_conj, ":", end_conj, "->", start_conj, ", l =", len(seq), "~", edge, ".")
 
+#---- Graph snapshot -----------------------------------------------------------
+SNAPSHOT_MAGIC = 0x31504e5347445053
+
+def read_snapshot(file):
+    header = read_struct(file, Struct("=12Q"))
+    magic, _, _, _, vertex_cnt, out_cnt, edge_cnt, window_cnt = header[:8]
+    vertex_offset, out_offset, edge_offset, window_offset = header[8:]
+    if magic != SNAPSHOT_MAGIC:
+        raise ValueError("Malformed graph snapshot")
+
+    def read_table(offset, struct, count):
+        file.seek(offset)
+        return [read_struct(file, struct) for _ in range(count)]
+
+    vertices = read_table(vertex_offset, Struct("=3Q"), vertex_cnt) # id, conjugate, first out
+    out_edges = [e for e, in read_table(out_offset, Struct("=Q"), out_cnt)]
+    edges = read_table(edge_offset, Struct("=4Q2I"), edge_cnt) # id, conjugate, offset, length, window, coverage
+    windows = read_table(window_offset, Struct("=2Q"), window_cnt) # offset, bytes
+    return vertices, out_edges, edges, windows
+
+def show_grsnap(file, show_seq=False):
+    vertices, out_edges, edges, windows = read_snapshot(file)
+    vertex_conj = {v: conj for v, conj, _ in vertices}
+    start = dict()
+    for i, (v, _, out) in enumerate(vertices):
+        end = vertices[i + 1][2] if i + 1 < len(vertices) else len(out_edges)
+        for e in out_edges[out:end]:
+            start[e] = v
+
+    for edge, edge_conj, offset, length, window, _ in edges:
+        if show_seq:
+            file.seek(windows[window][0] + offset * ST_SIZE)
+            seq = read_packed_seq(file, length)
+            print(">", edge, sep="")
+            print(seq)
+            if edge != edge_conj:
+                print(">", edge_conj, sep="")
+                print(seq.reverse_complement())
+        else:
+            s, e = start[edge], vertex_conj[start[edge_conj]]
+            print("Edge", edge, ":", s, "->", e, ", l =", length, "~", edge_conj, ".")
+            print("Edge", edge_conj, ":", vertex_conj[e], "->", vertex_conj[s], ", l =", length, "~", edge, ".")
+
+def show_grsnap_sqn(file):
+    show_grsnap(file, True)
+
+def show_grsnap_cvr(file):
+    _, _, edges, _ = read_snapshot(file)
+    for edge, edge_conj, _, _, _, coverage in edges:
+        print(edge, coverage, ".")
+        if edge != edge_conj:
+            print(edge_conj, coverage, ".")
+
 #---- Paired info --------------------------------------------------------------
 def show_prd(file, clustered=False):
     size = read_int(file)
@@ -143,11 +199,21 @@ showers = {".grp" : show_grp,
            ".cvr" : show_cvr,
            ".flcvr" : show_cvr,
            ".mpr" : show_mpr,
-           ".kmidx" : show_kmidx}
+           ".kmidx" : show_kmidx,
+           ".grsnap" : show_grsnap}
+
+# Graph and coverage are saved as a snapshot, older saves keep them in .grseq and .cvr
+snapshot_showers = {".grp" : show_grsnap,
+                    ".sqn" : show_grsnap_sqn,
+                    ".cvr" : show_grsnap_cvr}
 
 basename, ext = os.path.splitext(sys.argv[1])
 target = ext
-if ext in [".grp", ".sqn"]:
+shower = showers[ext]
+if ext in snapshot_showers and os.path.exists(basename + ".grsnap"):
+    target = ".grsnap"
+    shower = snapshot_showers[ext]
+elif ext in [".grp", ".sqn"]:
     target = ".grseq"
 with open(basename + target, "rb") as file:
-    showers[ext](file)
+    shower(file)
@@ -1,10 +1,14 @@
 #pragma once
 
+#include "utils/verify.hpp"
+
+#include <algorithm>
 #include <functional>
 #include <vector>
 #include <atomic>
 
 #include <cassert>
+#include <cstdint>
 
 namespace bf {
 
@@ -217,5 +221,135 @@ public:
     }
 };
 
+/// The blocked counting Bloom filter. All the cells of an element are located
+/// in a single 64-byte block (one cache line), so every lookup touches a single
+/// line of memory. Cells of an element falling into the same 64-bit entry are
+/// updated at once with a single CAS.
+/// The block is selected by the hash value, the cells inside the block are
+/// selected by its lowest bits, so a single hash value per element is used.
+template<class T, class Hasher, unsigned width_ = 4>
+class blocked_counting_bloom_filter {
+    blocked_counting_bloom_filter(const blocked_counting_bloom_filter &) = delete;
+    blocked_counting_bloom_filter &operator=(const blocked_counting_bloom_filter &) = delete;
+
+    static constexpr uint64_t cell_mask_ = (1ull << width_) - 1;
+    static constexpr size_t cells_per_entry_ = 8 * sizeof(uint64_t) / width_;
+    static constexpr size_t entries_per_block_ = 64 / sizeof(uint64_t);
+    static constexpr size_t cells_per_block_ = cells_per_entry_ * entries_per_block_;
+    static constexpr unsigned cell_bits_ = __builtin_ctzll(cells_per_block_);
+    static constexpr size_t max_hashes_ = 64 / cell_bits_;
+
+public:
+    /// The hash digest type.
+    typedef uint64_t digest;
+
+    /// Constructs a blocked counting Bloom filter.
+    /// @param cells The number of cells, rounded up to the whole number of blocks.
+    /// @param num_hashes The number of cells per element
+    /// @param h The hasher.
+    /// The memory consumption will be cells * width bits
+    blocked_counting_bloom_filter(size_t cells, size_t num_hashes = 3,
+                                  Hasher h = Hasher())
+            : hasher_(std::move(h)),
+              num_hashes_(num_hashes),
+              blocks_(std::max<size_t>((cells + cells_per_block_ - 1) / cells_per_block_, 1)),
+              // Extra entries to align the first block to the cache line
+              data_(blocks_ * entries_per_block_ + entries_per_block_ - 1) {
+        static_assert((width_ & (width_ - 1)) == 0 && width_ <= 16, "Width must be power of two");
+        VERIFY(num_hashes_ > 0 && num_hashes_ <= max_hashes_);
+        uintptr_t addr = reinterpret_cast<uintptr_t>(data_.data());
+        offset_ = (64 - addr % 64) % 64 / sizeof(uint64_t);
+    }
+
+    /// Move-constructs a blocked counting Bloom filter.
+    blocked_counting_bloom_filter(blocked_counting_bloom_filter &&) = default;
+
+    /// Adds an element to the Bloom filter.
+    /// @param o An instance of type `T`.
+    void add(const T &o) {
+        size_t cells[max_hashes_];
+        std::atomic<uint64_t> *block = locate(o, cells);
+
+        // Coinciding cells are incremented once. Insertion sort of the few
+        // cells in place, dropping the duplicates
+        size_t ncells = 0;
+        for (size_t i = 0; i < num_hashes_; ++i) {
+            size_t cell = cells[i], j = ncells;
+            while (j > 0 && cells[j - 1] > cell)
+                --j;
+            if (j > 0 && cells[j - 1] == cell)
+                continue;
+            for (size_t l = ncells; l > j; --l)
+                cells[l] = cells[l - 1];
+            cells[j] = cell;
+            ncells += 1;
+        }
+        for (size_t i = 0; i < ncells; ) {
+            size_t pos = cells[i] / cells_per_entry_;
+            size_t end = i;
+            while (end < ncells && cells[end] / cells_per_entry_ == pos)
+                ++end;
+
+            auto &entry = block[pos];
+            uint64_t val = entry.load(std::memory_order_relaxed);
+            while (true) {
+                uint64_t newval = val;
+                for (size_t j = i; j < end; ++j) {
+                    unsigned shift = unsigned(width_ * (cells[j] % cells_per_entry_));
+                    // Overflow, do nothing
+                    if (((val >> shift) & cell_mask_) != cell_mask_)
+                        newval += 1ull << shift;
+                }
+
+                if (newval == val || entry.compare_exchange_weak(val, newval))
+                    break;
+            }
+
+            i = end;
+        }
+    }
+
+    /// Retrieves the count of an element.
+    /// @param o An instance of type `T`.
+    /// @return A frequency estimate for *o*.
+    size_t lookup(const T &o) const {
+        size_t cells[max_hashes_];
+        const std::atomic<uint64_t> *block = locate(o, cells);
+
+        size_t val = cell_mask_;
+        for (size_t i = 0; i < num_hashes_; ++i) {
+            uint64_t entry = block[cells[i] / cells_per_entry_].load(std::memory_order_relaxed);
+            size_t cval = (entry >> (width_ * (cells[i] % cells_per_entry_))) & cell_mask_;
+            if (val > cval)
+                val = cval;
+        }
+
+        return val;
+    }
+
+    /// Removes all items from the Bloom filter.
+    void clear() {
+        std::fill(data_.begin(), data_.end(), 0);
+    }
+
+private:
+    std::atomic<uint64_t> *locate(const T &o, size_t *cells) const {
+        digest d = hasher_(o);
+        // Multiply-shift instead of division, it uses the highest bits of the digest
+        size_t block = size_t((static_cast<unsigned __int128>(d) * blocks_) >> 64);
+        for (size_t i = 0; i < num_hashes_; ++i) {
+            cells[i] = d & (cells_per_block_ - 1);
+            d >>= cell_bits_;
+        }
+
+        return const_cast<std::atomic<uint64_t>*>(data_.data()) + offset_ + block * entries_per_block_;
+    }
+
+    Hasher hasher_;
+    size_t num_hashes_;
+    size_t blocks_;
+    std::vector<std::atomic<uint64_t>> data_;
+    size_t offset_;
+};
 
 } // namespace bf
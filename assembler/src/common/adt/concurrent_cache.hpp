@@ -0,0 +1,160 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <mutex>
+#include <vector>
+
+#include <cstdint>
+
+namespace adt {
+
+// Bounded cache safe for concurrent use. Keys are spread over lock-striped
+// shards, so threads contend only when they touch the same shard. A full
+// shard evicts entries with CLOCK (second chance) policy: every hit marks the
+// entry as referenced and the clock hand skips (and unmarks) referenced
+// entries once. Since a hit updates the mark, lookups take the shard lock
+// too, i.e. reads are not lock-free.
+template<class Key, class Value, class Hash = phmap::Hash<Key>>
+class concurrent_cache {
+    struct Slot {
+        Key key;
+        Value value;
+        bool referenced;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        phmap::flat_hash_map<Key, size_t, Hash> index;
+        std::vector<Slot> slots;
+        size_t hand = 0;
+        size_t hits = 0, misses = 0, evictions = 0;
+    };
+
+  public:
+    struct stats_t {
+        size_t size = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+    };
+
+    // The number of shards is rounded up to a power of two
+    explicit concurrent_cache(size_t capacity, size_t nshards = 64)
+            : shard_bits_(0) {
+        VERIFY(capacity && nshards);
+        while ((size_t(1) << shard_bits_) < nshards)
+            shard_bits_ += 1;
+        shards_ = std::vector<Shard>(size_t(1) << shard_bits_);
+        shard_capacity_ = (capacity + shards_.size() - 1) / shards_.size();
+    }
+
+    concurrent_cache(const concurrent_cache&) = delete;
+    concurrent_cache& operator=(const concurrent_cache&) = delete;
+
+    // Returns true and sets the value if the key is cached
+    bool find(const Key &key, Value &value) {
+        Shard &shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            shard.misses += 1;
+            return false;
+        }
+
+        Slot &slot = shard.slots[it->second];
+        slot.referenced = true;
+        value = slot.value;
+        shard.hits += 1;
+        return true;
+    }
+
+    void insert(const Key &key, const Value &value) {
+        Shard &shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.slots[it->second].value = value;
+            return;
+        }
+
+        if (shard.slots.size() < shard_capacity_) {
+            shard.index.emplace(key, shard.slots.size());
+            shard.slots.push_back({ key, value, false });
+            return;
+        }
+
+        while (shard.slots[shard.hand].referenced) {
+            shard.slots[shard.hand].referenced = false;
+            shard.hand = (shard.hand + 1) % shard.slots.size();
+        }
+
+        Slot &victim = shard.slots[shard.hand];
+        shard.index.erase(victim.key);
+        shard.index.emplace(key, shard.hand);
+        victim = { key, value, false };
+        shard.hand = (shard.hand + 1) % shard.slots.size();
+        shard.evictions += 1;
+    }
+
+    // Returns the cached value or computes and caches it. The value is
+    // computed without holding the lock, so concurrent misses on the same key
+    // might compute it several times.
+    template<class F>
+    Value get_or_compute(const Key &key, F compute) {
+        Value value;
+        if (find(key, value))
+            return value;
+
+        value = compute();
+        insert(key, value);
+        return value;
+    }
+
+    void clear() {
+        for (Shard &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.lock);
+            shard.index.clear();
+            shard.slots.clear();
+            shard.hand = 0;
+        }
+    }
+
+    stats_t stats() const {
+        stats_t res;
+        for (Shard &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.lock);
+            res.size += shard.slots.size();
+            res.hits += shard.hits;
+            res.misses += shard.misses;
+            res.evictions += shard.evictions;
+        }
+
+        return res;
+    }
+
+  private:
+    Shard &shard_of(const Key &key) {
+        if (!shard_bits_)
+            return shards_[0];
+
+        // Take the upper bits of the mixed hash, the lower ones are used by
+        // the index of the shard
+        uint64_t h = uint64_t(Hash()(key)) * 0x9E3779B97F4A7C15ULL;
+        return shards_[h >> (64 - shard_bits_)];
+    }
+
+    unsigned shard_bits_;
+    size_t shard_capacity_;
+    mutable std::vector<Shard> shards_;
+};
+
+}
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstring>
 #include <functional>
+#include <string>
 #include <cassert>
 
 namespace qf {
@@ -37,8 +38,23 @@ class cqf {
         // fprintf(stderr, "%llu %u %llu\n", num_slots_, num_hash_bits_, qf_.metadata->range);
     }
 
+    /// Loads the filter stored by serialize(). The number of insertions
+    /// is not stored, the number of distinct elements is used instead.
+    explicit cqf(const std::string &filename) {
+        qf_deserialize(&qf_, filename.c_str());
+        num_hash_bits_ = unsigned(qf_.metadata->key_bits);
+        num_slots_ = qf_.metadata->nslots;
+        insertions_ = qf_.metadata->ndistinct_elts;
+        range_mask_ = qf_.metadata->range - 1;
+        assert((range_mask_ & qf_.metadata->range) == 0);
+    }
+
     cqf(cqf&&) noexcept = default;
 
+    void serialize(const std::string &filename) const {
+        qf_serialize(&qf_, filename.c_str());
+    }
+
     bool add(digest d, uint64_t count = 1,
              bool lock = true, bool spin = true) {
         bool res = qf_insert(&qf_, d & range_mask_, 0, count, lock, spin);
@@ -0,0 +1,163 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "kmer_vector.hpp"
+
+#include <libcxx/sort.hpp>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include <cstring>
+
+namespace adt {
+
+namespace radix_sort_impl {
+
+// Below this size the buckets are finished off with insertion sort
+const size_t kInsertionSortThreshold = 32;
+
+// Bytes are numbered from the most significant byte of the first word, so the
+// resulting order coincides with array_less<ElTy>
+template<class ElTy>
+inline unsigned digit(const ElTy *data, size_t byte) {
+    size_t word = byte / sizeof(ElTy);
+    unsigned shift = unsigned(8 * (sizeof(ElTy) - 1 - byte % sizeof(ElTy)));
+    return unsigned(data[word] >> shift) & 0xFF;
+}
+
+template<class ElTy>
+inline bool less(const ElTy *lhs, const ElTy *rhs, size_t from, size_t el_sz) {
+    for (size_t i = from; i < el_sz; ++i) {
+        if (lhs[i] != rhs[i])
+            return lhs[i] < rhs[i];
+    }
+
+    return false;
+}
+
+template<class ElTy>
+void insertion_sort(ElTy *data, size_t n, size_t el_sz, size_t byte, ElTy *tmp) {
+    size_t word = byte / sizeof(ElTy), el_bytes = el_sz * sizeof(ElTy);
+    for (size_t i = 1; i < n; ++i) {
+        if (!less(data + i * el_sz, data + (i - 1) * el_sz, word, el_sz))
+            continue;
+
+        memcpy(tmp, data + i * el_sz, el_bytes);
+        size_t j = i;
+        do {
+            memcpy(data + j * el_sz, data + (j - 1) * el_sz, el_bytes);
+            j -= 1;
+        } while (j > 0 && less(tmp, data + (j - 1) * el_sz, word, el_sz));
+        memcpy(data + j * el_sz, tmp, el_bytes);
+    }
+}
+
+// In-place MSD radix sort (American flag sort) of n records el_sz words each
+// starting from the given byte
+template<class ElTy>
+void msd_sort(ElTy *data, size_t n, size_t el_sz, size_t byte, ElTy *tmp) {
+    const size_t nbytes = el_sz * sizeof(ElTy);
+
+    size_t counts[256];
+    while (true) {
+        if (byte == nbytes)
+            return;
+
+        if (n < kInsertionSortThreshold) {
+            insertion_sort(data, n, el_sz, byte, tmp);
+            return;
+        }
+
+        std::fill(counts, counts + 256, 0);
+        for (size_t i = 0; i < n; ++i)
+            counts[digit(data + i * el_sz, byte)] += 1;
+
+        // All the records share the digit (e.g. unused high bits of the
+        // k-mer), proceed to the next one without moving anything
+        if (counts[digit(data, byte)] != n)
+            break;
+
+        byte += 1;
+    }
+
+    size_t heads[256], tails[256];
+    for (size_t b = 0, sum = 0; b < 256; ++b) {
+        heads[b] = sum;
+        sum += counts[b];
+        tails[b] = sum;
+    }
+
+    // Permute the records following the cycles
+    for (unsigned b = 0; b < 256; ++b) {
+        while (heads[b] < tails[b]) {
+            ElTy *el = data + heads[b] * el_sz;
+            unsigned d = digit(el, byte);
+            if (d == b) {
+                heads[b] += 1;
+                continue;
+            }
+
+            memcpy(tmp, el, nbytes);
+            do {
+                ElTy *dst = data + heads[d] * el_sz;
+                heads[d] += 1;
+                std::swap_ranges(tmp, tmp + el_sz, dst);
+                d = digit(tmp, byte);
+            } while (d != b);
+            memcpy(el, tmp, nbytes);
+            heads[b] += 1;
+        }
+    }
+
+    for (size_t b = 0, start = 0; b < 256; start += counts[b], ++b) {
+        if (counts[b] > 1)
+            msd_sort(data + start * el_sz, counts[b], el_sz, byte + 1, tmp);
+    }
+}
+
+template<class It>
+void sort(It begin, It end, std::true_type) {
+    typedef typename std::remove_pointer<decltype(begin.data())>::type ElTy;
+
+    size_t n = (end.data() - begin.data()) / begin.size(), el_sz = begin.size();
+    if (n < 2)
+        return;
+
+    std::vector<ElTy> tmp(el_sz);
+    msd_sort(begin.data(), n, el_sz, 0, tmp.data());
+}
+
+// Records made of non-integral words (e.g. homopolymer runs) are sorted via comparisons
+template<class It>
+void sort(It begin, It end, std::false_type) {
+    typedef typename std::remove_pointer<decltype(begin.data())>::type ElTy;
+
+    libcxx::sort(begin, end, array_less<ElTy>());
+}
+
+}
+
+// Sorts fixed-width records (e.g. packed k-mers) in the order defined by
+// array_less<ElTy>
+template<class It>
+void kmer_radix_sort(It begin, It end) {
+    typedef typename std::remove_pointer<decltype(begin.data())>::type ElTy;
+
+    if (begin == end)
+        return;
+
+    radix_sort_impl::sort(begin, end, std::integral_constant<bool, std::is_unsigned<ElTy>::value>());
+}
+
+template<class Seq>
+void kmer_radix_sort(KMerVector<Seq> &v) {
+    kmer_radix_sort(v.begin(), v.end());
+}
+
+} //adt
@@ -0,0 +1,117 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+namespace adt {
+
+// Monotone priority queue with unsigned integer keys (radix heap): the key of
+// a pushed element must not be less than the key of the last popped one.
+// Elements with equal keys are popped in the order given by Compare, which
+// follows std::priority_queue convention (the greatest element goes first).
+// The buckets keep their memory on clear(), so the heap is cheap to reuse.
+template<typename Key, class T, class Compare = std::less<T>>
+class radix_heap {
+    static_assert(std::is_unsigned<Key>::value, "Radix heap keys must be unsigned");
+
+    static constexpr unsigned BUCKETS = std::numeric_limits<Key>::digits + 1;
+
+    typedef std::pair<Key, T> entry_t;
+
+    struct EntryCompare {
+        Compare cmp;
+
+        bool operator()(const entry_t &a, const entry_t &b) const {
+            return cmp(a.second, b.second);
+        }
+    };
+
+  public:
+    explicit radix_heap(const Compare &cmp = Compare())
+            : cmp_{cmp}, last_(0), size_(0) {}
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    void push(Key key, const T &value) {
+        VERIFY_DEV(key >= last_);
+        unsigned b = bucket(key);
+        buckets_[b].emplace_back(key, value);
+        if (b == 0)
+            std::push_heap(buckets_[0].begin(), buckets_[0].end(), cmp_);
+        size_ += 1;
+    }
+
+    const T &top() {
+        refill();
+        return buckets_[0].front().second;
+    }
+
+    Key top_key() {
+        refill();
+        return last_;
+    }
+
+    void pop() {
+        refill();
+        std::pop_heap(buckets_[0].begin(), buckets_[0].end(), cmp_);
+        buckets_[0].pop_back();
+        size_ -= 1;
+    }
+
+    void clear() {
+        for (auto &b : buckets_)
+            b.clear();
+        last_ = 0;
+        size_ = 0;
+    }
+
+  private:
+    // Elements in the i-th bucket differ from the last popped key in the
+    // (i-1)-th bit and agree in all higher ones, the 0-th bucket holds the
+    // elements with the last popped key
+    unsigned bucket(Key key) const {
+        return key == last_ ? 0 : unsigned(64 - __builtin_clzll(uint64_t(key ^ last_)));
+    }
+
+    void refill() {
+        if (!buckets_[0].empty())
+            return;
+
+        VERIFY_DEV(size_);
+        unsigned i = 1;
+        while (buckets_[i].empty())
+            ++i;
+
+        auto &b = buckets_[i];
+        last_ = std::min_element(b.begin(), b.end(),
+                                 [](const entry_t &x, const entry_t &y) { return x.first < y.first; })->first;
+        // All the elements go to the lower buckets
+        for (auto &e : b)
+            buckets_[bucket(e.first)].push_back(std::move(e));
+        b.clear();
+        std::make_heap(buckets_[0].begin(), buckets_[0].end(), cmp_);
+    }
+
+    EntryCompare cmp_;
+    std::array<std::vector<entry_t>, BUCKETS> buckets_;
+    Key last_;
+    size_t size_;
+};
+
+}
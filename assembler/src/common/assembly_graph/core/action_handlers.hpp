@@ -13,6 +13,7 @@
 
 #include <boost/noncopyable.hpp>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace omnigraph {
@@ -119,6 +120,40 @@ public:
     virtual void HandleSplit(EdgeId /*old_edge*/, EdgeId /*new_edge_1*/,
                              EdgeId /*new_edge_2*/) { }
 
+    /**
+     * Batched events are triggered instead of the ones above when graph events are batched (see
+     * ObservableGraph::BatchEvents). Every batch holds events of the same kind, the events of every
+     * element arrive in the order they happened. Handlers able to apply updates in bulk (e.g. in parallel) should override these,
+     * by default the events are handled one by one.
+     */
+    virtual void HandleAddBatch(const std::vector<VertexId> &vertices) {
+        for (VertexId v : vertices)
+            HandleAdd(v);
+    }
+
+    virtual void HandleAddBatch(const std::vector<EdgeId> &edges) {
+        for (EdgeId e : edges)
+            HandleAdd(e);
+    }
+
+    virtual void HandleDeleteBatch(const std::vector<VertexId> &vertices) {
+        for (VertexId v : vertices)
+            HandleDelete(v);
+    }
+
+    virtual void HandleDeleteBatch(const std::vector<EdgeId> &edges) {
+        for (EdgeId e : edges)
+            HandleDelete(e);
+    }
+
+    /**
+     * @param merges pairs of the old edges and the new edge
+     */
+    virtual void HandleMergeBatch(const std::vector<std::pair<std::vector<EdgeId>, EdgeId>> &merges) {
+        for (const auto &merge : merges)
+            HandleMerge(merge.first, merge.second);
+    }
+
     /**
      * Every thread safe descendant should override this method for correct concurrent graph processing.
      */
@@ -232,6 +267,17 @@ public:
     virtual void ApplySplit(Handler &handler, EdgeId old_edge,
                             EdgeId new_edge_1, EdgeId new_edge2) const = 0;
 
+    virtual void ApplyAddBatch(Handler &handler, const std::vector<VertexId> &vertices) const = 0;
+
+    virtual void ApplyAddBatch(Handler &handler, const std::vector<EdgeId> &edges) const = 0;
+
+    virtual void ApplyDeleteBatch(Handler &handler, const std::vector<VertexId> &vertices) const = 0;
+
+    virtual void ApplyDeleteBatch(Handler &handler, const std::vector<EdgeId> &edges) const = 0;
+
+    virtual void ApplyMergeBatch(Handler &handler,
+                                 const std::vector<std::pair<std::vector<EdgeId>, EdgeId>> &merges) const = 0;
+
     virtual ~HandlerApplier() {
     }
 };
@@ -282,6 +328,27 @@ public:
         handler.HandleSplit(old_edge, new_edge1, new_edge2);
     }
 
+    void ApplyAddBatch(Handler &handler, const std::vector<VertexId> &vertices) const override {
+        handler.HandleAddBatch(vertices);
+    }
+
+    void ApplyAddBatch(Handler &handler, const std::vector<EdgeId> &edges) const override {
+        handler.HandleAddBatch(edges);
+    }
+
+    void ApplyDeleteBatch(Handler &handler, const std::vector<VertexId> &vertices) const override {
+        handler.HandleDeleteBatch(vertices);
+    }
+
+    void ApplyDeleteBatch(Handler &handler, const std::vector<EdgeId> &edges) const override {
+        handler.HandleDeleteBatch(edges);
+    }
+
+    void ApplyMergeBatch(Handler &handler,
+                         const std::vector<std::pair<std::vector<EdgeId>, EdgeId>> &merges) const override {
+        handler.HandleMergeBatch(merges);
+    }
+
 };
 
 /**
@@ -310,6 +377,19 @@ private:
         return rc_path;
     }
 
+    template<class ElementId>
+    std::vector<ElementId> WithConjugates(const std::vector<ElementId> &elements) const {
+        std::vector<ElementId> res;
+        res.reserve(2 * elements.size());
+        for (ElementId el : elements) {
+            res.push_back(el);
+            ElementId rc = graph_.conjugate(el);
+            if (el != rc)
+                res.push_back(rc);
+        }
+        return res;
+    }
+
 public:
     PairedHandlerApplier(Graph &graph)
             : graph_(graph) {
@@ -383,6 +463,35 @@ public:
         }
     }
 
+    void ApplyAddBatch(Handler &handler, const std::vector<VertexId> &vertices) const override {
+        handler.HandleAddBatch(WithConjugates(vertices));
+    }
+
+    void ApplyAddBatch(Handler &handler, const std::vector<EdgeId> &edges) const override {
+        handler.HandleAddBatch(WithConjugates(edges));
+    }
+
+    void ApplyDeleteBatch(Handler &handler, const std::vector<VertexId> &vertices) const override {
+        handler.HandleDeleteBatch(WithConjugates(vertices));
+    }
+
+    void ApplyDeleteBatch(Handler &handler, const std::vector<EdgeId> &edges) const override {
+        handler.HandleDeleteBatch(WithConjugates(edges));
+    }
+
+    void ApplyMergeBatch(Handler &handler,
+                         const std::vector<std::pair<std::vector<EdgeId>, EdgeId>> &merges) const override {
+        std::vector<std::pair<std::vector<EdgeId>, EdgeId>> res;
+        res.reserve(2 * merges.size());
+        for (const auto &merge : merges) {
+            res.push_back(merge);
+            EdgeId rce = graph_.conjugate(merge.second);
+            if (merge.second != rce)
+                res.emplace_back(RCPath(merge.first), rce);
+        }
+        handler.HandleMergeBatch(res);
+    }
+
 private:
     DECL_LOGGER("PairedHandlerApplier")
 };
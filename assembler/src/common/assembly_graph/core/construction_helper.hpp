@@ -80,6 +80,22 @@ public:
         return graph_.AddEdge(data, id, cid);
     }
 
+    // Creates an unlinked edge with the given ids (self-conjugate iff cid == id)
+    // without notifying the handlers. Edges with distinct ids could be
+    // created concurrently provided that the ids are reserved.
+    EdgeId CreateEdge(const EdgeData &data, EdgeId id, EdgeId cid) {
+        EdgeId e = graph_.AddSingleEdge(VertexId(), VertexId(), data, id);
+        if (cid == id) {
+            graph_.edge(e).set_conjugate(e);
+            return e;
+        }
+
+        EdgeId rc = graph_.AddSingleEdge(VertexId(), VertexId(), graph_.master().conjugate(data), cid);
+        graph_.edge(e).set_conjugate(rc);
+        graph_.edge(rc).set_conjugate(e);
+        return e;
+    }
+
     void LinkIncomingEdge(VertexId v, EdgeId e) {
         VERIFY(graph_.EdgeEnd(e) == VertexId());
         graph_.cvertex(v).AddOutgoingEdge(graph_.conjugate(e));
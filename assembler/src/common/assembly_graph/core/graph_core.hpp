@@ -264,6 +264,7 @@ private:
 
         id_iterator id_begin() const { return id_distributor_.begin(); }
         id_iterator id_end() const { return id_distributor_.end(); }
+        std::vector<id_iterator> id_chunks(size_t chunk_cnt) const { return id_distributor_.chunks(chunk_cnt); }
         uint64_t max_id() const { return id_distributor_.max_id(); }
 
         void reserve(size_t sz) {
@@ -448,6 +449,17 @@ public:
     size_t max_eid() const { return estorage_.max_id(); }
     size_t max_vid() const { return vstorage_.max_id(); }
 
+    /**
+     * Splits the vertices into chunk_cnt parts by id ranges.
+     * @return chunk_cnt + 1 iterators, the i-th chunk is [it[i], it[i + 1])
+     */
+    std::vector<VertexIt> vertex_chunks(size_t chunk_cnt) const {
+        std::vector<VertexIt> res;
+        for (auto it : vstorage_.id_chunks(chunk_cnt))
+            res.emplace_back(it);
+        return res;
+    }
+
     template<class Predicate, bool Canonical = false>
     auto begin(Predicate p) const {
         using BasePredicate = typename std::conditional<Canonical, CanonicalVertices, AllVertices>::type;
@@ -649,12 +661,22 @@ protected:
 
     void HiddenDeleteEdge(EdgeId e) {
         TRACE("Hidden delete edge " << e.int_id());
+        HiddenUnlinkEdge(e);
+        HiddenDestroyEdge(e);
+    }
+
+    // Removes the edge from the graph structure, the edge data stays
+    // available until the edge is destroyed
+    void HiddenUnlinkEdge(EdgeId e) {
         EdgeId rcEdge = conjugate(e);
         VertexId rcStart = conjugate(edge(e).end());
         VertexId start = conjugate(edge(rcEdge).end());
         vertex(start).RemoveOutgoingEdge(e);
         vertex(rcStart).RemoveOutgoingEdge(rcEdge);
-        DestroyEdge(e, rcEdge);
+    }
+
+    void HiddenDestroyEdge(EdgeId e) {
+        DestroyEdge(e, conjugate(e));
     }
 
     void HiddenDeletePath(const std::vector<EdgeId>& edgesToDelete,
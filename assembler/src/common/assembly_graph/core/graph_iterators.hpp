@@ -497,30 +497,8 @@ public:
             return {begin(), end()};
         }
 
-        //trying to split vertices into equal chunks, leftovers put into first chunk
-        std::vector<const_vertex_iterator> answer;
-        size_t vertex_cnt = g_.size();
-        size_t chunk_size = vertex_cnt / chunk_cnt;
-        auto it = g_.begin();
-        answer.push_back(it);
-        for (size_t i = 0; i + chunk_cnt * chunk_size < vertex_cnt; ++i) {
-            ++it;
-        }
-        if (chunk_size > 0) {
-            size_t i = 0;
-            do {
-                ++it;
-                if (++i % chunk_size == 0)
-                    answer.push_back(it);
-            } while (it != g_.end());
-
-            VERIFY(i == chunk_cnt * chunk_size);
-        } else {
-            VERIFY(it == g_.end());
-            answer.push_back(it);
-        }
-        VERIFY(answer.back() == g_.end());
-        return answer;
+        //chunks cover equal ranges of vertex ids, so splitting does not walk through the vertices
+        return g_.vertex_chunks(chunk_cnt);
     }
 
     std::vector<VertexRange> Ranges(size_t chunk_num) const {
@@ -1,42 +1,148 @@
 #include "id_distributor.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+
 using namespace omnigraph;
 
+ReclaimingIdDistributor::ReclaimingIdDistributor(uint64_t bias, size_t initial_size)
+        : size_(0), bias_(bias), nsegments_(0),
+          nhints_(size_t(omp_get_max_threads())), hints_(new Hint[nhints_]) {
+    clear_state();
+    resize(initial_size);
+}
+
 uint64_t ReclaimingIdDistributor::next_free(uint64_t n) const {
-    for (size_t i = n; i < free_map_.size(); ++i) {
-        if (free_map_[i])
-            return i;
+    for (size_t w = n / WORD_BITS; w < words(); ++w) {
+        word_t free = ~word(w).load(std::memory_order_relaxed);
+        if (w == n / WORD_BITS)
+            free &= ~(bit(n) - 1);
+        if (free) {
+            uint64_t res = w * WORD_BITS + __builtin_ctzll(free);
+            return std::min<uint64_t>(res, size());
+        }
+    }
+
+    return size();
+}
+
+uint64_t ReclaimingIdDistributor::next_occupied(uint64_t n) const {
+    // Bits past the size are never set
+    for (size_t w = n / WORD_BITS; w < words(); ++w) {
+        word_t occupied = word(w).load(std::memory_order_relaxed);
+        if (w == n / WORD_BITS)
+            occupied &= ~(bit(n) - 1);
+        if (occupied)
+            return w * WORD_BITS + __builtin_ctzll(occupied);
     }
 
-    return free_map_.size();
+    return NPOS;
+}
+
+bool ReclaimingIdDistributor::try_acquire(uint64_t n) {
+    std::atomic<word_t> &w = word(n / WORD_BITS);
+    word_t expected = w.load(std::memory_order_relaxed);
+    while (!(expected & bit(n))) {
+        if (w.compare_exchange_weak(expected, expected | bit(n)))
+            return true;
+    }
+
+    return false;
 }
 
 void ReclaimingIdDistributor::resize(size_t sz) {
-    //fprintf(stderr, "!!!RESIZE!!!! %llu\n", sz);
-    free_map_.resize(sz, true);
+    std::lock_guard<std::mutex> lock(grow_lock_);
+    grow(sz);
+}
+
+void ReclaimingIdDistributor::grow(size_t sz) {
+    size_t nwords = (sz + WORD_BITS - 1) / WORD_BITS;
+    // Segments are only added, the words of the existing ones stay in place
+    for (; (size_t(1) << nsegments_) - 1 < nwords; ++nsegments_) {
+        VERIFY(nsegments_ < MAX_SEGMENTS);
+        size_t len = size_t(1) << nsegments_;
+        segments_[nsegments_].reset(new std::atomic<word_t>[len]);
+        for (size_t w = 0; w < len; ++w)
+            segments_[nsegments_][w].store(0, std::memory_order_relaxed);
+    }
+
+    // Bits past the size are never set
+    size_t old_size = size();
+    for (size_t w = sz / WORD_BITS; w * WORD_BITS < old_size; ++w)
+        word(w).fetch_and(w == sz / WORD_BITS ? bit(sz) - 1 : 0);
+
+    size_.store(sz, std::memory_order_release);
+}
+
+ReclaimingIdDistributor::Hint &ReclaimingIdDistributor::hint() {
+    return hints_[size_t(omp_get_thread_num()) % nhints_];
+}
+
+void ReclaimingIdDistributor::clear_state() {
+    for (size_t i = 0; i < nhints_; ++i)
+        hints_[i].last_allocated.store(NPOS, std::memory_order_relaxed);
 }
 
 uint64_t ReclaimingIdDistributor::allocate(uint64_t offset) {
-    // First hint: see if we could find any spot after last allocated
-    uint64_t hint = last_allocated_ + offset;
-    uint64_t n = next_free(hint);
-    if (n == free_map_.size()) {
-        // No luck, start from the beginning
-        n = next_free();
+    Hint &h = hint();
+    uint64_t last = h.last_allocated.load(std::memory_order_relaxed);
+    if (last == NPOS) {
+        // Threads start from different parts of the range
+        last = size() / nhints_ * size_t(&h - hints_.get());
     }
 
-    // Still no luck, resize
-    if (n == free_map_.size())
-        resize(free_map_.size() * 2);
+    while (true) {
+        size_t sz = size();
+        // First hint: see if we could find any spot after last allocated
+        uint64_t n = next_free(last + offset);
+        bool restarted = false;
+        while (true) {
+            if (n >= sz) {
+                if (restarted)
+                    break;
+
+                // No luck, start from the beginning
+                restarted = true;
+                n = next_free();
+                continue;
+            }
 
-    last_allocated_ = n;
-    free_map_[n] = false;
-    return n + bias_;
+            if (try_acquire(n)) {
+                h.last_allocated.store(n, std::memory_order_relaxed);
+                return n + bias_;
+            }
+
+            // Taken by another thread
+            n = next_free(n + 1);
+        }
+
+        // Still no luck, grow unless another thread already did, and search
+        // in the fresh part
+        {
+            std::lock_guard<std::mutex> lock(grow_lock_);
+            if (size() == sz)
+                grow(std::max(sz * 2, size_t(1)));
+        }
+        last = sz;
+        offset = 0;
+    }
 }
 
 size_t ReclaimingIdDistributor::free() const {
-    size_t res = 0;
-    for (bool flag : free_map_)
-        res += flag;
+    size_t res = size();
+    for (size_t w = 0; w < words(); ++w)
+        res -= __builtin_popcountll(word(w).load(std::memory_order_relaxed));
+    return res;
+}
+
+std::vector<ReclaimingIdDistributor::id_iterator> ReclaimingIdDistributor::chunks(size_t chunk_cnt) const {
+    VERIFY(chunk_cnt > 0);
+    std::vector<id_iterator> res;
+    for (size_t i = 0; i < chunk_cnt; ++i)
+        res.emplace_back(words() * i / chunk_cnt * WORD_BITS, *this);
+    res.push_back(end());
+
     return res;
 }
@@ -9,42 +9,53 @@
 #include "adt/iterator_range.hpp"
 #include <boost/iterator/iterator_facade.hpp>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 
 namespace omnigraph {
 
+/**
+ * Distributes ids reusing the released ones. Occupied ids are marked in the
+ * bitmap of atomic 64-bit words, so acquire(), release() and allocate() might
+ * be called concurrently. Every thread searches for free ids starting from its
+ * own hint, the hints of different threads start in different parts of the
+ * id range. The bitmap grows by segments of doubling size which never move, so
+ * allocate() might grow it when there is no free id left while the other
+ * threads use it. The growth itself is serialized.
+ */
 class ReclaimingIdDistributor {
+    typedef uint64_t word_t;
+    static constexpr unsigned WORD_BITS = 64;
+    static constexpr uint64_t NPOS = -1ULL;
+
   public:
-    ReclaimingIdDistributor(uint64_t bias = 0, size_t initial_size = 1)
-            : last_allocated_(0), bias_(bias) {
-        resize(initial_size);
-    }
+    ReclaimingIdDistributor(uint64_t bias = 0, size_t initial_size = 1);
 
     void resize(size_t sz);
     uint64_t allocate(uint64_t offset = 0);
     size_t free() const;
     size_t size() const {
-        return free_map_.size();
+        return size_.load(std::memory_order_acquire);
     }
     uint64_t max_id() const { return size() + bias_; }
     bool occupied(uint64_t at) const {
-        return !free_map_[at - bias_];
+        at -= bias_;
+        return at < size() && (word(at / WORD_BITS).load(std::memory_order_relaxed) & bit(at));
     }
     void acquire(uint64_t at) {
-        // FIXME: "lock" only single bit
-#pragma omp critical
-        free_map_[at - bias_] = false;
+        at -= bias_;
+        word(at / WORD_BITS).fetch_or(bit(at));
     }
     void release(uint64_t at) {
-        // FIXME: "lock" only single bit
-#pragma omp critical
-        free_map_[at - bias_] = true;
+        at -= bias_;
+        word(at / WORD_BITS).fetch_and(~bit(at));
     }
 
-    void clear_state(void) { last_allocated_ = 0; }
+    void clear_state(void);
 
     class id_iterator : public boost::iterator_facade<id_iterator,
                                                       uint64_t,
@@ -52,33 +63,24 @@ class ReclaimingIdDistributor {
                                                       uint64_t> {
       public:
         id_iterator(uint64_t start,
-                    const std::vector<bool> &map,
-                    uint64_t bias)
-                : map_(map), bias_(bias), cur_(start) {
-            if (cur_ != NPOS && map_.get()[cur_])
-                cur_ = next_occupied(cur_);
+                    const ReclaimingIdDistributor &distributor)
+                : distributor_(&distributor), cur_(start) {
+            if (cur_ != NPOS)
+                cur_ = distributor_->next_occupied(cur_);
         }
 
       private:
         friend class boost::iterator_core_access;
 
         uint64_t dereference() const {
-            return cur_ + bias_;
-        }
-
-        uint64_t next_occupied(uint64_t n) const {
-            for (size_t i = n + 1; i < map_.get().size(); ++i) {
-                if (!map_.get()[i])
-                    return i;
-            }
-            return NPOS;
+            return cur_ + distributor_->bias_;
         }
 
         void increment() {
             if (cur_ == NPOS)
                 return;
 
-            cur_ = next_occupied(cur_);
+            cur_ = distributor_->next_occupied(cur_ + 1);
         }
 
         bool equal(const id_iterator &other) const {
@@ -86,30 +88,67 @@ class ReclaimingIdDistributor {
         }
 
       private:
-        static const uint64_t NPOS = -1ULL;
-        std::reference_wrapper<const std::vector<bool>> map_;
-        uint64_t bias_, cur_;
+        const ReclaimingIdDistributor *distributor_;
+        uint64_t cur_;
     };
 
     id_iterator begin() const {
-        return id_iterator(0, free_map_, bias_);
+        return id_iterator(0, *this);
     }
     id_iterator end() const {
-        return id_iterator(-1ULL, free_map_, bias_);
+        return id_iterator(NPOS, *this);
     }
     adt::iterator_range<id_iterator> ids() const {
         return adt::make_range(begin(), end());
     }
 
+    /**
+     * Splits the id range into chunk_cnt parts of equal length.
+     * @return chunk_cnt + 1 iterators, the i-th chunk is [it[i], it[i + 1])
+     */
+    std::vector<id_iterator> chunks(size_t chunk_cnt) const;
 
   private:
     friend class id_iterator;
 
+    static word_t bit(uint64_t n) {
+        return word_t(1) << (n % WORD_BITS);
+    }
+
+    size_t words() const {
+        return (size() + WORD_BITS - 1) / WORD_BITS;
+    }
+
+    // Segment i holds the words [2^i - 1, 2^(i + 1) - 1)
+    std::atomic<word_t> &word(size_t w) const {
+        unsigned segment = 63 - __builtin_clzll(w + 1);
+        return segments_[segment][w + 1 - (size_t(1) << segment)];
+    }
+
+    void grow(size_t sz);
+
     uint64_t next_free(uint64_t n = 0) const;
+    // Returns NPOS if there are no occupied ids starting from n
+    uint64_t next_occupied(uint64_t n) const;
+    bool try_acquire(uint64_t n);
+
+    // Separate cache lines for the hints of different threads
+    struct Hint {
+        std::atomic<uint64_t> last_allocated;
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    Hint &hint();
+
+    static constexpr unsigned MAX_SEGMENTS = 64;
 
-    uint64_t last_allocated_;
+    std::atomic<size_t> size_;
     uint64_t bias_;
-    std::vector<bool> free_map_;
+    std::unique_ptr<std::atomic<word_t>[]> segments_[MAX_SEGMENTS];
+    size_t nsegments_;
+    std::mutex grow_lock_;
+    size_t nhints_;
+    std::unique_ptr<Hint[]> hints_;
 };
 
 }
@@ -8,11 +8,15 @@
 #pragma once
 
 #include "utils/logger/logger.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "graph_core.hpp"
 #include "graph_iterators.hpp"
 
+#include <utility>
 #include <vector>
 #include <set>
+#include <unordered_map>
+#include <algorithm>
 #include <cstring>
 
 namespace omnigraph {
@@ -40,6 +44,61 @@ private:
    mutable std::vector<Handler*> action_handler_list_;
    std::unique_ptr<const HandlerApplier<VertexId, EdgeId>> applier_;
 
+   enum class EventType {
+       AddVertex, AddEdge, DeleteVertex, DeleteEdge, Merge, Glue, Split
+   };
+
+   struct Event {
+       EventType type;
+       VertexId v;
+       EdgeId e1, e2, e3;
+       // Position of the merged path in EventLog::paths
+       size_t path_begin, path_end;
+   };
+
+   struct EventLog {
+       std::vector<Event> events;
+       std::vector<EdgeId> paths;
+       // Deleted elements are destroyed after the events are delivered
+       std::vector<EdgeId> unlinked_edges;
+       std::vector<VertexId> deleted_vertices;
+   };
+
+   bool batched_;
+   mutable std::vector<EventLog> event_logs_;
+
+   EventLog &event_log() const {
+       size_t tid = size_t(omp_get_thread_num());
+       VERIFY(tid < event_logs_.size());
+       return event_logs_[tid];
+   }
+
+   void LogEvent(EventType type, VertexId v, EdgeId e1 = EdgeId(), EdgeId e2 = EdgeId(), EdgeId e3 = EdgeId()) const {
+       event_log().events.push_back({ type, v, e1, e2, e3, 0, 0 });
+   }
+
+   template<class F>
+   void ForEachHandler(F f) const {
+       for (Handler* handler_ptr : action_handler_list_) {
+           if (handler_ptr->IsAttached())
+               f(*handler_ptr);
+       }
+   }
+
+   template<class F>
+   void ForEachHandlerReversed(F f) const {
+       for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
+           if ((*it)->IsAttached())
+               f(**it);
+       }
+   }
+
+   void DeliverEvents() const;
+
+   void RemoveEdge(EdgeId e);
+
+   void RemoveVertex(VertexId v);
+
 public:
 //todo move to graph core
     typedef ConstructionHelper<DataMaster> HelperT;
@@ -82,6 +141,26 @@ public:
 
     bool VerifyAllDetached();
 
+    /**
+     * Switches to the batched event delivery: events are appended to the log of the calling thread
+     * instead of being delivered. Deleted elements are removed from the graph structure at once, but
+     * stay in the storage (so their ids are not reused and their data is available to handlers) until
+     * the events are delivered. Handlers (e.g. smart iterators) are not synchronized with the graph
+     * until FlushEvents() is called, neither are graph element counts and iterators.
+     */
+    void BatchEvents();
+
+    /**
+     * Delivers the logged events to the handlers and switches back to the usual event delivery.
+     * Events of the same kind are delivered in batches (see ActionHandler::HandleAddBatch and
+     * others), every element sees its events in the order they happened.
+     */
+    void FlushEvents();
+
+    bool events_batched() const {
+        return batched_;
+    }
+
     //smart iterators
     template<typename Priority>
     SmartVertexIterator<ObservableGraph, Priority> SmartVertexBegin(
@@ -110,7 +189,8 @@ public:
     void FireDeletePath(const std::vector<EdgeId>& edges_to_delete, const std::vector<VertexId>& vertices_to_delete) const;
 
     ObservableGraph(const DataMaster& master) :
-            base(master), applier_(new PairedHandlerApplier<ObservableGraph>(*this)) {
+            base(master), applier_(new PairedHandlerApplier<ObservableGraph>(*this)),
+            batched_(false) {
     }
 
     virtual ~ObservableGraph();
@@ -171,7 +251,7 @@ void ObservableGraph<DataMaster>::DeleteVertex(VertexId v) {
     VERIFY(base::IsDeadEnd(v) && base::IsDeadStart(v));
     VERIFY(v != VertexId());
     FireDeleteVertex(v);
-    base::HiddenDeleteVertex(v);
+    RemoveVertex(v);
 }
 
 template<class DataMaster>
@@ -201,7 +281,28 @@ ObservableGraph<DataMaster>::AddEdge(const EdgeData& data, EdgeId id1, EdgeId id
 template<class DataMaster>
 void ObservableGraph<DataMaster>::DeleteEdge(EdgeId e) {
     FireDeleteEdge(e);
-    base::HiddenDeleteEdge(e);
+    RemoveEdge(e);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::RemoveEdge(EdgeId e) {
+    if (!batched_) {
+        base::HiddenDeleteEdge(e);
+        return;
+    }
+
+    base::HiddenUnlinkEdge(e);
+    event_log().unlinked_edges.push_back(e);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::RemoveVertex(VertexId v) {
+    if (!batched_) {
+        base::HiddenDeleteVertex(v);
+        return;
+    }
+
+    event_log().deleted_vertices.push_back(v);
 }
 
 template<class DataMaster>
@@ -323,6 +424,11 @@ void ObservableGraph<DataMaster>::FireGameOver() const {
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireAddVertex(VertexId v) const {
+    if (batched_) {
+        LogEvent(EventType::AddVertex, v);
+        return;
+    }
+
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             TRACE("FireAddVertex to handler " << handler_ptr->name());
@@ -333,6 +439,11 @@ void ObservableGraph<DataMaster>::FireAddVertex(VertexId v) const {
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireAddEdge(EdgeId e) const {
+    if (batched_) {
+        LogEvent(EventType::AddEdge, VertexId(), e);
+        return;
+    }
+
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             TRACE("FireAddEdge to handler " << handler_ptr->name());
@@ -343,6 +454,11 @@ void ObservableGraph<DataMaster>::FireAddEdge(EdgeId e) const {
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireDeleteVertex(VertexId v) const {
+    if (batched_) {
+        LogEvent(EventType::DeleteVertex, v);
+        return;
+    }
+
     for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
         if ((*it)->IsAttached()) {
             applier_->ApplyDelete(**it, v);
@@ -352,6 +468,11 @@ void ObservableGraph<DataMaster>::FireDeleteVertex(VertexId v) const {
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireDeleteEdge(EdgeId e) const {
+    if (batched_) {
+        LogEvent(EventType::DeleteEdge, VertexId(), e);
+        return;
+    }
+
     for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
         if ((*it)->IsAttached()) {
             applier_->ApplyDelete(**it, e);
@@ -361,6 +482,14 @@ void ObservableGraph<DataMaster>::FireDeleteEdge(EdgeId e) const {
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) const {
+    if (batched_) {
+        EventLog &log = event_log();
+        log.events.push_back({ EventType::Merge, VertexId(), new_edge, EdgeId(), EdgeId(),
+                               log.paths.size(), log.paths.size() + old_edges.size() });
+        log.paths.insert(log.paths.end(), old_edges.begin(), old_edges.end());
+        return;
+    }
+
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             applier_->ApplyMerge(*handler_ptr, old_edges, new_edge);
@@ -370,6 +499,11 @@ void ObservableGraph<DataMaster>::FireMerge(const std::vector<EdgeId> &old_edges
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) const {
+    if (batched_) {
+        LogEvent(EventType::Glue, VertexId(), new_edge, edge1, edge2);
+        return;
+    }
+
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             applier_->ApplyGlue(*handler_ptr, new_edge, edge1, edge2);
@@ -379,6 +513,11 @@ void ObservableGraph<DataMaster>::FireGlue(EdgeId new_edge, EdgeId edge1, EdgeId
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireSplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) const {
+    if (batched_) {
+        LogEvent(EventType::Split, VertexId(), edge, new_edge1, new_edge2);
+        return;
+    }
+
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             applier_->ApplySplit(*handler_ptr, edge, new_edge1, new_edge2);
@@ -396,6 +535,133 @@ bool ObservableGraph<DataMaster>::VerifyAllDetached() {
     return true;
 }
 
+template<class DataMaster>
+void ObservableGraph<DataMaster>::BatchEvents() {
+    VERIFY(!batched_);
+    event_logs_.resize(size_t(omp_get_max_threads()));
+    batched_ = true;
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::DeliverEvents() const {
+    // Batches follow in rounds, one batch per kind in the order the graph operations fire the events.
+    // Every event goes to the first batch of its kind not preceding the batches of the earlier events
+    // on the same elements (or their conjugates), so the handlers see the events of every element in
+    // the order they happened. Events of unrelated elements are reordered freely.
+    const size_t KINDS = 7;
+    // Position of every EventType in a round
+    const size_t rank[KINDS] = { 5, 6, 4, 3, 0, 1, 2 };
+
+    std::unordered_map<uint64_t, size_t> vertex_slots, edge_slots;
+    auto vertex_key = [&](VertexId v) { return std::min(v.int_id(), this->conjugate(v).int_id()); };
+    auto edge_key = [&](EdgeId e) { return std::min(e.int_id(), this->conjugate(e).int_id()); };
+
+    std::vector<std::vector<std::pair<const EventLog*, const Event*>>> slots;
+    std::vector<EdgeId> touched;
+    for (const auto &log : event_logs_) {
+        for (const auto &event : log.events) {
+            touched.clear();
+            for (EdgeId e : { event.e1, event.e2, event.e3 }) {
+                if (e)
+                    touched.push_back(e);
+            }
+            touched.insert(touched.end(), log.paths.begin() + event.path_begin, log.paths.begin() + event.path_end);
+
+            size_t dep = 0;
+            if (event.v) {
+                auto it = vertex_slots.find(vertex_key(event.v));
+                if (it != vertex_slots.end())
+                    dep = it->second;
+            }
+            for (EdgeId e : touched) {
+                auto it = edge_slots.find(edge_key(e));
+                if (it != edge_slots.end())
+                    dep = std::max(dep, it->second);
+            }
+
+            size_t slot = dep - dep % KINDS + rank[size_t(event.type)];
+            if (slot < dep)
+                slot += KINDS;
+
+            if (event.v)
+                vertex_slots[vertex_key(event.v)] = slot;
+            for (EdgeId e : touched)
+                edge_slots[edge_key(e)] = slot;
+
+            if (slots.size() <= slot)
+                slots.resize(slot + 1);
+            slots[slot].emplace_back(&log, &event);
+        }
+    }
+
+    std::vector<VertexId> vertices;
+    std::vector<EdgeId> edges;
+    std::vector<std::pair<std::vector<EdgeId>, EdgeId>> merges;
+    for (const auto &batch : slots) {
+        if (batch.empty())
+            continue;
+        EventType type = batch.front().second->type;
+        TRACE("Delivering batch of " << batch.size() << " events");
+
+        vertices.clear();
+        edges.clear();
+        merges.clear();
+        switch (type) {
+            case EventType::AddVertex:
+            case EventType::DeleteVertex:
+                for (const auto &entry : batch)
+                    vertices.push_back(entry.second->v);
+                if (type == EventType::AddVertex)
+                    ForEachHandler([&](Handler &h) { applier_->ApplyAddBatch(h, vertices); });
+                else
+                    ForEachHandlerReversed([&](Handler &h) { applier_->ApplyDeleteBatch(h, vertices); });
+                break;
+            case EventType::AddEdge:
+            case EventType::DeleteEdge:
+                for (const auto &entry : batch)
+                    edges.push_back(entry.second->e1);
+                if (type == EventType::AddEdge)
+                    ForEachHandler([&](Handler &h) { applier_->ApplyAddBatch(h, edges); });
+                else
+                    ForEachHandlerReversed([&](Handler &h) { applier_->ApplyDeleteBatch(h, edges); });
+                break;
+            case EventType::Merge:
+                for (const auto &entry : batch) {
+                    const auto &paths = entry.first->paths;
+                    const Event &event = *entry.second;
+                    merges.emplace_back(std::vector<EdgeId>(paths.begin() + event.path_begin,
+                                                            paths.begin() + event.path_end),
+                                        event.e1);
+                }
+                ForEachHandler([&](Handler &h) { applier_->ApplyMergeBatch(h, merges); });
+                break;
+            case EventType::Glue:
+                for (const auto &entry : batch)
+                    FireGlue(entry.second->e1, entry.second->e2, entry.second->e3);
+                break;
+            case EventType::Split:
+                for (const auto &entry : batch)
+                    FireSplit(entry.second->e1, entry.second->e2, entry.second->e3);
+                break;
+        }
+    }
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FlushEvents() {
+    VERIFY(batched_);
+    batched_ = false;
+    DeliverEvents();
+
+    for (auto &log : event_logs_) {
+        for (EdgeId e : log.unlinked_edges)
+            base::HiddenDestroyEdge(e);
+        for (VertexId v : log.deleted_vertices)
+            base::HiddenDeleteVertex(v);
+        log = EventLog();
+    }
+}
+
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireDeletePath(const std::vector<EdgeId> &edgesToDelete,
                                                  const std::vector<VertexId> &verticesToDelete) const {
@@ -413,6 +679,8 @@ void ObservableGraph<DataMaster>::clear() {
 
 template<class DataMaster>
 ObservableGraph<DataMaster>::~ObservableGraph<DataMaster>() {
+    if (batched_)
+        FlushEvents();
     FireGameOver();
     clear();
 }
@@ -467,7 +735,10 @@ typename ObservableGraph<DataMaster>::EdgeId
     auto vertices_to_delete = VerticesToDelete(corrected_path);
     FireDeletePath(edges_to_delete, vertices_to_delete);
     FireAddEdge(new_edge);
-    base::HiddenDeletePath(edges_to_delete, vertices_to_delete);
+    for (EdgeId e : edges_to_delete)
+        RemoveEdge(e);
+    for (VertexId v : vertices_to_delete)
+        RemoveVertex(v);
     return new_edge;
 }
 
@@ -487,7 +758,7 @@ std::pair<typename ObservableGraph<DataMaster>::EdgeId, typename ObservableGraph
     FireAddVertex(splitVertex);
     FireAddEdge(new_edge1);
     FireAddEdge(new_edge2);
-    base::HiddenDeleteEdge(edge);
+    RemoveEdge(edge);
     return {new_edge1, new_edge2};
 }
 
@@ -500,8 +771,8 @@ typename ObservableGraph<DataMaster>::EdgeId ObservableGraph<DataMaster>::GlueEd
     FireAddEdge(new_edge);
     VertexId start = base::EdgeStart(edge1);
     VertexId end = base::EdgeEnd(edge1);
-    base::HiddenDeleteEdge(edge1);
-    base::HiddenDeleteEdge(edge2);
+    RemoveEdge(edge1);
+    RemoveEdge(edge2);
 
     if (base::IsDeadStart(start) && base::IsDeadEnd(start)) {
         DeleteVertex(start);
@@ -8,12 +8,15 @@
 
 #include "dijkstra_settings.hpp"
 
+#include "adt/radix_heap.hpp"
 #include "utils/stl_utils.hpp"
 #include "utils/logger/logger.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <parallel_hashmap/phmap.h>
 
 #include <queue>
+#include <type_traits>
 #include <vector>
 
 namespace omnigraph {
@@ -51,6 +54,158 @@ public:
     }
 };
 
+// Queue of Dijkstra run: a radix heap for integer distances, binary heap otherwise.
+// Elements with equal distances are popped in the same order by both.
+template<class Element, typename distance_t, bool = std::is_integral<distance_t>::value>
+class DijkstraQueue : public std::priority_queue<Element, std::vector<Element>,
+                                                 ReverseDistanceComparator<Element>> {
+public:
+    void clear() { this->c.clear(); }
+};
+
+template<class Element, typename distance_t>
+class DijkstraQueue<Element, distance_t, true> {
+    adt::radix_heap<typename std::make_unsigned<distance_t>::type,
+                    Element, ReverseDistanceComparator<Element>> heap_;
+
+public:
+    bool empty() const { return heap_.empty(); }
+    void push(const Element &e) { heap_.push(e.distance, e); }
+    const Element &top() { return heap_.top(); }
+    void pop() { heap_.pop(); }
+    void clear() { heap_.clear(); }
+};
+
+// Reusable state of Dijkstra runs. Per-vertex data is kept in dense arrays
+// indexed by vertex int_id, an entry is valid only if it is stamped with the
+// generation of the current run, so the workspace is reset in O(1). Only one
+// run could use the workspace at a time, the results of the previous run are
+// invalidated on reset.
+template<class Graph, typename distance_t = size_t>
+class DijkstraWorkspace {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef element_t<Graph, distance_t> queue_element;
+
+    enum : uint8_t { COUNTED = 1, PROCESSED = 2, TRACED = 4 };
+
+    struct Entry {
+        uint32_t generation = 0;
+        uint8_t state = 0;
+        distance_t distance = 0;
+    };
+
+public:
+    typedef DijkstraQueue<queue_element, distance_t> queue_t;
+
+    DijkstraWorkspace()
+            : generation_(0) {}
+
+    DijkstraWorkspace(const DijkstraWorkspace&) = delete;
+    DijkstraWorkspace& operator=(const DijkstraWorkspace&) = delete;
+
+    uint32_t Reset() {
+        if (++generation_ == 0) {
+            for (Entry &e : entries_)
+                e.generation = 0;
+            generation_ = 1;
+        }
+        reached_.clear();
+        processed_.clear();
+        queue_.clear();
+        return generation_;
+    }
+
+    uint32_t generation() const { return generation_; }
+
+    bool counted(size_t id) const {
+        return valid(id) && (entries_[id].state & COUNTED);
+    }
+
+    distance_t distance(size_t id) const {
+        return entries_[id].distance;
+    }
+
+    void set_distance(size_t id, VertexId v, distance_t distance) {
+        Entry &e = touch(id);
+        e.state |= COUNTED;
+        e.distance = distance;
+        reached_.push_back(v);
+    }
+
+    bool processed(size_t id) const {
+        return valid(id) && (entries_[id].state & PROCESSED);
+    }
+
+    void set_processed(size_t id, VertexId v) {
+        touch(id).state |= PROCESSED;
+        processed_.push_back(v);
+    }
+
+    bool traced(size_t id) const {
+        return valid(id) && (entries_[id].state & TRACED);
+    }
+
+    const std::pair<VertexId, EdgeId> &prev(size_t id) const {
+        return prev_[id];
+    }
+
+    void set_prev(size_t id, VertexId v, EdgeId e) {
+        touch(id).state |= TRACED;
+        if (prev_.size() < entries_.size())
+            prev_.resize(entries_.size());
+        prev_[id] = { v, e };
+    }
+
+    const std::vector<VertexId> &reached() const { return reached_; }
+    const std::vector<VertexId> &processed() const { return processed_; }
+
+    queue_t &queue() { return queue_; }
+
+private:
+    bool valid(size_t id) const {
+        return id < entries_.size() && entries_[id].generation == generation_;
+    }
+
+    Entry &touch(size_t id) {
+        if (id >= entries_.size())
+            entries_.resize(std::max(id + 1, 2 * entries_.size()));
+        Entry &e = entries_[id];
+        if (e.generation != generation_) {
+            e.generation = generation_;
+            e.state = 0;
+        }
+        return e;
+    }
+
+    uint32_t generation_;
+    std::vector<Entry> entries_;
+    std::vector<std::pair<VertexId, EdgeId>> prev_;
+    std::vector<VertexId> reached_;
+    std::vector<VertexId> processed_;
+    queue_t queue_;
+};
+
+// Workspaces of the threads of parallel regions. They are owned by the object
+// running the searches, so their memory is released together with it, and
+// searches of different kinds do not share (and grow) the same workspaces.
+template<class Workspace>
+class ThreadWorkspaces {
+public:
+    ThreadWorkspaces()
+            : workspaces_(omp_get_max_threads()) {}
+
+    // Workspace of the calling thread, nullptr for the threads beyond the
+    // number known at construction (the searches then go without workspace)
+    Workspace *local() {
+        size_t thread = omp_get_thread_num();
+        return thread < workspaces_.size() ? &workspaces_[thread] : nullptr;
+    }
+
+private:
+    std::vector<Workspace> workspaces_;
+};
+
 template<class Graph, class DijkstraSettings, typename distance_t = size_t>
 class Dijkstra {
     typedef typename Graph::VertexId VertexId;
@@ -60,19 +215,25 @@ class Dijkstra {
 
     typedef phmap::flat_hash_map<VertexId, distance_t> distances_map;
     typedef typename distances_map::const_iterator distances_map_ci;
-    typedef typename std::priority_queue<queue_element,
-                                         std::vector<queue_element>,
-                                         ReverseDistanceComparator<queue_element>> queue_t;
+    typedef DijkstraQueue<queue_element, distance_t> queue_t;
+
+public:
+    typedef DijkstraWorkspace<Graph, distance_t> Workspace;
+
+private:
     // constructor parameters
     const Graph& graph_;
     DijkstraSettings settings_;
     const size_t max_vertex_number_;
     bool collect_traceback_;
+    // If set, the results are stored in the workspace instead of the hash maps below
+    Workspace *workspace_;
 
     // changeable parameters
     bool finished_;
     size_t vertex_number_;
     bool vertex_limit_exceeded_;
+    uint32_t generation_;
 
     // accumulative structures
     distances_map distances_;
@@ -81,14 +242,18 @@ class Dijkstra {
 
     void Init(VertexId start, queue_t &queue) {
         vertex_number_ = 0;
-        distances_.clear();
-        processed_vertices_.clear();
-        prev_vert_map_.clear();
+        if (workspace_) {
+            generation_ = workspace_->Reset();
+        } else {
+            distances_.clear();
+            processed_vertices_.clear();
+            prev_vert_map_.clear();
+        }
         set_finished(false);
         settings_.Init(start);
         queue.push(queue_element(0, start, VertexId(), EdgeId()));
         if (collect_traceback_)
-            prev_vert_map_[start] = std::pair<VertexId, EdgeId>(VertexId(), EdgeId());
+            SetPrev(start, VertexId(), EdgeId());
     }
 
     void set_finished(bool state) {
@@ -112,12 +277,50 @@ class Dijkstra {
         return settings_.GetLength(edge);
     }
 
+    bool Counted(VertexId vertex) const {
+        return workspace_ ? workspace_->counted(graph_.int_id(vertex)) : distances_.count(vertex);
+    }
+
+    void SetDistance(VertexId vertex, distance_t distance) {
+        if (workspace_)
+            workspace_->set_distance(graph_.int_id(vertex), vertex, distance);
+        else
+            distances_.emplace(vertex, distance);
+    }
+
+    void SetProcessed(VertexId vertex) {
+        if (workspace_)
+            workspace_->set_processed(graph_.int_id(vertex), vertex);
+        else
+            processed_vertices_.insert(vertex);
+    }
+
+    void SetPrev(VertexId vertex, VertexId prev, EdgeId edge) {
+        if (workspace_)
+            workspace_->set_prev(graph_.int_id(vertex), prev, edge);
+        else
+            prev_vert_map_[vertex] = std::pair<VertexId, EdgeId>(prev, edge);
+    }
+
+    bool HasPrev(VertexId vertex) const {
+        return workspace_ ? workspace_->traced(graph_.int_id(vertex)) : prev_vert_map_.count(vertex);
+    }
+
+    const std::pair<VertexId, EdgeId> &GetPrev(VertexId vertex) const {
+        return workspace_ ? workspace_->prev(graph_.int_id(vertex)) : utils::get(prev_vert_map_, vertex);
+    }
+
+    void CheckWorkspace() const {
+        VERIFY_MSG(!workspace_ || workspace_->generation() == generation_,
+                   "Dijkstra workspace was reused by another run");
+    }
+
     void AddNeighboursToQueue(VertexId cur_vertex, distance_t cur_dist, queue_t& queue) {
         auto neigh_iterator = settings_.GetIterator(cur_vertex);
         while (neigh_iterator.HasNext()) {
             // TRACE("Checking new neighbour of vertex " << graph_.str(cur_vertex) << " started");
             auto cur_pair = neigh_iterator.Next();
-            if (!DistanceCounted(cur_pair.vertex)) {
+            if (!Counted(cur_pair.vertex)) {
                 // TRACE("Adding new entry to queue");
                 distance_t new_dist = GetLength(cur_pair.edge) + cur_dist;
                 // TRACE("Entry: vertex " << graph_.str(cur_vertex) << " distance " << new_dist);
@@ -131,17 +334,56 @@ class Dijkstra {
         // TRACE("All neighbours of vertex " << graph_.str(cur_vertex) << " processed");
     }
 
+    void Run(VertexId start, queue_t &queue) {
+        Init(start, queue);
+        TRACE("Priority queue initialized. Starting search");
+
+        while (!queue.empty() && !finished()) {
+            // TRACE("Dijkstra iteration started");
+            const auto& next = queue.top();
+            distance_t distance = next.distance;
+            VertexId vertex = next.curr_vertex;
+
+            if (collect_traceback_)
+                SetPrev(vertex, next.prev_vertex, next.edge_between);
+            queue.pop();
+            // TRACE("Vertex " << graph_.str(vertex) << " with distance " << distance << " fetched from queue");
+
+            if (Counted(vertex)) {
+                // TRACE("Distance to vertex " << graph_.str(vertex) << " already counted. Proceeding to next queue entry.");
+                continue;
+            }
+            SetDistance(vertex, distance);
+
+            // TRACE("Vertex " << graph_.str(vertex) << " is found to be at distance "
+            //       << distance << " from vertex " << graph_.str(start));
+            if (!CheckProcessVertex(vertex, distance)) {
+                // TRACE("Check for processing vertex failed. Proceeding to the next queue entry.");
+                continue;
+            }
+            SetProcessed(vertex);
+            AddNeighboursToQueue(vertex, distance, queue);
+        }
+        set_finished(true);
+        // TRACE("Finished dijkstra run from vertex " << graph_.str(start));
+    }
+
 public:
+    // Bounded searches repeated many times should pass a workspace (e.g. one
+    // of ThreadWorkspaces) to avoid allocating and hashing on every run
     Dijkstra(const Graph &graph, DijkstraSettings settings,
              size_t max_vertex_number = size_t(-1),
-             bool collect_traceback = false)
+             bool collect_traceback = false,
+             Workspace *workspace = nullptr)
             : graph_(graph),
               settings_(settings),
               max_vertex_number_(max_vertex_number),
               collect_traceback_(collect_traceback),
+              workspace_(workspace),
               finished_(false),
               vertex_number_(0),
-              vertex_limit_exceeded_(false) {}
+              vertex_limit_exceeded_(false),
+              generation_(0) {}
 
     Dijkstra(Dijkstra&& /*other*/) = default;
     Dijkstra& operator=(Dijkstra&& /*other*/) = default;
@@ -154,10 +396,16 @@ public:
     }
 
     bool DistanceCounted(VertexId vertex) const {
-        return distances_.count(vertex);
+        CheckWorkspace();
+        return Counted(vertex);
     }
 
     distance_t GetDistance(VertexId vertex) const {
+        CheckWorkspace();
+        if (workspace_) {
+            VERIFY(workspace_->counted(graph_.int_id(vertex)));
+            return workspace_->distance(graph_.int_id(vertex));
+        }
         auto it = distances_.find(vertex);
         VERIFY(it != distances_.end());
         return it->second;
@@ -165,49 +413,24 @@ public:
 
     void Run(VertexId start) {
         TRACE("Starting dijkstra run from vertex " << graph_.str(start));
-        queue_t queue;
-        Init(start, queue);
-        TRACE("Priority queue initialized. Starting search");
-
-        while (!queue.empty() && !finished()) {
-            // TRACE("Dijkstra iteration started");
-            const auto& next = queue.top();
-            distance_t distance = next.distance;
-            VertexId vertex = next.curr_vertex;
-
-            if (collect_traceback_)
-                prev_vert_map_[vertex] = std::pair<VertexId, EdgeId>(next.prev_vertex, next.edge_between);
-            queue.pop();
-            // TRACE("Vertex " << graph_.str(vertex) << " with distance " << distance << " fetched from queue");
-
-            if (DistanceCounted(vertex)) {
-                // TRACE("Distance to vertex " << graph_.str(vertex) << " already counted. Proceeding to next queue entry.");
-                continue;
-            }
-            distances_.emplace(vertex, distance);
-
-            // TRACE("Vertex " << graph_.str(vertex) << " is found to be at distance "
-            //       << distance << " from vertex " << graph_.str(start));
-            if (!CheckProcessVertex(vertex, distance)) {
-                // TRACE("Check for processing vertex failed. Proceeding to the next queue entry.");
-                continue;
-            }
-            processed_vertices_.insert(vertex);
-            AddNeighboursToQueue(vertex, distance, queue);
+        if (workspace_) {
+            Run(start, workspace_->queue());
+        } else {
+            queue_t queue;
+            Run(start, queue);
         }
-        set_finished(true);
-        // TRACE("Finished dijkstra run from vertex " << graph_.str(start));
     }
 
     std::vector<EdgeId> GetShortestPathTo(VertexId vertex) {
         VERIFY_MSG(collect_traceback_, "GetShortestPathTo() is available only if traceback is collected");
+        CheckWorkspace();
         std::vector<EdgeId> path;
-        if (prev_vert_map_.find(vertex) == prev_vert_map_.end())
+        if (!HasPrev(vertex))
             return path;
 
         VertexId curr_vertex = vertex;
-        VertexId prev_vertex = utils::get(prev_vert_map_, vertex).first;
-        EdgeId edge = utils::get(prev_vert_map_, curr_vertex).second;
+        VertexId prev_vertex = GetPrev(vertex).first;
+        EdgeId edge = GetPrev(curr_vertex).second;
 
         while (prev_vertex != VertexId()) {
             if (graph_.EdgeStart(edge) == prev_vertex)
@@ -215,7 +438,7 @@ public:
             else
                 path.push_back(edge);
             curr_vertex = prev_vertex;
-            const auto& prev_v_e = utils::get(prev_vert_map_, curr_vertex);
+            const auto& prev_v_e = GetPrev(curr_vertex);
             prev_vertex = prev_v_e.first;
             edge = prev_v_e.second;
         }
@@ -223,18 +446,30 @@ public:
     }
 
     std::vector<VertexId> ReachedVertices() const {
+        CheckWorkspace();
         std::vector<VertexId> result;
-        result.reserve(distances_.size());
-
-        for (const auto &el : distances_)
-            result.push_back(el.first);
+        if (workspace_) {
+            result = workspace_->reached();
+        } else {
+            result.reserve(distances_.size());
+            for (const auto &el : distances_)
+                result.push_back(el.first);
+        }
         std::sort(result.begin(), result.end());
 
         return result;
     }
 
-    const auto& ProcessedVertices() const {
-        return processed_vertices_;
+    bool VertexProcessed(VertexId vertex) const {
+        CheckWorkspace();
+        return workspace_ ? workspace_->processed(graph_.int_id(vertex)) : processed_vertices_.count(vertex);
+    }
+
+    std::vector<VertexId> ProcessedVertices() const {
+        CheckWorkspace();
+        if (workspace_)
+            return workspace_->processed();
+        return std::vector<VertexId>(processed_vertices_.begin(), processed_vertices_.end());
     }
 
     bool VertexLimitExceeded() const {
@@ -42,7 +42,8 @@ public:
 
     static BoundedDijkstra CreateBoundedDijkstra(const Graph &graph, size_t length_bound,
                                                  size_t max_vertex_number = -1ul,
-                                                 bool collect_traceback = false) {
+                                                 bool collect_traceback = false,
+                                                 typename BoundedDijkstra::Workspace *workspace = nullptr) {
         return BoundedDijkstra(graph,
                                BoundedDijkstraSettings(
                                    LengthCalculator<Graph>(graph),
@@ -50,7 +51,8 @@ public:
                                    BoundPutChecker<Graph>(length_bound),
                                    ForwardNeighbourIteratorFactory<Graph>(graph)),
                                max_vertex_number,
-                               collect_traceback);
+                               collect_traceback,
+                               workspace);
     }
 
     //------------------------------
@@ -69,7 +71,8 @@ public:
     CreateBackwardBoundedDijkstra(const Graph &graph,
                                   size_t bound,
                                   size_t max_vertex_number = size_t(-1),
-                                  bool collect_traceback = false) {
+                                  bool collect_traceback = false,
+                                  typename BackwardBoundedDijkstra::Workspace *workspace = nullptr) {
         return BackwardBoundedDijkstra(graph,
                                        BackwardBoundedDijkstraSettings(
                                            LengthCalculator<Graph>(graph),
@@ -77,7 +80,8 @@ public:
                                            BoundPutChecker<Graph>(bound),
                                            BackwardNeighbourIteratorFactory<Graph>(graph)),
                                        max_vertex_number,
-                                       collect_traceback);
+                                       collect_traceback,
+                                       workspace);
     }
 
     //------------------------------
@@ -315,10 +315,29 @@ public:
 
 };
 
+/**
+ * Collects the vertices the removal condition of the edge depends on and the
+ * vertices changed by the removal (with the following compression): the ends
+ * of the edge and the far ends of all the edges adjacent to it.
+ */
+template<class Graph>
+void EdgeRemovalNeighbourhood(const Graph &g, typename Graph::EdgeId e,
+                              std::vector<typename Graph::VertexId> &vertices) {
+    for (auto v : { g.EdgeStart(e), g.EdgeEnd(e) }) {
+        vertices.push_back(v);
+        for (auto adj : g.IncomingEdges(v))
+            vertices.push_back(g.EdgeStart(adj));
+        for (auto adj : g.OutgoingEdges(v))
+            vertices.push_back(g.EdgeEnd(adj));
+    }
+}
+
 //FIXME only potentially relevant edges should be stored at any point
 template<class Graph, class ElementId,
          class Priority = adt::identity>
 class PersistentProcessingAlgorithm : public PersistentAlgorithmBase<Graph> {
+    typedef typename Graph::VertexId VertexId;
+
 protected:
     typedef std::shared_ptr<InterestingElementFinder<Graph, ElementId>> CandidateFinderPtr;
     CandidateFinderPtr interest_el_finder_;
@@ -326,6 +345,13 @@ protected:
 private:
     SmartSetIterator<Graph, ElementId, Priority> it_;
     const bool tracking_;
+    size_t batch_size_;
+
+    // Vertex int_id -> the vertex belongs to the neighbourhood of some element
+    // of the current batch. Only the claimed ids are reset after the batch.
+    std::vector<bool> claimed_;
+    std::vector<size_t> claimed_ids_;
+    std::vector<VertexId> neighbourhood_;
 
 protected:
     void ReturnForConsideration(ElementId el) {
@@ -336,7 +362,41 @@ protected:
     virtual bool Proceed(ElementId /*el*/) const { return true; }
     virtual void PrepareIteration(double /*iter_run_progress*/ = 1.) {}
 
+    /**
+     * Batched processing splits Process into the read-only Check, which is
+     * run concurrently, and Apply, which modifies the graph.
+     */
+    virtual bool Check(ElementId /*el*/) const {
+        VERIFY_MSG(false, "Batched processing is not supported");
+        return false;
+    }
+
+    virtual void Apply(ElementId /*el*/) {
+        VERIFY_MSG(false, "Batched processing is not supported");
+    }
+
+    /**
+     * Collects the vertices Check depends on and Apply changes. Elements with
+     * intersecting neighbourhoods never get into the same batch.
+     */
+    virtual void Neighbourhood(ElementId /*el*/, std::vector<VertexId> &/*vertices*/) const {
+        VERIFY_MSG(false, "Batched processing is not supported");
+    }
+
 public:
+    static constexpr size_t DEFAULT_BATCH_SIZE = 4096;
+
+    /**
+     * Switches the algorithm to the batched processing. Elements are taken
+     * in the order of priority and collected into a batch while their
+     * neighbourhoods are disjoint, the conflicting ones are postponed to the
+     * next batches. Check is run on the whole batch in parallel, then the
+     * elements passed the check are applied in the same order they were
+     * taken, so the result does not depend on the number of threads.
+     */
+    void ProcessInBatches(size_t batch_size = DEFAULT_BATCH_SIZE) {
+        batch_size_ = batch_size;
+    }
 
     PersistentProcessingAlgorithm(Graph& g,
                                   CandidateFinderPtr interest_el_finder,
@@ -346,7 +406,8 @@ public:
             PersistentAlgorithmBase<Graph>(g),
             interest_el_finder_(interest_el_finder),
             it_(g, true, priority, canonical_only),
-            tracking_(track_changes) {
+            tracking_(track_changes),
+            batch_size_(0) {
         it_.Detach();
     }
 
@@ -372,8 +433,18 @@ public:
         //PrepareIteration(std::min(curr_iteration_, total_iteration_estimate_ - 1), total_iteration_estimate_);
         PrepareIteration(iter_run_progress);
 
-        size_t triggered = 0;
         TRACE("Start processing");
+        size_t triggered = batch_size_ ? ProcessBatches() : ProcessSequentially();
+        TRACE("Finished processing. Triggered = " << triggered);
+        if (!tracking_)
+            it_.Detach();
+
+        return triggered;
+    }
+
+private:
+    size_t ProcessSequentially() {
+        size_t triggered = 0;
         for (; !it_.IsEnd(); ++it_) {
             ElementId el = *it_;
             if (!Proceed(el)) {
@@ -385,14 +456,92 @@ public:
             if (Process(el))
                 triggered++;
         }
-        TRACE("Finished processing. Triggered = " << triggered);
-        if (!tracking_)
-            it_.Detach();
+        return triggered;
+    }
+
+    // The neighbourhood is claimed even if the element is postponed, so the
+    // later elements intersecting it are postponed as well and never get
+    // applied ahead of it
+    bool Claim(ElementId el) {
+        neighbourhood_.clear();
+        Neighbourhood(el, neighbourhood_);
+        bool free = true;
+        for (VertexId v : neighbourhood_) {
+            if (claimed_[v.int_id()] || claimed_[this->g().conjugate(v).int_id()])
+                free = false;
+        }
+        for (VertexId v : neighbourhood_) {
+            for (size_t id : { v.int_id(), this->g().conjugate(v).int_id() }) {
+                if (!claimed_[id]) {
+                    claimed_[id] = true;
+                    claimed_ids_.push_back(id);
+                }
+            }
+        }
+        return free;
+    }
+
+    void ReleaseClaimed() {
+        for (size_t id : claimed_ids_)
+            claimed_[id] = false;
+        claimed_ids_.clear();
+    }
+
+    size_t ProcessBatches() {
+        size_t triggered = 0;
+        std::vector<ElementId> batch, postponed;
+        std::vector<char> passed;
+        while (!it_.IsEnd()) {
+            batch.clear();
+            postponed.clear();
+            // Vertices are only added by Apply, so the batch is collected
+            // within the same id range
+            if (claimed_.size() < this->g().max_vid())
+                claimed_.resize(this->g().max_vid(), false);
+            while (!it_.IsEnd() && batch.size() < batch_size_ && postponed.size() < batch_size_) {
+                ElementId el = *it_;
+                if (!Proceed(el)) {
+                    TRACE("Proceed condition turned false on element " << this->g().str(el));
+                    it_.ReleaseCurrent();
+                    break;
+                }
+                ++it_;
+                if (Claim(el))
+                    batch.push_back(el);
+                else
+                    postponed.push_back(el);
+            }
+
+            // Postponed elements are returned before the graph is changed, so
+            // they are dropped from the queue if deleted
+            for (ElementId el : postponed)
+                it_.push(el);
+            ReleaseClaimed();
+            if (batch.empty())
+                break;
 
+            TRACE("Processing batch of " << batch.size() << " elements, "
+                  << postponed.size() << " elements postponed");
+            passed.assign(batch.size(), false);
+            #pragma omp parallel for schedule(guided)
+            for (size_t i = 0; i < batch.size(); ++i)
+                passed[i] = Check(batch[i]);
+
+            // The neighbourhoods are disjoint, so no element of the batch
+            // depends on the events of the others
+            this->g().BatchEvents();
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (!passed[i])
+                    continue;
+                TRACE("Processing element " << this->g().str(batch[i]));
+                Apply(batch[i]);
+                triggered++;
+            }
+            this->g().FlushEvents();
+        }
         return triggered;
     }
 
-private:
     DECL_LOGGER("PersistentProcessingAlgorithm"); 
 };
 
@@ -411,15 +560,27 @@ protected:
 
     bool Process(EdgeId e) override {
         TRACE("Checking edge " << this->g().str(e) << " for the removal condition");
-        if (remove_condition_(e)) {
+        if (Check(e)) {
             TRACE("Check passed, removing");
-            edge_remover_.DeleteEdge(e);
+            Apply(e);
             return true;
         }
         TRACE("Check not passed");
         return false;
     }
 
+    bool Check(EdgeId e) const override {
+        return remove_condition_(e);
+    }
+
+    void Apply(EdgeId e) override {
+        edge_remover_.DeleteEdge(e);
+    }
+
+    void Neighbourhood(EdgeId e, std::vector<typename Graph::VertexId> &vertices) const override {
+        EdgeRemovalNeighbourhood(this->g(), e, vertices);
+    }
+
 public:
     ParallelEdgeRemovingAlgorithm(Graph& g,
                                   func::TypedPredicate<EdgeId> remove_condition,
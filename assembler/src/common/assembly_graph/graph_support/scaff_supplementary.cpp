@@ -8,9 +8,11 @@ using namespace std;
 namespace path_extend {
 
 ScaffoldingUniqueEdgeAnalyzer::ScaffoldingUniqueEdgeAnalyzer(const debruijn_graph::GraphPack &gp,
+                                                             const omnigraph::de::FrozenPairedInfoIndicesT<debruijn_graph::Graph> &clustered_indices,
                                                              size_t apriori_length_cutoff,
                                                              double max_relative_coverage)
         : gp_(gp), graph_(gp.get<debruijn_graph::Graph>())
+        , clustered_indices_(clustered_indices)
         , length_cutoff_(apriori_length_cutoff)
         , relative_coverage_variation_(max_relative_coverage)
 {
@@ -235,8 +237,7 @@ bool ScaffoldingUniqueEdgeAnalyzer::FindCommonChildren(const vector<pair<EdgeId,
 
 bool ScaffoldingUniqueEdgeAnalyzer::FindCommonChildren(EdgeId from, size_t lib_index) const{
     DEBUG("processing unique edge " << graph_.int_id(from));
-    const auto &clustered_indices = gp_.get<omnigraph::de::PairedInfoIndicesT<Graph>>("clustered_indices");
-    auto next_edges = clustered_indices[lib_index].Get(from);
+    auto next_edges = clustered_indices_[lib_index].Get(from);
     vector<pair<EdgeId, double>> next_weights;
     for (auto hist_pair: next_edges) {
         if (hist_pair.first == from || hist_pair.first == graph_.conjugate(from))
@@ -4,6 +4,7 @@
 #include "modules/path_extend/pe_utils.hpp"
 #include "modules/path_extend/pe_config_struct.hpp"
 #include "modules/path_extend/paired_library.hpp"
+#include "paired_info/frozen_paired_info.hpp"
 
 //FIXME: layering violation
 #include "pipeline/graph_pack.hpp"
@@ -45,6 +46,10 @@ public:
         return unique_edges_.end();
     }
 
+    void insert(EdgeId e) {
+        unique_edges_.insert(e);
+    }
+
     auto erase(decltype(unique_edges_.begin()) iter) {
         return unique_edges_.erase(iter);
     }
@@ -78,6 +83,7 @@ protected:
 class ScaffoldingUniqueEdgeAnalyzer {
     const debruijn_graph::GraphPack &gp_;
     const debruijn_graph::Graph &graph_;
+    const omnigraph::de::FrozenPairedInfoIndicesT<debruijn_graph::Graph> &clustered_indices_;
     size_t length_cutoff_;
     double median_coverage_;
     double relative_coverage_variation_;
@@ -103,8 +109,9 @@ protected:
 
     void SetCoverageBasedCutoff();
 public:
-    ScaffoldingUniqueEdgeAnalyzer(const debruijn_graph::GraphPack &gp, size_t apriori_length_cutoff,
-                                  double max_relative_coverage);
+    ScaffoldingUniqueEdgeAnalyzer(const debruijn_graph::GraphPack &gp,
+                                  const omnigraph::de::FrozenPairedInfoIndicesT<debruijn_graph::Graph> &clustered_indices,
+                                  size_t apriori_length_cutoff, double max_relative_coverage);
     void FillUniqueEdgeStorage(ScaffoldingUniqueEdgeStorage &storage);
     void ClearLongEdgesWithPairedLib(size_t lib_index, ScaffoldingUniqueEdgeStorage &storage) const;
     void FillUniqueEdgesWithLongReads(GraphCoverageMap &long_reads_cov_map,
@@ -117,6 +124,15 @@ class UsedUniqueStorage {
     std::unordered_map<size_t, std::unordered_set<EdgeId>> used_by_paths_; // for fast check 'whether the path contains the edge'
     const ScaffoldingUniqueEdgeStorage& unique_;
     const debruijn_graph::ConjugateDeBruijnGraph &g_;
+    // Edges used in the base storage are treated as used, the base is never modified
+    const UsedUniqueStorage *base_;
+    mutable std::unordered_set<EdgeId> base_lookups_;
+
+    const UsedUniqueStorage *Base(EdgeId e) const {
+        if (base_)
+            base_lookups_.insert(e);
+        return base_;
+    }
 
 public:
     UsedUniqueStorage(const UsedUniqueStorage&) = delete;
@@ -127,7 +143,17 @@ public:
     explicit UsedUniqueStorage(const ScaffoldingUniqueEdgeStorage& unique,
                                const debruijn_graph::ConjugateDeBruijnGraph &g)
         : unique_(unique)
-        , g_(g) 
+        , g_(g)
+        , base_(nullptr)
+    {}
+
+    // Storage layered over the base one. The base must not be modified while the
+    // storage is in use, the edges used since then are kept apart (see used()) and
+    // the edges looked up in the base are recorded (see base_lookups())
+    explicit UsedUniqueStorage(const UsedUniqueStorage *base)
+        : unique_(base->unique_)
+        , g_(base->g_)
+        , base_(base)
     {}
 
     void insert(EdgeId e, size_t path_id) {
@@ -142,11 +168,31 @@ public:
 
     bool IsUsed(EdgeId e, size_t path_id) const {
         auto it = used_by_paths_.find(path_id);
-        return it != used_by_paths_.end() && it->second.find(e) != it->second.end();
+        if (it != used_by_paths_.end() && it->second.find(e) != it->second.end())
+            return true;
+        auto base = Base(e);
+        return base && base->IsUsed(e, path_id);
     }
 
     bool IsUsed(EdgeId e) const {
-        return used_.find(e) != used_.end();
+        auto base = Base(e);
+        return used_.find(e) != used_.end() || (base && base->IsUsed(e));
+    }
+
+    // Edges used in this storage, not including the base
+    const std::unordered_set<EdgeId> &used() const {
+        return used_;
+    }
+
+    // Edges looked up in the base storage since the last clear()
+    const std::unordered_set<EdgeId> &base_lookups() const {
+        return base_lookups_;
+    }
+
+    void clear() {
+        used_.clear();
+        used_by_paths_.clear();
+        base_lookups_.clear();
     }
 
     bool IsUsedAndUnique(EdgeId e, size_t path_id) const {
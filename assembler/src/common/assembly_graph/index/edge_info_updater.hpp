@@ -14,6 +14,9 @@
 
 #include "utils/parallel/openmp_wrapper.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace debruijn_graph {
 
 template<typename Graph>
@@ -85,13 +88,44 @@ class EdgeInfoUpdater {
 
     template<class Index>
     void Update(const Graph &g, Index &index, const std::vector<EdgeId> &edges) {
+        ByConjugatePairs(g, edges, [&](EdgeId e) { UpdateKmers(g, e, index); });
+    }
+
+    template<class Index>
+    void Delete(const Graph &g, Index &index, const std::vector<EdgeId> &edges) {
+        ByConjugatePairs(g, edges, [&](EdgeId e) { DeleteKmers(g, e, index); });
+    }
+
+ private:
+    /**
+     * K-mers are stored in the canonical form, so an edge and its conjugate
+     * touch the same index entries, while other edges of the graph share no
+     * (k+1)-mers. Each conjugate pair of the batch is processed by a single
+     * thread, the pairs are processed in parallel.
+     */
+    template<class F>
+    void ByConjugatePairs(const Graph &g, const std::vector<EdgeId> &edges, F f) {
+        std::vector<EdgeId> sorted(edges);
+        std::sort(sorted.begin(), sorted.end());
+        auto in_batch = [&](EdgeId e) { return std::binary_search(sorted.begin(), sorted.end(), e); };
+
+        std::vector<EdgeId> firsts;
+        firsts.reserve(edges.size());
+        for (EdgeId e : edges) {
+            EdgeId rc = g.conjugate(e);
+            if (e <= rc || !in_batch(rc))
+                firsts.push_back(e);
+        }
+
 #pragma omp parallel for schedule(guided)
-        for (size_t i = 0; i < edges.size(); ++i) {
-            UpdateKmers(g, edges[i], index);
+        for (size_t i = 0; i < firsts.size(); ++i) {
+            EdgeId e = firsts[i], rc = g.conjugate(e);
+            f(e);
+            if (rc != e && in_batch(rc))
+                f(rc);
         }
     }
 
- private:
     DECL_LOGGER("EdgeInfoUpdater")
 };
 
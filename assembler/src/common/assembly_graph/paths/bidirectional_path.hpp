@@ -152,6 +152,8 @@ class PathListener {
 public:
     virtual void FrontEdgeAdded(debruijn_graph::EdgeId e, BidirectionalPath &path, const Gap &gap) = 0;
     virtual void BackEdgeAdded(debruijn_graph::EdgeId e, BidirectionalPath &path, const Gap &gap) = 0;
+    // Edges [from, path.Size()) were added to the back at once
+    virtual void BackEdgesAdded(BidirectionalPath &path, size_t from);
     virtual void FrontEdgeRemoved(debruijn_graph::EdgeId e, BidirectionalPath &path) = 0;
     virtual void BackEdgeRemoved(debruijn_graph::EdgeId e, BidirectionalPath &path) = 0;
     virtual ~PathListener() {}
@@ -378,8 +380,12 @@ class BidirectionalPath : public PathListener, public SimpleBidirectionalPath {
 
     const debruijn_graph::Graph& g_;
     BidirectionalPath* conj_path_;
-    // Length from beginning of i-th edge to path end: L(e_i + gap_(i+1) + e_(i+1) + ... + gap_N + e_N)
-    std::deque<size_t> cumulative_len_;
+    // Positions of the edge starts and of the path end relative to an
+    // arbitrary origin, so that both front and back insertions do not touch
+    // the other edges. Length from beginning of i-th edge to path end
+    // L(e_i + gap_(i+1) + e_(i+1) + ... + gap_N + e_N) = end_ - starts_[i]
+    std::deque<int64_t> starts_;
+    int64_t end_;
     adt::SmallPODVector<PathListener*,
                         adt::impl::HybridAllocatedStorage<PathListener*, 2>> listeners_;
     const uint64_t id_;  //Unique ID
@@ -389,6 +395,7 @@ class BidirectionalPath : public PathListener, public SimpleBidirectionalPath {
     BidirectionalPath(const debruijn_graph::Graph& g)
             : g_(g),
               conj_path_(nullptr),
+              end_(0),
               id_(path_id_++),
               weight_(1.0),
               cycle_overlapping_(-1) {}
@@ -401,13 +408,8 @@ class BidirectionalPath : public PathListener, public SimpleBidirectionalPath {
     BidirectionalPath(const debruijn_graph::Graph& g, SimpleBidirectionalPath path)
             : BidirectionalPath(g)  {
         SimpleBidirectionalPath::PushBack(std::move(path));
-        cumulative_len_.resize(Size(), 0);
-
         for (size_t i = 0; i < Size(); ++i)
-            cumulative_len_.front() += g_.length(edges_[i]) + gaps_[i].gap;
-
-        for (size_t i = 1; i < Size(); ++i)
-            cumulative_len_[i] = cumulative_len_[i - 1] - g_.length(edges_[i - 1]) - gaps_[i].gap;
+            IncreaseLengths(g_.length(edges_[i]), gaps_[i].gap);
     }
 
     BidirectionalPath(const debruijn_graph::Graph& g, std::vector<EdgeId> path)
@@ -417,7 +419,8 @@ class BidirectionalPath : public PathListener, public SimpleBidirectionalPath {
             : SimpleBidirectionalPath(path),
               g_(path.g_),
               conj_path_(nullptr),
-              cumulative_len_(path.cumulative_len_),
+              starts_(path.starts_),
+              end_(path.end_),
               listeners_(),
               id_(path_id_++),
               weight_(path.weight_),
@@ -502,6 +505,12 @@ public:
         listeners_.push_back(&listener);
     }
 
+    void Unsubscribe(PathListener &listener) {
+        auto it = std::find(listeners_.begin(), listeners_.end(), &listener);
+        VERIFY(it != listeners_.end());
+        listeners_.erase(it);
+    }
+
     void SetConjPath(BidirectionalPath* path) noexcept {
         conj_path_ = path;
     }
@@ -556,7 +565,7 @@ public:
             return 0;
         }
         VERIFY(gaps_[0].gap == 0);
-        return cumulative_len_[0];
+        return LengthAt(0);
     }
 
     int ShiftLength(size_t index) const {
@@ -565,7 +574,7 @@ public:
 
     // Length from beginning of i-th edge to path end for forward directed path: L(e1 + e2 + ... + eN)
     size_t LengthAt(size_t index) const noexcept {
-        return cumulative_len_[index];
+        return size_t(end_ - starts_[index]);
     }
 
     size_t GetId() const noexcept {
@@ -577,30 +586,30 @@ public:
     }
 
     void PushBack(EdgeId e, Gap gap = Gap()) {
-        VERIFY(!edges_.empty() || gap == Gap());
-        if (IsCycle()) {
-            VERIFY(e == edges_[cycle_overlapping_]);
-            ++cycle_overlapping_;
-        }
-        SimpleBidirectionalPath::PushBack(e, std::move(gap));
-        IncreaseLengths(g_.length(e), gaps_.back().gap);
+        AppendEdge(e, std::move(gap));
         NotifyBackEdgeAdded(e, gaps_.back());
     }
 
+    // Listeners are notified once for the whole path
     void PushBack(const BidirectionalPath& path, Gap gap = Gap()) {
         if (path.Size() > 0) {
             VERIFY(path.GapAt(0) == Gap());
-            PushBack(path.At(0), std::move(gap));
+            VERIFY(&path != this);
+            size_t from = Size();
+            AppendEdge(path.At(0), std::move(gap));
             for (size_t i = 1; i < path.Size(); ++i)
-                PushBack(path.At(i), path.GapAt(i));
+                AppendEdge(path.At(i), path.GapAt(i));
+            NotifyBackEdgesAdded(from);
         }
     }
 
     void PushBack(const std::vector<EdgeId>& path, Gap gap = Gap()) {
         VERIFY(!path.empty());
-        PushBack(path[0], std::move(gap));
+        size_t from = Size();
+        AppendEdge(path[0], std::move(gap));
         for (size_t i = 1; i < path.size(); ++i)
-            PushBack(path[i]);
+            AppendEdge(path[i], Gap());
+        NotifyBackEdgesAdded(from);
     }
 
     void PopBack() {
@@ -634,6 +643,11 @@ public:
         PushFront(g_.conjugate(e), gap.Conjugate());
     }
 
+    void BackEdgesAdded(BidirectionalPath &path, size_t from) override {
+        for (size_t i = from; i < path.Size(); ++i)
+            PushFront(g_.conjugate(path.edges_[i]), path.gaps_[i].Conjugate());
+    }
+
     void FrontEdgeRemoved(EdgeId, BidirectionalPath&) override {
     }
 
@@ -680,20 +694,28 @@ public:
 private:
     std::vector<std::string> PrintLines() const;
 
-    void IncreaseLengths(size_t length, int gap) {
-        for (auto iter = cumulative_len_.begin(); iter != cumulative_len_.end(); ++iter) {
-            *iter += length + gap;
+    // Adds the edge to the back without notifying the listeners
+    void AppendEdge(EdgeId e, Gap gap) {
+        VERIFY(!edges_.empty() || gap == Gap());
+        if (IsCycle()) {
+            VERIFY(e == edges_[cycle_overlapping_]);
+            ++cycle_overlapping_;
         }
-        cumulative_len_.push_back(length);
+        SimpleBidirectionalPath::PushBack(e, std::move(gap));
+        IncreaseLengths(g_.length(e), gaps_.back().gap);
     }
 
-    void DecreaseLengths() {
-        size_t length = g_.length(edges_.back()) + gaps_.back().gap;
+    void IncreaseLengths(size_t length, int gap) {
+        int64_t start = starts_.empty() ? 0 : end_ + gap;
+        starts_.push_back(start);
+        end_ = start + int64_t(length);
+    }
 
-        for (auto iter = cumulative_len_.begin(); iter != cumulative_len_.end(); ++iter) {
-            *iter -= length;
-        }
-        cumulative_len_.pop_back();
+    // Called before the last edge is removed
+    void DecreaseLengths() {
+        starts_.pop_back();
+        if (!starts_.empty())
+            end_ = starts_.back() + int64_t(g_.length(edges_[edges_.size() - 2]));
     }
 
     void NotifyFrontEdgeAdded(EdgeId e, const Gap& gap) {
@@ -708,6 +730,12 @@ private:
         }
     }
 
+    void NotifyBackEdgesAdded(size_t from) {
+        for (auto & listener : listeners_) {
+            listener->BackEdgesAdded(*this, from);
+        }
+    }
+
     void NotifyFrontEdgeRemoved(EdgeId e) {
         for (auto & listener : listeners_) {
             listener->FrontEdgeRemoved(e, *this);
@@ -728,18 +756,19 @@ private:
 
         SimpleBidirectionalPath::PushFront(e, gap);
 
-        int length = (int) g_.length(e);
-        if (cumulative_len_.empty()) {
-            cumulative_len_.push_front(length);
+        int64_t length = (int64_t) g_.length(e);
+        if (starts_.empty()) {
+            starts_.push_front(0);
+            end_ = length;
         } else {
-            cumulative_len_.push_front(cumulative_len_.front() + length + gap.gap);
+            starts_.push_front(starts_.front() - length - gap.gap);
         }
         NotifyFrontEdgeAdded(e, gap);
     }
 
     void PopFront() {
         EdgeId e = edges_.front();
-        cumulative_len_.pop_front();
+        starts_.pop_front();
         SimpleBidirectionalPath::PopFront();
 
         NotifyFrontEdgeRemoved(e);
@@ -753,6 +782,11 @@ private:
     DECL_LOGGER("BidirectionalPath");
 };
 
+inline void PathListener::BackEdgesAdded(BidirectionalPath &path, size_t from) {
+    for (size_t i = from; i < path.Size(); ++i)
+        BackEdgeAdded(path[i], path, path.GapAt(i));
+}
+
 inline int SkipOneGap(debruijn_graph::EdgeId end, const BidirectionalPath& path, int gap, int pos, bool forward) {
     size_t len = 0;
     while (pos < (int) path.Size() && pos >= 0 && end != path.At(pos) && (int) len < 2 * gap) {
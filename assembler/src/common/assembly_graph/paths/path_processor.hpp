@@ -33,6 +33,8 @@ class PathProcessor {
     typedef std::vector<EdgeId> Path;
     typedef typename DijkstraHelper<Graph>::BoundedDijkstra DijkstraT;
 public:
+    typedef typename DijkstraT::Workspace Workspace;
+
     class Callback {
 
     public:
@@ -184,12 +186,15 @@ private:
 
 public:
 
+    // If workspace is given, it must not be reused while the processor is alive
     PathProcessor(const Graph& g, VertexId start, size_t length_bound,
-                  size_t dijkstra_vertex_limit = MAX_DIJKSTRA_VERTICES) :
+                  size_t dijkstra_vertex_limit = MAX_DIJKSTRA_VERTICES,
+                  Workspace *workspace = nullptr) :
               g_(g),
               start_(start),
               dijkstra_(DijkstraHelper<Graph>::CreateBoundedDijkstra(g, length_bound,
-                                                                     dijkstra_vertex_limit)) {
+                                                                     dijkstra_vertex_limit,
+                                                                     false, workspace)) {
         //TIME_TRACE_SCOPE("PathProcessor:Dijkstra");
         TRACE("Dijkstra launched");
         dijkstra_.Run(start);
@@ -180,7 +180,7 @@ void BasePackIO::Save(const std::string &basename, const Type &gp) {
     if (gp.invalidated<Graph>()) {
         //1. Save basic graph with coverage
         const auto &g = gp.get<Graph>();
-        graph_io_.Save(basename, g);
+        snapshot_io_.Save(basename, g);
     }
 
     //2. Save edge positions
@@ -204,7 +204,8 @@ bool BasePackIO::Load(const std::string &basename, Type &gp) {
 
     //1. Load basic graph with coverage
     auto &g = gp.get_mutable<Graph>();
-    graph_io_.Load(basename, g);
+    if (!snapshot_io_.Load(basename, g))
+        graph_io_.Load(basename, g);
 
     //2. Load edge positions
     loader.Load<EdgesPositionHandler<Graph>>();
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "basic.hpp"
+#include "graph_snapshot.hpp"
 #include "pipeline/graph_pack.hpp"
 
 namespace io {
@@ -15,6 +16,8 @@ namespace binary {
 
 /**
  * @brief  This IOer processes the graph pack including only graph-related components.
+ *         The graph is saved as a memory-mappable snapshot, the saves of the older
+ *         format (graph sequences with separate coverage) are still loaded.
  */
 class BasePackIO : public IOBase<debruijn_graph::GraphPack> {
 public:
@@ -31,6 +34,7 @@ public:
 
 protected:
     BasicGraphIO<Graph> graph_io_;
+    GraphSnapshotIO<Graph> snapshot_io_;
 };
 
 /**
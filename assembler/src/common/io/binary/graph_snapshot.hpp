@@ -0,0 +1,284 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "io_base.hpp"
+
+#include "assembly_graph/core/construction_helper.hpp"
+#include "assembly_graph/core/graph.hpp"
+#include "sequence/sequence.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/timetracer.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace io {
+
+namespace binary {
+
+/**
+ * @brief  Columnar snapshot of the graph with its coverage index. The file
+ *         starts with the header followed by the sections, each of them at
+ *         an offset aligned to ALIGNMENT:
+ *         - vertex table: ids of all the vertices with their conjugates and
+ *           the positions of their outgoing edges in the next section;
+ *         - outgoing edges of all the vertices;
+ *         - edge table: ids, coverage and positions of the sequences in the
+ *           arena for the canonical edges;
+ *         - window table: positions of the arena windows;
+ *         - nucleotide arena: edge sequences packed 2 bits per nucleotide,
+ *           split into windows of at most WINDOW_SIZE bytes.
+ *         The file is memory-mapped on load and the tables are processed in
+ *         parallel. Edge sequences are views of the mapped windows, so they
+ *         are neither read nor copied until used.
+ */
+template<typename Graph>
+class GraphSnapshotIO : public IOBase<Graph> {
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
+    typedef seq_element_type ST;
+
+    static constexpr uint64_t MAGIC = 0x31504e5347445053ULL; // "SPDGSNP1"
+    static constexpr size_t ALIGNMENT = size_t(1) << 16;
+    static constexpr size_t WINDOW_SIZE = size_t(1) << 28;
+    static constexpr size_t STN = sizeof(ST) * 4;
+
+    struct Header {
+        uint64_t magic;
+        uint64_t k;
+        uint64_t vreserved, ereserved;
+        uint64_t vertices, out_edges, edges, windows;
+        uint64_t vertex_offset, out_offset, edge_offset, window_offset;
+    };
+
+    struct VertexRecord {
+        uint64_t id, conjugate;
+        // Position of the first outgoing edge
+        uint64_t out;
+    };
+
+    struct EdgeRecord {
+        uint64_t id, conjugate;
+        // In words from the window start / in nucleotides
+        uint64_t offset, length;
+        uint32_t window;
+        uint32_t coverage;
+    };
+
+    struct Window {
+        uint64_t offset, bytes;
+    };
+
+    static size_t Align(size_t offset) {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    static size_t Words(size_t nucls) {
+        return (nucls + STN - 1) / STN;
+    }
+
+    template<class T>
+    static void Write(std::ofstream &os, size_t offset, const std::vector<T> &data) {
+        os.seekp(std::streamoff(offset));
+        os.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size() * sizeof(T)));
+    }
+
+    static void *Map(int fd, size_t offset, size_t bytes, const std::string &filename) {
+        void *data = mmap(NULL, bytes, PROT_READ, MAP_FILE | MAP_PRIVATE, fd, off_t(offset));
+        CHECK_FATAL_ERROR(data != MAP_FAILED,
+                          "mmap(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno << ". File: " << filename);
+        return data;
+    }
+
+public:
+    GraphSnapshotIO()
+            : ext_(".grsnap") {}
+
+    void Save(const std::string &basename, const Graph &graph) override {
+        TIME_TRACE_SCOPE("GraphSnapshotIO::Save");
+        std::string filename = basename + ext_;
+        DEBUG("Saving graph snapshot into " << filename);
+
+        std::vector<VertexRecord> vertices;
+        std::vector<uint64_t> out_edges;
+        vertices.reserve(graph.size());
+        for (VertexId v : graph) {
+            vertices.push_back({ v.int_id(), graph.conjugate(v).int_id(), out_edges.size() });
+            for (EdgeId e : graph.OutgoingEdges(v))
+                out_edges.push_back(e.int_id());
+        }
+
+        // Edges never cross the window boundary
+        std::vector<EdgeRecord> edges;
+        std::vector<Window> windows;
+        size_t window_words = 0;
+        for (EdgeId e : graph.canonical_edges()) {
+            size_t length = graph.EdgeNucls(e).size();
+            size_t words = Words(length);
+            VERIFY(words * sizeof(ST) <= WINDOW_SIZE);
+            if (windows.empty() || (window_words + words) * sizeof(ST) > WINDOW_SIZE) {
+                if (!windows.empty())
+                    windows.back().bytes = window_words * sizeof(ST);
+                windows.push_back({ 0, 0 });
+                window_words = 0;
+            }
+            edges.push_back({ e.int_id(), graph.conjugate(e).int_id(),
+                              window_words, length,
+                              uint32_t(windows.size() - 1), graph.coverage_index().RawCoverage(e) });
+            window_words += words;
+        }
+        if (!windows.empty())
+            windows.back().bytes = window_words * sizeof(ST);
+
+        Header header;
+        header.magic = MAGIC;
+        header.k = graph.k();
+        header.vreserved = graph.vreserved();
+        header.ereserved = graph.ereserved();
+        header.vertices = vertices.size();
+        header.out_edges = out_edges.size();
+        header.edges = edges.size();
+        header.windows = windows.size();
+        header.vertex_offset = Align(sizeof(Header));
+        header.out_offset = Align(header.vertex_offset + vertices.size() * sizeof(VertexRecord));
+        header.edge_offset = Align(header.out_offset + out_edges.size() * sizeof(uint64_t));
+        header.window_offset = Align(header.edge_offset + edges.size() * sizeof(EdgeRecord));
+        size_t offset = Align(header.window_offset + windows.size() * sizeof(Window));
+        for (auto &window : windows) {
+            window.offset = offset;
+            offset = Align(offset + window.bytes);
+        }
+
+        // The old snapshot might still be mapped by the sequences of a loaded
+        // graph, so it is replaced as a whole instead of being rewritten
+        std::string tmp_filename = filename + ".tmp";
+        std::ofstream os(tmp_filename, std::ios::binary);
+        CHECK_FATAL_ERROR(os, "Failed to open " << tmp_filename);
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        Write(os, header.vertex_offset, vertices);
+        Write(os, header.out_offset, out_edges);
+        Write(os, header.edge_offset, edges);
+        Write(os, header.window_offset, windows);
+
+        std::vector<ST> buf;
+        for (const auto &record : edges) {
+            const Sequence &nucls = graph.EdgeNucls(EdgeId(record.id));
+            buf.resize(Words(record.length));
+            nucls.copy_packed(buf.data());
+            Write(os, windows[record.window].offset + record.offset * sizeof(ST), buf);
+        }
+
+        os.close();
+        CHECK_FATAL_ERROR(os, "Failed to write " << tmp_filename);
+        CHECK_FATAL_ERROR(std::rename(tmp_filename.c_str(), filename.c_str()) == 0,
+                          "Failed to rename " << tmp_filename << " to " << filename << ". Reason: " << strerror(errno));
+    }
+
+    /**
+     * @return false if the file is missing. Fails if the file cannot be read.
+     */
+    bool Load(const std::string &basename, Graph &graph) override {
+        TIME_TRACE_SCOPE("GraphSnapshotIO::Load");
+        std::string filename = basename + ext_;
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1)
+            return false;
+
+        DEBUG("Loading graph snapshot from " << filename);
+        VERIFY(ALIGNMENT % size_t(getpagesize()) == 0);
+        struct stat st;
+        CHECK_FATAL_ERROR(fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Header),
+                          "Failed to read " << filename);
+        Header header;
+        CHECK_FATAL_ERROR(::pread(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header)) &&
+                          header.magic == MAGIC, "Malformed graph snapshot " << filename);
+        CHECK_FATAL_ERROR(header.k == graph.k(), "Cannot read graph snapshot, different Ks");
+
+        // Tables are mapped only for the load, the windows stay mapped while
+        // there are sequences referring to them
+        size_t tables_size = header.window_offset + header.windows * sizeof(Window);
+        const char *tables = static_cast<const char*>(Map(fd, 0, tables_size, filename));
+        auto vertices = reinterpret_cast<const VertexRecord*>(tables + header.vertex_offset);
+        auto out_edges = reinterpret_cast<const uint64_t*>(tables + header.out_offset);
+        auto edges = reinterpret_cast<const EdgeRecord*>(tables + header.edge_offset);
+        auto windows = reinterpret_cast<const Window*>(tables + header.window_offset);
+
+        std::vector<Sequence> arena;
+        for (size_t i = 0; i < header.windows; ++i) {
+            void *data = Map(fd, windows[i].offset, windows[i].bytes, filename);
+            arena.push_back(Sequence::Wrap(data, windows[i].bytes,
+                                           [](const void *ptr, size_t sz) { munmap(const_cast<void*>(ptr), sz); }));
+        }
+        ::close(fd);
+
+        graph.clear();
+        graph.reserve(header.vreserved, header.ereserved);
+        auto helper = graph.GetConstructionHelper();
+        auto &coverage = graph.coverage_index();
+
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < header.edges; ++i) {
+            const EdgeRecord &record = edges[i];
+            size_t start = record.offset * STN;
+            EdgeId e = helper.CreateEdge(typename Graph::EdgeData(arena[record.window].Subseq(start, start + record.length)),
+                                         record.id, record.conjugate);
+            coverage.SetRawCoverage(e, record.coverage);
+            if (record.conjugate != record.id)
+                coverage.SetRawCoverage(graph.conjugate(e), record.coverage);
+        }
+
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < header.vertices; ++i) {
+            const VertexRecord &record = vertices[i];
+            if (record.id < record.conjugate)
+                helper.CreateVertex(typename Graph::VertexData(), record.id, record.conjugate);
+        }
+
+        // Every vertex is linked by a single thread, the end of every edge is
+        // set exactly once (while linking its conjugate)
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < header.vertices; ++i) {
+            VertexId v(vertices[i].id);
+            size_t end = (i + 1 < header.vertices ? vertices[i + 1].out : header.out_edges);
+            for (size_t j = vertices[i].out; j < end; ++j)
+                helper.LinkOutgoingEdge(v, EdgeId(out_edges[j]));
+        }
+
+        // Handlers are notified in the same way as if the elements were added
+        // one by one
+        for (size_t i = 0; i < header.vertices; ++i) {
+            if (vertices[i].id < vertices[i].conjugate)
+                graph.FireAddVertex(VertexId(vertices[i].id));
+        }
+        for (size_t i = 0; i < header.edges; ++i)
+            graph.FireAddEdge(EdgeId(edges[i].id));
+
+        munmap(const_cast<char*>(tables), tables_size);
+
+        return true;
+    }
+
+private:
+    std::string ext_;
+
+    DECL_LOGGER("GraphSnapshotIO");
+};
+
+} // namespace binary
+
+} // namespace io
@@ -17,6 +17,13 @@
 
 #include "threadpool/threadpool.hpp"
 
+#include <zlib.h>
+
+#include <deque>
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
+
 namespace io {
 
 template<class Read>
@@ -54,11 +61,36 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
     DEBUG("Reserving a buffer for " << BUF_SIZE << " reads");
     buf.reserve(BUF_SIZE); flush_buf.reserve(BUF_SIZE);
 
+    index_.blocks.clear();
+
     // Reserve space for stats
     ReadStreamStat read_stats;
     read_stats.write(*file_ds_);
 
-    size_t rest = 1;
+    std::ostringstream block;
+    size_t block_reads = 0;
+    // Blocks are compressed by the pool in parallel and written in order
+    std::deque<std::future<CompressedBlock>> compressed;
+    auto write_compressed = [&](size_t keep) {
+        while (compressed.size() > keep) {
+            WriteBlock(compressed.front().get());
+            compressed.pop_front();
+        }
+    };
+    auto finish_block = [&]() {
+        std::string raw = block.str();
+        block.str("");
+        block.clear();
+        if (pool) {
+            compressed.push_back(pool->run([raw = std::move(raw), reads = block_reads]() mutable {
+                return CompressBlock(std::move(raw), reads);
+            }));
+            write_compressed(MAX_PENDING_BLOCKS);
+        } else {
+            WriteBlock(CompressBlock(std::move(raw), block_reads));
+        }
+        block_reads = 0;
+    };
     std::future<void> flush_task;
     auto flush_buffer = [&]() {
         // Wait for completion of the current flush task
@@ -70,12 +102,10 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
 
         auto flush_job = [&] {
             for (const Read &read : flush_buf) {
-                if (!--rest) {
-                    auto offset = (size_t)file_ds_->tellp();
-                    offset_ds_->write(reinterpret_cast<const char*>(&offset), sizeof(offset));
-                    rest = CHUNK;
-                }
-                writer.Write(*file_ds_, read);
+                writer.Write(block, read);
+                block_reads += 1;
+                if ((size_t)block.tellp() >= BLOCK_SIZE)
+                    finish_block();
             }
             flush_buf.clear();
         };
@@ -103,10 +133,15 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
     if (flush_task.valid())
         flush_task.wait();
     VERIFY(flush_buf.size() == 0);
+    if (block_reads)
+        finish_block();
+    write_compressed(0);
 
     // Rewrite the reserved space with actual stats
     file_ds_->seekp(0);
     read_stats.write(*file_ds_);
+    file_ds_->flush();
+    index_.write(file_name_prefix_ + ".blk");
 
     INFO(read_count << " reads written");
     return read_stats;
@@ -114,10 +149,73 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
 
 BinaryWriter::BinaryWriter(const std::string &file_name_prefix)
             : file_name_prefix_(file_name_prefix),
-              file_ds_(std::make_unique<std::ofstream>(file_name_prefix_ + ".seq", std::ios_base::binary)),
-              offset_ds_(std::make_unique<std::ofstream>(file_name_prefix_ + ".off", std::ios_base::binary))
+              file_ds_(std::make_unique<std::ofstream>(file_name_prefix_ + ".seq", std::ios_base::binary))
 {}
 
+BinaryWriter::CompressedBlock BinaryWriter::CompressBlock(std::string raw, size_t read_count) {
+    std::vector<Bytef> buf(compressBound(raw.size()));
+    uLongf compressed_size = buf.size();
+    int res = compress2(buf.data(), &compressed_size,
+                        reinterpret_cast<const Bytef*>(raw.data()), raw.size(), Z_BEST_SPEED);
+    VERIFY_MSG(res == Z_OK, "Cannot compress the block of reads, error code " << res);
+
+    CompressedBlock b;
+    b.block.size = raw.size();
+    b.block.read_count = read_count;
+    b.block.checksum = XXH3_64bits(raw.data(), raw.size());
+    // Store incompressible blocks as is
+    if (compressed_size < raw.size())
+        b.data.assign(reinterpret_cast<const char*>(buf.data()), compressed_size);
+    else
+        b.data = std::move(raw);
+    b.block.compressed_size = b.data.size();
+
+    return b;
+}
+
+void BinaryWriter::WriteBlock(CompressedBlock b) {
+    b.block.offset = (size_t)file_ds_->tellp();
+    file_ds_->write(b.data.data(), b.data.size());
+    VERIFY_MSG(!file_ds_->fail(), "Cannot write binary reads to " << file_name_prefix_ << ".seq");
+
+    index_.blocks.push_back(b.block);
+}
+
+constexpr uint64_t BinaryBlockIndex::MAGIC;
+constexpr uint64_t BinaryBlockIndex::VERSION;
+
+void BinaryBlockIndex::write(const std::string &file_name) const {
+    std::ofstream os(file_name, std::ios_base::binary);
+    size_t count = blocks.size();
+    os.write((const char *) &MAGIC, sizeof(MAGIC));
+    os.write((const char *) &VERSION, sizeof(VERSION));
+    os.write((const char *) &count, sizeof(count));
+    os.write((const char *) blocks.data(), count * sizeof(BinaryBlock));
+    VERIFY_MSG(!os.fail(), "Cannot write block index " << file_name);
+}
+
+bool BinaryBlockIndex::read(const std::string &file_name) {
+    blocks.clear();
+    std::ifstream is(file_name, std::ios_base::binary);
+    if (!is)
+        return false;
+
+    uint64_t magic = 0, version = 0;
+    size_t count = 0;
+    is.read((char *) &magic, sizeof(magic));
+    is.read((char *) &version, sizeof(version));
+    CHECK_FATAL_ERROR(is && magic == MAGIC, "Invalid block index " << file_name);
+    CHECK_FATAL_ERROR(version == VERSION,
+                      "Unsupported version " << version << " of block index " << file_name);
+
+    is.read((char *) &count, sizeof(count));
+    blocks.resize(count);
+    is.read((char *) blocks.data(), count * sizeof(BinaryBlock));
+    CHECK_FATAL_ERROR(is, "Truncated block index " << file_name);
+
+    return true;
+}
+
 ReadStreamStat BinaryWriter::ToBinary(io::ReadStream<io::SingleReadSeq>& stream,
                                       ThreadPool::ThreadPool *pool) {
     ReadBinaryWriter<io::SingleReadSeq> read_writer;
@@ -15,6 +15,9 @@
 #include "pipeline/library_fwd.hpp"
 
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 namespace ThreadPool {
 class ThreadPool;
@@ -22,18 +25,62 @@ class ThreadPool;
 
 namespace io {
 
+// Block of reads in the .seq file
+struct BinaryBlock {
+    size_t offset;
+    // Equals to size for the blocks stored uncompressed
+    size_t compressed_size;
+    size_t size;
+    size_t read_count;
+    // XXH3 of the uncompressed data
+    uint64_t checksum;
+};
+
+/**
+ * Index of the blocks of the binary reads file, stored in the .blk file.
+ * Files without the index are in the legacy format: uncompressed reads
+ * with offsets of every CHUNK reads in the .off file. Such files are still
+ * read, but no longer written: the offsets of reads in the compressed .seq
+ * file are meaningless, the index replaces them.
+ */
+struct BinaryBlockIndex {
+    static constexpr uint64_t MAGIC = 0x4b4c4253594e4942ULL;
+    static constexpr uint64_t VERSION = 2;
+
+    std::vector<BinaryBlock> blocks;
+
+    void write(const std::string &file_name) const;
+    // Returns false if there is no index
+    bool read(const std::string &file_name);
+};
+
 class BinaryWriter {
     const std::string file_name_prefix_;
-    std::unique_ptr<std::ofstream> file_ds_, offset_ds_;
+    std::unique_ptr<std::ofstream> file_ds_;
+    BinaryBlockIndex index_;
 
     template<class Writer, class Read>
     ReadStreamStat ToBinary(const Writer &writer, io::ReadStream<Read> &stream,
                             ThreadPool::ThreadPool *pool = nullptr);
 
+    struct CompressedBlock {
+        // Everything but the offset
+        BinaryBlock block;
+        std::string data;
+    };
+
+    static CompressedBlock CompressBlock(std::string raw, size_t read_count);
+    // Appends the block to the file
+    void WriteBlock(CompressedBlock block);
+
 public:
     typedef size_t CountType;
     static constexpr size_t CHUNK = 100;
     static constexpr size_t BUF_SIZE = 50000;
+    // Reads are written by blocks of at least BLOCK_SIZE bytes
+    static constexpr size_t BLOCK_SIZE = size_t(1) << 21;
+    // Compressed blocks waiting to be written
+    static constexpr size_t MAX_PENDING_BLOCKS = 16;
 
     BinaryWriter(const std::string &file_name_prefix);
 
@@ -18,24 +18,177 @@
 #include "utils/filesystem/file_opener.hpp"
 
 #include <fstream>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <zlib.h>
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
 
 namespace io {
 
+/**
+ * Reader of a portion of the binary reads file. The file is memory-mapped by
+ * windows of at most WINDOW_SIZE bytes with sequential access hint. Files in
+ * the block format (see BinaryBlockIndex) are split into portions of equal
+ * number of reads, every stream decompresses the blocks overlapping its
+ * portion (skipping the reads of the previous portion in the first one), so
+ * the streams of ReadStreamList decompress in parallel. The sequences of the reads are views
+ * of the decompressed block (or of the mapped window for uncompressed data),
+ * so no per-read buffers are allocated or copied.
+ */
 template<typename SeqT>
 class BinaryFileStream {
-protected:
-    std::ifstream stream_;
+    // Every read keeps the whole window mapped, so the windows are small
+    static constexpr size_t WINDOW_SIZE = size_t(1) << 25;
 
+protected:
     virtual bool ReadImpl(SeqT &read) = 0;
 
+    // Reads the next record of the file
+    SingleReadSeq NextRead() {
+        Ensure(sizeof(size_t));
+        size_t size;
+        memcpy(&size, buf_data_ + buf_pos_, sizeof(size));
+
+        const size_t seq_bytes = (size + 31) / 32 * sizeof(seq_element_type);
+        const size_t bytes = sizeof(size_t) + seq_bytes + 2 * sizeof(SequenceOffsetT);
+        Ensure(bytes);
+
+        const uint8_t *record = buf_data_ + buf_pos_;
+        const size_t seq_start = 4 * (buf_pos_ + sizeof(size_t));
+        SequenceOffsetT left_offset, right_offset;
+        memcpy(&left_offset, record + sizeof(size_t) + seq_bytes, sizeof(left_offset));
+        memcpy(&right_offset, record + sizeof(size_t) + seq_bytes + sizeof(left_offset), sizeof(right_offset));
+        buf_pos_ += bytes;
+
+        return SingleReadSeq(buf_.Subseq(seq_start, seq_start + size), left_offset, right_offset);
+    }
+
 private:
-    size_t offset_, count_, current_;
+    std::string fname_;
+    bool open_;
+    size_t offset_, end_, count_, current_;
+    // Reads of the first block belonging to the previous portion
+    size_t skip_, skipped_;
+    // Blocks of the portion, empty for the legacy format
+    std::vector<BinaryBlock> blocks_;
+    size_t next_block_;
+
+    // Mapped part [window_start_, window_end_) of the file
+    Sequence window_;
+    const uint8_t *window_data_;
+    size_t window_start_, window_end_;
+
+    // Records are read from [buf_pos_, buf_end_) of either the mapped window
+    // or the decompressed block
+    Sequence buf_;
+    const uint8_t *buf_data_;
+    size_t buf_pos_, buf_end_;
 
     void Init() {
-        stream_.clear();
-        stream_.seekg(offset_);
-        VERIFY_MSG(stream_.good(), "Stream is not good(), offset_ " << offset_ << " count_ " << count_);
         current_ = 0;
+        skipped_ = 0;
+        next_block_ = 0;
+        buf_ = Sequence();
+        buf_data_ = nullptr;
+        buf_pos_ = buf_end_ = 0;
+    }
+
+    // Maps the window holding bytes starting from the file position
+    const uint8_t *Map(size_t pos, size_t bytes) {
+        if (window_data_ && pos >= window_start_ && pos + bytes <= window_end_)
+            return window_data_ + (pos - window_start_);
+
+        VERIFY_MSG(pos + bytes <= end_, "Truncated binary reads file " << fname_);
+        const size_t page = size_t(getpagesize());
+        size_t start = pos / page * page;
+        size_t len = std::max(std::min(WINDOW_SIZE, end_ - start), pos + bytes - start);
+
+        int fd = ::open(fname_.c_str(), O_RDONLY);
+        CHECK_FATAL_ERROR(fd != -1,
+                          "open(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno << ". File: " << fname_);
+        void *data = mmap(NULL, len, PROT_READ, MAP_FILE | MAP_PRIVATE, fd, off_t(start));
+        ::close(fd);
+        CHECK_FATAL_ERROR(data != MAP_FAILED,
+                          "mmap(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno << ". File: " << fname_);
+        madvise(data, len, MADV_SEQUENTIAL);
+
+        window_ = Sequence::Wrap(data, len,
+                                 [](const void *ptr, size_t sz) { munmap(const_cast<void*>(ptr), sz); });
+        window_data_ = static_cast<const uint8_t*>(data);
+        window_start_ = start;
+        window_end_ = start + len;
+
+        return window_data_ + (pos - window_start_);
+    }
+
+    void NextBlock() {
+        VERIFY_MSG(buf_pos_ == buf_end_, "Read crosses the block boundary in " << fname_);
+        VERIFY_MSG(next_block_ < blocks_.size(), "Truncated binary reads file " << fname_);
+        const BinaryBlock &block = blocks_[next_block_++];
+
+        const uint8_t *data = Map(block.offset, block.compressed_size);
+        if (block.compressed_size == block.size) {
+            buf_ = window_;
+            buf_data_ = window_data_;
+            buf_pos_ = block.offset - window_start_;
+        } else {
+            // Sequences read the whole words of the buffer
+            size_t alloc = (block.size + sizeof(seq_element_type) - 1) / sizeof(seq_element_type) * sizeof(seq_element_type);
+            uint8_t *raw = static_cast<uint8_t*>(malloc(alloc));
+            VERIFY(raw);
+            uLongf size = block.size;
+            int res = uncompress(raw, &size, data, block.compressed_size);
+            if (res != Z_OK || size != block.size)
+                free(raw);
+            CHECK_FATAL_ERROR(res == Z_OK && size == block.size,
+                              "Cannot decompress the block at " << block.offset << " of " << fname_ << ", error code " << res);
+
+            buf_ = Sequence::Wrap(raw, alloc, [](const void *ptr, size_t) { free(const_cast<void*>(ptr)); });
+            buf_data_ = raw;
+            buf_pos_ = 0;
+        }
+        buf_end_ = buf_pos_ + block.size;
+
+        CHECK_FATAL_ERROR(XXH3_64bits(buf_data_ + buf_pos_, block.size) == block.checksum,
+                          "Checksum mismatch for the block at " << block.offset << " of " << fname_);
+    }
+
+    // Makes sure that bytes starting from the current position are available
+    void Ensure(size_t bytes) {
+        if (buf_data_ && buf_pos_ + bytes <= buf_end_)
+            return;
+
+        if (!blocks_.empty()) {
+            NextBlock();
+            VERIFY_MSG(buf_pos_ + bytes <= buf_end_, "Read crosses the block boundary in " << fname_);
+            return;
+        }
+
+        size_t pos = (buf_data_ ? window_start_ + buf_pos_ : offset_);
+        Map(pos, bytes);
+        buf_ = window_;
+        buf_data_ = window_data_;
+        buf_pos_ = pos - window_start_;
+        buf_end_ = window_end_ - window_start_;
+    }
+
+    // Splits n items into portion_count portions, the first n % portion_count
+    // of them are one item larger. Returns the range of the portion.
+    static std::pair<size_t, size_t> Portion(size_t n, size_t portion_count, size_t portion_num) {
+        const size_t small_portion_size = n / portion_count;
+        const size_t big_portion_count = n % portion_count;
+        const size_t from = portion_num * small_portion_size + std::min(portion_num, big_portion_count);
+        return { from, from + small_portion_size + (portion_num < big_portion_count ? 1 : 0) };
     }
 
 public:
@@ -45,50 +198,69 @@ public:
      * @param portion_count Total number of (roughly equal) portions.
      * @param portion_num Index of the portion (0..portion_count - 1).
      */
-    BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num) {
+    BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num)
+            : fname_(file_name_prefix + ".seq"), open_(true), skip_(0),
+              window_data_(nullptr), window_start_(0), window_end_(0) {
         DEBUG("Preparing binary stream #" << portion_num << "/" << portion_count);
         VERIFY(portion_num < portion_count);
-        const std::string fname = file_name_prefix + ".seq";
-        stream_.open(fname, std::ios_base::binary | std::ios_base::in);
         ReadStreamStat stat;
-        stat.read(stream_);
-
-        const std::string offset_name = file_name_prefix + ".off";
-        const size_t chunk_count = fs::filesize(offset_name) / sizeof(size_t);
+        {
+            auto stream = fs::open_file(fname_, std::ios_base::binary | std::ios_base::in);
+            stat.read(stream);
+        }
+        end_ = fs::filesize(fname_);
+
+        BinaryBlockIndex index;
+        if (index.read(file_name_prefix + ".blk")) {
+            size_t total = 0;
+            for (const auto &block : index.blocks)
+                total += block.read_count;
+
+            size_t from, to;
+            std::tie(from, to) = Portion(total, portion_count, portion_num);
+            size_t start = 0;
+            for (const auto &block : index.blocks) {
+                size_t end = start + block.read_count;
+                if (start < to && end > from) {
+                    if (blocks_.empty())
+                        skip_ = from - start;
+                    blocks_.push_back(block);
+                }
+                start = end;
+            }
 
-        // We split all read chunks into portion_count portions
-        // Portion could have size (chunk_count / portion_count) or (chunk_count / portion_count + 1)
-        const size_t small_portion_size = chunk_count / portion_count;
-        const size_t big_portion_size = small_portion_size + 1;
-        const size_t big_portion_count = chunk_count % portion_count;
-        VERIFY(big_portion_count * big_portion_size + (portion_count - big_portion_count) * small_portion_size == chunk_count);
-        // We suppose that all small portions are placed at the end
-        // Note that small portion could have size 0
+            offset_ = sizeof(ReadStreamStat);
+            count_ = to - from;
 
-        // Compute the number of big portions preceding the current portion
-        const size_t big_portion_before = std::min(portion_num, big_portion_count);
+            DEBUG("Reads " << from << "-" << to << "/" << total << " from " << blocks_.size() << " blocks");
+            Init();
+            return;
+        }
 
-        // At last, compute the number of the first chunk in the current portion
-        const size_t chunk_num = big_portion_before * (big_portion_size - small_portion_size) + portion_num * small_portion_size;
-        VERIFY_MSG(chunk_num <= chunk_count, "chunk_num " << chunk_num << " chunk_count " << chunk_count << " big_portion_before " << big_portion_before << " big_portion_size " << big_portion_size << " small_portion_size " << small_portion_size << " portion_num " << portion_num);
+        // Legacy format, all read chunks are split into portion_count portions
+        const std::string offset_name = file_name_prefix + ".off";
+        const size_t chunk_count = fs::filesize(offset_name) / sizeof(size_t);
+        size_t chunk_num, chunk_end;
+        std::tie(chunk_num, chunk_end) = Portion(chunk_count, portion_count, portion_num);
 
-        if (chunk_num < chunk_count) {  // if we start from existing chunk
-            // Calculating the absolute offset in the reads file
+        if (chunk_num < chunk_end) {
+            // Calculating the absolute offsets of the portion in the reads file
             auto offset_stream = fs::open_file(offset_name, std::ios_base::binary | std::ios_base::in);
             offset_stream.seekg(chunk_num * sizeof(size_t));
             offset_stream.read(reinterpret_cast<char *>(&offset_), sizeof(offset_));
-            DEBUG("Offset read: " << offset_ << " chunk_count " << chunk_count << " chunk_num " << chunk_num << " portion_count " << portion_count << " portion_num " << portion_num << " prefix " << file_name_prefix << " name " << offset_name);
+            if (chunk_end < chunk_count) {
+                offset_stream.seekg(chunk_end * sizeof(size_t));
+                offset_stream.read(reinterpret_cast<char *>(&end_), sizeof(end_));
+            }
             VERIFY(offset_stream);
-            const bool is_big_portion = portion_num < big_portion_count;
+
             const size_t start_num = chunk_num * BinaryWriter::CHUNK;
             // Last chunk could be incomplete => we should truncate count_ for last portions
-            count_ = std::min(stat.read_count - start_num,
-                              (is_big_portion ? big_portion_size : small_portion_size) * BinaryWriter::CHUNK);
+            count_ = std::min(stat.read_count - start_num, (chunk_end - chunk_num) * BinaryWriter::CHUNK);
 
-            DEBUG("Reads " << start_num << "-" << start_num + count_ << "/" << stat.read_count << " from " << offset_);
+            DEBUG("Reads " << start_num << "-" << start_num + count_ << "/" << stat.read_count << " from " << offset_ << " to " << end_);
         } else {  // current portion has size 0 (the case of chunk_count == 0 is also included here)
-            // Setup safe offset value
-            offset_ = sizeof(ReadStreamStat);
+            offset_ = end_ = sizeof(ReadStreamStat);
             count_ = 0;
             DEBUG("Empty BinaryFileStream constructed");
         }
@@ -103,14 +275,16 @@ public:
             : BinaryFileStream(file_name_prefix, 1, 0) {}
 
     BinaryFileStream<SeqT>& operator>>(SeqT &read) {
+        VERIFY(open_ && current_ < count_);
+        for (; skipped_ < skip_; ++skipped_)
+            ReadImpl(read);
         ReadImpl(read);
-        VERIFY(current_ < count_);
         ++current_;
         return *this;
     }
 
     bool is_open() {
-        return stream_.is_open();
+        return open_;
     }
 
     bool eof() {
@@ -118,8 +292,11 @@ public:
     }
 
     void close() {
-        current_ = 0;
-        stream_.close();
+        Init();
+        open_ = false;
+        window_ = Sequence();
+        window_data_ = nullptr;
+        window_start_ = window_end_ = 0;
     }
 
     void reset() {
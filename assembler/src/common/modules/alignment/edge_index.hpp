@@ -53,6 +53,26 @@ private:
         return { EdgeId(), NOT_FOUND };
     }
 
+    template<class Index>
+    void get(const Index *index, const KMer *kmers, size_t n,
+             std::pair<EdgeId, size_t> *res) const {
+        // Reused between the calls, so that no allocations are made per batch
+        static thread_local std::vector<typename Index::KeyWithHash> kwhs;
+        index->ConstructKWH(kmers, n, kwhs);
+        for (const auto &kwh : kwhs)
+            index->prefetch_value(kwh);
+
+        for (size_t i = 0; i < n; ++i) {
+            const auto &kwh = kwhs[i];
+            if (index->contains(kwh)) {
+                auto entry = index->get_value(kwh);
+                res[i] = { entry.edge(), (size_t)entry.offset() };
+            } else {
+                res[i] = { EdgeId(), NOT_FOUND };
+            }
+        }
+    }
+
     template<class Index>
     bool contains(const Index *index, const KMer& kmer) const {
         return index->contains(index->ConstructKWH(kmer));
@@ -68,6 +88,16 @@ private:
         updater_.DeleteKmers(this->g(), e, *index);
     }
 
+    template<class Index>
+    void UpdateKmers(Index *index, const std::vector<EdgeId> &edges) {
+        updater_.Update(this->g(), *index, edges);
+    }
+
+    template<class Index>
+    void DeleteKmers(Index *index, const std::vector<EdgeId> &edges) {
+        updater_.Delete(this->g(), *index, edges);
+    }
+
     template<class Index>
     void clear(Index *index) {
         if (!inner_index_)
@@ -141,6 +171,15 @@ public:
         DISPATCH_TO(DeleteKmers, e);
     }
 
+    // Edges of a batch are processed in parallel, each conjugate pair by a single thread
+    void HandleAddBatch(const std::vector<EdgeId> &edges) override {
+        DISPATCH_TO(UpdateKmers, edges);
+    }
+
+    void HandleDeleteBatch(const std::vector<EdgeId> &edges) override {
+        DISPATCH_TO(DeleteKmers, edges);
+    }
+
     bool contains(const KMer& kmer) const {
         DISPATCH_TO(contains, kmer);
     }
@@ -149,6 +188,14 @@ public:
         DISPATCH_TO(get, kmer);
     }
 
+    /**
+     * Batched version of get(): the lookups of all the k-mers are issued
+     * together, so the cache misses on index and value accesses overlap.
+     */
+    void get(const KMer *kmers, size_t n, std::pair<EdgeId, size_t> *res) const {
+        DISPATCH_TO(get, kmers, n, res);
+    }
+
     void Refill() {
         clear();
         uint64_t max_id = this->g().max_eid();
@@ -12,6 +12,10 @@
 #include <tsl/htrie_map.h>
 #include <boost/iterator/iterator_facade.hpp>
 
+#include <string>
+#include <vector>
+#include <cstring>
+
 #define XXH_INLINE_ALL
 #include "xxh/xxhash.h"
 
@@ -134,6 +138,59 @@ class KMerMap {
         return iterator(k_, mapping_.end());
     }
 
+    // Replaces every value with the result of fn(key, value). The values are
+    // computed for all the entries first and are assigned afterwards, so fn
+    // might look up the map itself.
+    template<class F>
+    void parallel_transform(F fn) {
+        std::vector<const RawSeqData*> values;
+        for (auto it = mapping_.begin(); it != mapping_.end(); ++it)
+            values.push_back(it.value());
+
+        std::vector<RawSeqData> updated(values.size() * rawcnt_);
+        std::string key;
+        size_t i = 0;
+        for (auto it = mapping_.begin(); it != mapping_.end(); ++it, ++i) {
+            it.key(key);
+            // Keys are not stored as contiguous strings, so they are resolved sequentially
+            memcpy(updated.data() + i * rawcnt_, key.data(), rawcnt_ * sizeof(RawSeqData));
+        }
+
+#       pragma omp parallel for
+        for (size_t j = 0; j < values.size(); ++j) {
+            const RawSeqData *res = fn(updated.data() + j * rawcnt_, values[j]);
+            memcpy(updated.data() + j * rawcnt_, res, rawcnt_ * sizeof(RawSeqData));
+        }
+
+#       pragma omp parallel for
+        for (size_t j = 0; j < values.size(); ++j)
+            memcpy(const_cast<RawSeqData*>(values[j]), updated.data() + j * rawcnt_, rawcnt_ * sizeof(RawSeqData));
+    }
+
+    void BinWrite(std::ostream &file) const {
+        size_t sz = size();
+        file.write((const char *) &sz, sizeof(sz));
+
+        for (auto iter = begin(); iter != end(); ++iter) {
+            Kmer::BinWrite(file, iter->first);
+            Kmer::BinWrite(file, iter->second);
+        }
+    }
+
+    void BinRead(std::istream &file) {
+        clear();
+
+        size_t size;
+        file.read((char *) &size, sizeof(size));
+        for (uint32_t i = 0; i < size; ++i) {
+            Kmer key(k_);
+            Seq value(k_);
+            Kmer::BinRead(file, &key);
+            Seq::BinRead(file, &value);
+            set(key, value);
+        }
+    }
+
   private:
     unsigned k_;
     unsigned rawcnt_;
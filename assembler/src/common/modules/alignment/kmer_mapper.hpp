@@ -8,6 +8,7 @@
 #pragma once
 
 #include "kmer_map.hpp"
+#include "sharded_kmer_map.hpp"
 
 #include "assembly_graph/core/action_handlers.hpp"
 
@@ -18,7 +19,9 @@
 #include <cstdlib>
 
 namespace debruijn_graph {
-template<class Graph>
+// Map is either KMerMap (HAT-trie, compact for huge maps) or ShardedKMerMap
+// (flat table, faster lookups)
+template<class Graph, class Map = ShardedKMerMap>
 class KmerMapper : public omnigraph::GraphActionHandler<Graph> {
     typedef omnigraph::GraphActionHandler<Graph> base;
     typedef typename Graph::EdgeId EdgeId;
@@ -27,7 +30,7 @@ class KmerMapper : public omnigraph::GraphActionHandler<Graph> {
     typedef typename Seq::DataType RawSeqData;
 
     unsigned k_;
-    KMerMap mapping_;
+    Map mapping_;
     bool normalized_;
 
     bool CheckAllDifferent(const Sequence &old_s, const Sequence &new_s) const {
@@ -67,25 +70,10 @@ public:
         if (normalized_)
             return;
 
-        adt::KMerVector<Kmer> all(k_, size());
-        for (auto it = begin(); it != end(); ++it)
-            all.push_back(it->first);
-
-        std::vector<const RawSeqData*> roots(all.size(), nullptr);
-
-#       pragma omp parallel for
-        for (size_t i = 0; i < all.size(); ++i) {
-            Seq val(k_, all[i]);
-            roots[i] = GetRoot(val);
-        }
-
-#       pragma omp parallel for
-        for (size_t i = 0; i < all.size(); ++i) {
-            if (roots[i] != nullptr) {
-                Seq kmer(k_, all[i]);
-                mapping_.set(kmer, Seq(k_, roots[i]));
-            }
-        }
+        mapping_.parallel_transform([this](const RawSeqData *key, const RawSeqData *value) {
+            const RawSeqData *root = GetRoot(Kmer(k_, key));
+            return root ? root : value;
+        });
 
         normalized_ = true;
     }
@@ -184,27 +172,11 @@ public:
     }
 
     void BinWrite(std::ostream &file) const {
-        size_t sz = size();
-        file.write((const char *) &sz, sizeof(sz));
-
-        for (auto iter = begin(); iter != end(); ++iter) {
-            Kmer::BinWrite(file, iter->first);
-            Kmer::BinWrite(file, iter->second);
-        }
+        mapping_.BinWrite(file);
     }
 
     void BinRead(std::istream &file) {
-        clear();
-
-        size_t size;
-        file.read((char *) &size, sizeof(size));
-        for (uint32_t i = 0; i < size; ++i) {
-            Kmer key(k_);
-            Seq value(k_);
-            Kmer::BinRead(file, &key);
-            Seq::BinRead(file, &value);
-            mapping_.set(key, value);
-        }
+        mapping_.BinRead(file);
         normalized_ = false;
     }
 
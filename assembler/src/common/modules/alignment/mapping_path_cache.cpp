@@ -0,0 +1,193 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "mapping_path_cache.hpp"
+
+#include "utils/verify.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace debruijn_graph {
+
+namespace {
+
+void PutVarint(std::vector<uint8_t> &buf, uint64_t v) {
+    while (v >= 0x80) {
+        buf.push_back(uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    buf.push_back(uint8_t(v));
+}
+
+uint64_t GetVarint(const uint8_t *&p, const uint8_t *end) {
+    uint64_t v = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        VERIFY_MSG(p < end && shift < 64, "Corrupted mapping path cache");
+        uint8_t b = *p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return v;
+    }
+}
+
+uint64_t ZigZag(int64_t v) {
+    return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+
+int64_t UnZigZag(uint64_t v) {
+    return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+// Every mapping is encoded as the delta of edge id (the lowest bit tells
+// whether the quality follows), the gap from the end of previous initial
+// range, the initial range size and the mapped range.
+void EncodePath(std::vector<uint8_t> &buf, const MappingPath<EdgeId> &path) {
+    PutVarint(buf, path.size());
+
+    uint64_t prev_edge = 0;
+    size_t prev_end = 0;
+    for (size_t i = 0; i < path.size(); ++i) {
+        uint64_t edge = path.edge_at(i).int_id();
+        const MappingRange &range = path.mapping_at(i);
+        bool has_quality = (range.quality != 1.0);
+
+        PutVarint(buf, ZigZag(int64_t(edge - prev_edge)) << 1 | has_quality);
+        PutVarint(buf, ZigZag(int64_t(range.initial_range.start_pos - prev_end)));
+        PutVarint(buf, range.initial_range.size());
+        PutVarint(buf, range.mapped_range.start_pos);
+        PutVarint(buf, range.mapped_range.size());
+        if (has_quality) {
+            const uint8_t *q = reinterpret_cast<const uint8_t*>(&range.quality);
+            buf.insert(buf.end(), q, q + sizeof(range.quality));
+        }
+
+        prev_edge = edge;
+        prev_end = range.initial_range.end_pos;
+    }
+}
+
+void DecodePath(const uint8_t *&p, const uint8_t *end, MappingPath<EdgeId> &path) {
+    path = MappingPath<EdgeId>();
+
+    size_t sz = GetVarint(p, end);
+    uint64_t prev_edge = 0;
+    size_t prev_end = 0;
+    for (size_t i = 0; i < sz; ++i) {
+        uint64_t header = GetVarint(p, end);
+        uint64_t edge = prev_edge + uint64_t(UnZigZag(header >> 1));
+        size_t istart = prev_end + size_t(UnZigZag(GetVarint(p, end)));
+        size_t iend = istart + GetVarint(p, end);
+        size_t mstart = GetVarint(p, end);
+        size_t mend = mstart + GetVarint(p, end);
+
+        double quality = 1.0;
+        if (header & 1) {
+            VERIFY_MSG(p + sizeof(quality) <= end, "Corrupted mapping path cache");
+            memcpy(&quality, p, sizeof(quality));
+            p += sizeof(quality);
+        }
+
+        path.push_back(EdgeId(edge), MappingRange(istart, iend, mstart, mend, quality));
+        prev_edge = edge;
+        prev_end = iend;
+    }
+}
+
+}
+
+MappingPathCache::MappingPathCache(fs::TmpDir workdir)
+        : workdir_(workdir), ready_(false) {}
+
+MappingPathCache::~MappingPathCache() {
+    Close();
+}
+
+void MappingPathCache::Close() {
+    for (Stream &stream : streams_) {
+        if (stream.fd != -1)
+            ::close(stream.fd);
+    }
+    streams_.clear();
+    ready_ = false;
+}
+
+void MappingPathCache::Reset(size_t nstreams) {
+    Close();
+
+    streams_ = std::vector<Stream>(nstreams);
+    for (Stream &stream : streams_) {
+        stream.file = workdir_->tmp_file("mapping_paths");
+        const std::string &fname = stream.file->file();
+        stream.fd = ::open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, (mode_t) 0600);
+        CHECK_FATAL_ERROR(stream.fd != -1,
+                          "Cannot open temporary file " << fname << ". Reason: " << strerror(errno) << ". Error code: " << errno);
+    }
+}
+
+void MappingPathCache::Finish() {
+    size_t total = 0;
+    for (const Stream &stream : streams_)
+        total += stream.size;
+    INFO("Mapping paths cached, " << total << " bytes on disk");
+
+    ready_ = true;
+}
+
+void MappingPathCache::Store(size_t idx, size_t chunk, const MappingPath<EdgeId> *paths, size_t cnt) {
+    VERIFY(!ready_);
+    std::vector<uint8_t> buf;
+    for (size_t i = 0; i < cnt; ++i)
+        EncodePath(buf, paths[i]);
+
+    Stream &stream = streams_.at(idx);
+    std::lock_guard<std::mutex> lock(stream.lock);
+
+    const uint8_t *data = buf.data();
+    size_t amount = buf.size();
+    while (amount) {
+        ssize_t res = ::write(stream.fd, data, amount);
+        if (res == -1 && errno == EINTR)
+            continue;
+        CHECK_FATAL_ERROR(res > 0,
+                          "I/O error! Incomplete write to " << stream.file->file() << "! Reason: " << strerror(errno) << ". Error code: " << errno);
+        data += res;
+        amount -= size_t(res);
+    }
+
+    if (stream.chunks.size() <= chunk)
+        stream.chunks.resize(chunk + 1);
+    stream.chunks[chunk] = { stream.size, buf.size(), cnt };
+    stream.size += buf.size();
+}
+
+void MappingPathCache::Load(size_t idx, size_t chunk, MappingPath<EdgeId> *paths, size_t cnt) const {
+    VERIFY(ready_);
+    const Stream &stream = streams_.at(idx);
+    VERIFY_MSG(chunk < stream.chunks.size() && stream.chunks[chunk].paths == cnt,
+               "Reads do not match the mapping path cache");
+
+    const Chunk &c = stream.chunks[chunk];
+    std::vector<uint8_t> buf(c.size);
+    size_t done = 0;
+    while (done < c.size) {
+        ssize_t res = ::pread(stream.fd, buf.data() + done, c.size - done, off_t(c.offset + done));
+        if (res == -1 && errno == EINTR)
+            continue;
+        CHECK_FATAL_ERROR(res > 0,
+                          "I/O error! Incomplete read from " << stream.file->file() << "! Reason: " << strerror(errno) << ". Error code: " << errno);
+        done += size_t(res);
+    }
+
+    const uint8_t *p = buf.data(), *end = p + buf.size();
+    for (size_t i = 0; i < cnt; ++i)
+        DecodePath(p, end, paths[i]);
+    VERIFY_MSG(p == end, "Corrupted mapping path cache");
+}
+
+}
@@ -0,0 +1,82 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/paths/mapping_path.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+namespace debruijn_graph {
+
+using omnigraph::MappingPath;
+using omnigraph::MappingRange;
+
+// On-disk cache of the mapping results for a single read library. The first
+// pass over the library stores the mapping paths of every chunk of reads, the
+// following passes load them instead of mapping the reads again. Chunks are
+// addressed by the stream index and the ordinal of the chunk within the
+// stream, so the library must be read with the same number of streams and the
+// same chunk size every time. Paths are stored as runs of varint-encoded edge
+// id and range deltas, one file per stream.
+class MappingPathCache {
+    struct Chunk {
+        size_t offset = 0;
+        size_t size = 0;
+        size_t paths = 0;
+    };
+
+    struct Stream {
+        fs::TmpFile file;
+        int fd = -1;
+        size_t size = 0;
+        std::vector<Chunk> chunks;
+        std::mutex lock;
+    };
+
+public:
+    explicit MappingPathCache(fs::TmpDir workdir);
+    ~MappingPathCache();
+
+    MappingPathCache(const MappingPathCache &) = delete;
+    MappingPathCache &operator=(const MappingPathCache &) = delete;
+
+    // True when all the chunks of the library are stored
+    bool ready() const { return ready_; }
+
+    // Drops the stored paths and prepares the cache for the given number of streams
+    void Reset(size_t nstreams);
+
+    // Marks the library as completely stored
+    void Finish();
+
+    // Stores the paths of chunk-th chunk of the stream. Chunks of the same
+    // stream could be stored concurrently in any order.
+    void Store(size_t stream, size_t chunk, const MappingPath<EdgeId> *paths, size_t cnt);
+
+    // Loads exactly cnt paths of the chunk, could be called concurrently
+    void Load(size_t stream, size_t chunk, MappingPath<EdgeId> *paths, size_t cnt) const;
+
+    size_t streams() const { return streams_.size(); }
+
+private:
+    void Close();
+
+    fs::TmpDir workdir_;
+    std::vector<Stream> streams_;
+    bool ready_;
+
+    DECL_LOGGER("MappingPathCache");
+};
+
+}
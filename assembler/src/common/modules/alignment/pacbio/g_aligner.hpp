@@ -33,6 +33,8 @@ typedef std::pair<QualityRange, int> ColoredRange;
 class GAligner {
  public:
   OneReadMapping GetReadAlignment(const io::SingleRead &read) const;
+
+  void ReportStats() const { pac_index_.ReportStats(); }
   
   GAligner(const debruijn_graph::Graph &g,
            const GAlignerConfig &cfg)
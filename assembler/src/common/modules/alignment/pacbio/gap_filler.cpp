@@ -29,18 +29,16 @@ GapFillerResult GapFiller::BestScoredPathDijkstra(const string &s,
     GapClosingConfig gap_cfg = cfg_.gap_cfg;
     VertexId start_v = g_.EdgeEnd(start_pos.edgeid);
     VertexId end_v = g_.EdgeStart(end_pos.edgeid);
-    auto path_searcher_b = omnigraph::DijkstraHelper<debruijn_graph::Graph>::
-                                CreateBackwardBoundedDijkstra(g_, path_max_length);
+    auto path_searcher_b = DijkstraHelper::CreateBackwardBoundedDijkstra(g_, path_max_length, size_t(-1), false,
+                                                                         backward_workspaces_.local());
     path_searcher_b.Run(end_v);
-    auto path_searcher = omnigraph::DijkstraHelper<debruijn_graph::Graph>::
-                                CreateBoundedDijkstra(g_, path_max_length);
+    auto path_searcher = DijkstraHelper::CreateBoundedDijkstra(g_, path_max_length, size_t(-1), false,
+                                                               forward_workspaces_.local());
     path_searcher.Run(start_v);
-    const auto &reached_vertices_b = path_searcher_b.ProcessedVertices();
-    const auto &reached_vertices = path_searcher.ProcessedVertices();
 
     unordered_map<VertexId, size_t> vertex_pathlen;
-    for (auto v : reached_vertices_b) {
-        if (reached_vertices.count(v) > 0) {
+    for (auto v : path_searcher_b.ProcessedVertices()) {
+        if (path_searcher.VertexProcessed(v)) {
             vertex_pathlen[v] = path_searcher_b.GetDistance(v);
         }
     }
@@ -119,8 +119,13 @@ class GapFiller {
                     std::vector<EdgeId> &ans,
                     MappingPoint p, PathRange &range, bool forward, GraphPosition &old_start_pos) const;
 
+    typedef omnigraph::DijkstraHelper<debruijn_graph::Graph> DijkstraHelper;
+
     const debruijn_graph::Graph &g_;
     const GAlignerConfig &cfg_;
+    // Both searches of BestScoredPathDijkstra are alive at once
+    mutable omnigraph::ThreadWorkspaces<DijkstraHelper::BackwardBoundedDijkstra::Workspace> backward_workspaces_;
+    mutable omnigraph::ThreadWorkspaces<DijkstraHelper::BoundedDijkstra::Workspace> forward_workspaces_;
 };
 
 
@@ -11,6 +11,7 @@
 #include <vector>
 #include <set>
 
+#include "adt/concurrent_cache.hpp"
 #include "assembly_graph/index/edge_multi_index.hpp"
 #include "assembly_graph/graph_support/basic_vertex_conditions.hpp"
 
@@ -39,6 +40,7 @@ class PacBioMappingIndex {
                        debruijn_graph::config::pacbio_processor pb_config,
                        alignment::BWAIndex::AlignmentMode mode)
         : g_(g),
+          distance_cache_(DISTANCE_CACHE_SIZE),
           pb_config_(pb_config),
           bwa_mapper_(g, mode) {
         DEBUG("PB Mapping Index construction started");
@@ -79,6 +81,13 @@ class PacBioMappingIndex {
         return res;
     }
 
+    void ReportStats() const {
+        auto stats = distance_cache_.stats();
+        INFO("Distance cache: " << stats.size << " vertex pairs, "
+             << stats.hits << " hits, " << stats.misses << " misses, "
+             << stats.evictions << " evictions");
+    }
+
   private:
     DECL_LOGGER("PacIndex")
 
@@ -86,8 +95,11 @@ class PacBioMappingIndex {
 
     static const size_t SHORT_SPURIOUS_LENGTH = 500;
     static const int SIMILARITY_LENGTH = 200;
-    //presumably separate class for this and GetDistance
-    mutable std::map<std::pair<VertexId, VertexId>, size_t> distance_cashed_;
+    // Vertex pairs cached by GetDistance
+    static const size_t DISTANCE_CACHE_SIZE = size_t(1) << 21;
+
+    mutable adt::concurrent_cache<std::pair<VertexId, VertexId>, size_t> distance_cache_;
+    mutable omnigraph::ThreadWorkspaces<omnigraph::DijkstraHelper<debruijn_graph::Graph>::BoundedDijkstra::Workspace> dijkstra_workspaces_;
     size_t read_count_;
     debruijn_graph::config::pacbio_processor pb_config_;
 
@@ -355,33 +367,24 @@ class PacBioMappingIndex {
 
     size_t GetDistance(VertexId start_v, VertexId end_v,
                        bool update_cache = true) const {
-        size_t result = size_t(-1);
         auto vertex_pair = std::make_pair(start_v, end_v);
-        bool not_found;
-        auto distance_it = distance_cashed_.begin();
-        //FIXME should permit multiple readers
-        #pragma omp critical(pac_index)
-        {
-            distance_it = distance_cashed_.find(vertex_pair);
-            not_found = (distance_it == distance_cashed_.end());
+        size_t result = size_t(-1);
+        if (distance_cache_.find(vertex_pair, result)) {
+            TRACE("taking from cache");
+            return result;
         }
-        if (not_found) {
-            omnigraph::DijkstraHelper<debruijn_graph::Graph>::BoundedDijkstra dijkstra(
-                omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_,
-                        pb_config_.max_path_in_dijkstra,
-                        pb_config_.max_vertex_in_dijkstra));
-            dijkstra.Run(start_v);
-            if (dijkstra.DistanceCounted(end_v)) {
-                result = dijkstra.GetDistance(end_v);
-            }
-            if (update_cache) {
-                #pragma omp critical(pac_index)
-                distance_cashed_.insert({vertex_pair, result});
-            }
-        } else {
-            TRACE("taking from cashed");
-            result = distance_it->second;
+
+        omnigraph::DijkstraHelper<debruijn_graph::Graph>::BoundedDijkstra dijkstra(
+            omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_,
+                    pb_config_.max_path_in_dijkstra,
+                    pb_config_.max_vertex_in_dijkstra, false,
+                    dijkstra_workspaces_.local()));
+        dijkstra.Run(start_v);
+        if (dijkstra.DistanceCounted(end_v)) {
+            result = dijkstra.GetDistance(end_v);
         }
+        if (update_cache)
+            distance_cache_.insert(vertex_pair, result);
 
         return result;
     }
@@ -13,6 +13,7 @@
 #include "io/reads/single_read.hpp"
 
 #include "sequence/sequence_tools.hpp"
+#include "sequence/kmer_extractor.hpp"
 #include "pipeline/graph_pack.hpp"
 
 #include "kmer_mapper.hpp"
@@ -299,9 +300,50 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
   size_t k_;
   bool optimization_on_;
 
-  bool FindKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed,
+  typedef std::pair<EdgeId, size_t> KmerPosition;
+
+  // Index lookups of the consecutive k-mers are issued in batches (see
+  // EdgeIndex::get). The batch grows while the lookups are required at
+  // every position (e.g. in unmapped regions of the read) and shrinks back
+  // as soon as threading succeeds, so the reads that thread well do not do
+  // any extra lookups. The k-mers are taken from the block extracted by
+  // MapSequence, a window never crosses the block end.
+  struct LookupWindow {
+      static constexpr size_t MAX_SIZE = 32;
+
+      const Kmer *block = nullptr;
+      size_t block_start = 0, block_size = 0;
+
+      KmerPosition positions[MAX_SIZE];
+      size_t start = 0, size = 0;
+      size_t last_lookup = -1ULL;
+  };
+
+  void FillWindow(size_t kmer_pos, LookupWindow &window) const {
+      size_t size = 1;
+      if (window.size && kmer_pos == window.last_lookup + 1)
+          size = std::min(2 * window.size, size_t(LookupWindow::MAX_SIZE));
+      size = std::min(size, window.block_start + window.block_size - kmer_pos);
+
+      index_.get(window.block + (kmer_pos - window.block_start), size, window.positions);
+
+      window.start = kmer_pos;
+      window.size = size;
+  }
+
+  KmerPosition Lookup(const Kmer &kmer, size_t kmer_pos, LookupWindow &window) const {
+      if (kmer_mapper_.CanSubstitute(kmer))
+          return index_.get(kmer_mapper_.Substitute(kmer));
+
+      if (kmer_pos < window.start || kmer_pos >= window.start + window.size)
+          FillWindow(kmer_pos, window);
+      window.last_lookup = kmer_pos;
+
+      return window.positions[kmer_pos - window.start];
+  }
+
+  bool FindKmer(const KmerPosition &position, size_t kmer_pos, std::vector<EdgeId> &passed,
                 RangeMappings& range_mappings) const {
-    const auto& position = index_.get(kmer);
     if (position.second == Index::NOT_FOUND)
         return false;
     
@@ -351,11 +393,12 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
     return false;
   }
 
-  bool ProcessKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed_edges,
-                   RangeMappings& range_mapping, bool try_thread) const {
+  bool ProcessKmer(const Kmer &kmer, size_t kmer_pos,
+                   std::vector<EdgeId> &passed_edges, RangeMappings& range_mapping,
+                   bool try_thread, LookupWindow &window) const {
     if (try_thread) {
         if (!TryThread(kmer, kmer_pos, passed_edges, range_mapping)) {
-            FindKmer(kmer_mapper_.Substitute(kmer), kmer_pos, passed_edges, range_mapping);
+            FindKmer(Lookup(kmer, kmer_pos, window), kmer_pos, passed_edges, range_mapping);
             return false;
         }
 
@@ -363,11 +406,11 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
     }
 
     if (kmer_mapper_.CanSubstitute(kmer)) {
-        FindKmer(kmer_mapper_.Substitute(kmer), kmer_pos, passed_edges, range_mapping);
+        FindKmer(index_.get(kmer_mapper_.Substitute(kmer)), kmer_pos, passed_edges, range_mapping);
         return false;
     }
 
-    return FindKmer(kmer, kmer_pos, passed_edges, range_mapping);
+    return FindKmer(Lookup(kmer, kmer_pos, window), kmer_pos, passed_edges, range_mapping);
   }
 
  public:
@@ -388,16 +431,23 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
       return MappingPath<EdgeId>();
     }
 
-    Kmer kmer = sequence.start<Kmer>(k_);
+    KMerExtractor &extractor = KMerExtractor::local(unsigned(k_));
+    size_t nkmers = extractor.reset(sequence);
+    LookupWindow window;
+    Kmer kmers[KMerExtractor::BATCH_SIZE];
     bool try_thread = false;
-    try_thread = ProcessKmer(kmer, 0, passed_edges,
-                             range_mapping, try_thread);
-    for (size_t i = k_; i < sequence.size(); ++i) {
-      kmer <<= sequence[i];
-      try_thread = ProcessKmer(kmer, i - k_ + 1, passed_edges,
-                               range_mapping, try_thread);
-      if (only_simple && passed_edges.size() > 1)
-        return MappingPath<EdgeId>();
+    for (size_t from = 0; from < nkmers; from += KMerExtractor::BATCH_SIZE) {
+      size_t cnt = std::min(size_t(KMerExtractor::BATCH_SIZE), nkmers - from);
+      extractor.kmers(from, cnt, kmers);
+      window.block = kmers;
+      window.block_start = from;
+      window.block_size = cnt;
+      for (size_t i = 0; i < cnt; ++i) {
+        try_thread = ProcessKmer(kmers[i], from + i, passed_edges,
+                                 range_mapping, try_thread, window);
+        if (only_simple && passed_edges.size() > 1)
+          return MappingPath<EdgeId>();
+      }
     }
 
     return MappingPath<EdgeId>(passed_edges, range_mapping);
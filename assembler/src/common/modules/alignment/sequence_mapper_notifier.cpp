@@ -39,59 +39,80 @@ void SequenceMapperNotifier::NotifyMergeBuffer(size_t ilib, size_t ithread) cons
         listener->MergeBuffer(ithread);
 }
 
+template<>
+void SequenceMapperNotifier::MapRead(const io::PairedReadSeq& r,
+                                     const SequenceMapperT& mapper,
+                                     MappingPath<EdgeId> *paths) const {
+    paths[0] = mapper.MapSequence(r.first().sequence());
+    paths[1] = mapper.MapSequence(r.second().sequence());
+}
+
+template<>
+void SequenceMapperNotifier::MapRead(const io::PairedRead& r,
+                                     const SequenceMapperT& mapper,
+                                     MappingPath<EdgeId> *paths) const {
+    paths[0] = mapper.MapRead(r.first());
+    paths[1] = mapper.MapRead(r.second());
+}
+
+template<>
+void SequenceMapperNotifier::MapRead(const io::SingleReadSeq& r,
+                                     const SequenceMapperT& mapper,
+                                     MappingPath<EdgeId> *paths) const {
+    paths[0] = mapper.MapSequence(r.sequence());
+}
+
+template<>
+void SequenceMapperNotifier::MapRead(const io::SingleRead& r,
+                                     const SequenceMapperT& mapper,
+                                     MappingPath<EdgeId> *paths) const {
+    paths[0] = mapper.MapRead(r);
+}
+
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::PairedReadSeq& r,
-                                               const SequenceMapperT& mapper,
+                                               const MappingPath<EdgeId> *paths,
                                                size_t ilib,
                                                size_t ithread) const
 {
-    const Sequence& read1 = r.first().sequence();
-    const Sequence& read2 = r.second().sequence();
-    MappingPath<EdgeId> path1 = mapper.MapSequence(read1);
-    MappingPath<EdgeId> path2 = mapper.MapSequence(read2);
     for (const auto& listener : listeners_[ilib]) {
-        listener->ProcessPairedRead(ithread, r, path1, path2);
-        listener->ProcessSingleRead(ithread, r.first(), path1);
-        listener->ProcessSingleRead(ithread, r.second(), path2);
+        listener->ProcessPairedRead(ithread, r, paths[0], paths[1]);
+        listener->ProcessSingleRead(ithread, r.first(), paths[0]);
+        listener->ProcessSingleRead(ithread, r.second(), paths[1]);
     }
 }
 
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::PairedRead& r,
-                                               const SequenceMapperT& mapper,
+                                               const MappingPath<EdgeId> *paths,
                                                size_t ilib,
                                                size_t ithread) const
 {
-    MappingPath<EdgeId> path1 = mapper.MapRead(r.first());
-    MappingPath<EdgeId> path2 = mapper.MapRead(r.second());
     for (const auto& listener : listeners_[ilib]) {
-        listener->ProcessPairedRead(ithread, r, path1, path2);
-        listener->ProcessSingleRead(ithread, r.first(), path1);
-        listener->ProcessSingleRead(ithread, r.second(), path2);
+        listener->ProcessPairedRead(ithread, r, paths[0], paths[1]);
+        listener->ProcessSingleRead(ithread, r.first(), paths[0]);
+        listener->ProcessSingleRead(ithread, r.second(), paths[1]);
     }
 }
 
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::SingleReadSeq& r,
-                                               const SequenceMapperT& mapper,
+                                               const MappingPath<EdgeId> *paths,
                                                size_t ilib,
                                                size_t ithread) const
 {
-    const Sequence& read = r.sequence();
-    MappingPath<EdgeId> path = mapper.MapSequence(read);
     for (const auto& listener : listeners_[ilib])
-        listener->ProcessSingleRead(ithread, r, path);
+        listener->ProcessSingleRead(ithread, r, paths[0]);
 }
 
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::SingleRead& r,
-                                               const SequenceMapperT& mapper,
+                                               const MappingPath<EdgeId> *paths,
                                                size_t ilib,
                                                size_t ithread) const
 {
-    MappingPath<EdgeId> path = mapper.MapRead(r);
     for (const auto& listener : listeners_[ilib])
-        listener->ProcessSingleRead(ithread, r, path);
+        listener->ProcessSingleRead(ithread, r, paths[0]);
 }
 
 } // namespace debruijn_graph
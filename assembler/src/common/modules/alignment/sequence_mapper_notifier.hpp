@@ -9,6 +9,7 @@
 #define SEQUENCE_MAPPER_NOTIFIER_HPP_
 
 #include "sequence_mapper.hpp"
+#include "mapping_path_cache.hpp"
 
 #include "assembly_graph/paths/mapping_path.hpp"
 #include "assembly_graph/core/graph.hpp"
@@ -17,7 +18,16 @@
 
 #include "utils/perf/timetracer.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace debruijn_graph {
@@ -41,7 +51,7 @@ public:
 };
 
 class SequenceMapperNotifier {
-    static constexpr size_t BUFFER_SIZE = 200000;
+    static constexpr size_t CHUNK_SIZE = 1 << 14;
 public:
     typedef SequenceMapper<Graph> SequenceMapperT;
 
@@ -51,54 +61,233 @@ public:
 
     void Subscribe(size_t lib_index, SequenceMapperListener* listener);
 
+    // Streams are cut into chunks of reads. Any idle worker takes the next
+    // chunk of the streams in (chunk, stream) order, different streams are read
+    // concurrently. A chunk is processed into a listener buffer of its own and
+    // a dedicated merger thread merges the buffers in the same order, so the
+    // result does not depend on the timing or on the number of threads. One of
+    // threads_count threads (if there are several) is the merger, the rest map
+    // the reads, regardless of the number of streams.
     template<class ReadType>
     void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
                         size_t lib_index, const SequenceMapperT& mapper, size_t threads_count = 0) {
+        ProcessLibrary(streams, lib_index, mapper, nullptr, threads_count);
+    }
+
+    // Same as above, but the mapping paths are taken from the cache if it is
+    // ready. Otherwise the reads are mapped and the paths are stored into it.
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const SequenceMapperT& mapper,
+                        MappingPathCache &cache, size_t threads_count = 0) {
+        ProcessLibrary(streams, lib_index, mapper, &cache, threads_count);
+    }
+
+private:
+    template<class ReadType>
+    static constexpr size_t PathsPerRead() {
+        return (std::is_same<ReadType, io::PairedRead>::value ||
+                std::is_same<ReadType, io::PairedReadSeq>::value) ? 2 : 1;
+    }
+
+    // Chunk of a stream taken by a worker together with the listener buffer
+    struct Ticket {
+        size_t seq, stream, chunk, buffer, reads;
+    };
+
+    // Per-stream chunk queues shared by the workers and the merger
+    class ChunkQueue {
+    public:
+        ChunkQueue(size_t streams, size_t buffers)
+                : streams_(streams), taken_(streams, 0), exhausted_(streams, false),
+                  live_(streams), cursor_(0), next_seq_(0), closed_(false) {
+            for (size_t i = 0; i < buffers; ++i)
+                free_buffers_.push_back(i);
+        }
+
+        // Waits for a free buffer and reserves the next chunk of the streams
+        // which are not known to be exhausted. Returns false if there are none.
+        bool Take(Ticket &ticket) {
+            std::unique_lock<std::mutex> lock(lock_);
+            buffer_freed_.wait(lock, [&] { return !free_buffers_.empty(); });
+            if (!live_)
+                return false;
+
+            while (exhausted_[cursor_])
+                cursor_ = (cursor_ + 1) % streams_.size();
+
+            ticket.seq = next_seq_++;
+            ticket.stream = cursor_;
+            ticket.chunk = taken_[cursor_]++;
+            ticket.buffer = free_buffers_.back();
+            ticket.reads = 0;
+            free_buffers_.pop_back();
+            cursor_ = (cursor_ + 1) % streams_.size();
+            return true;
+        }
+
+        // Reads the reserved chunk once the preceding chunks of the stream are read
+        template<class ReadType>
+        size_t Read(io::ReadStreamList<ReadType>& streams, const Ticket &ticket,
+                    std::vector<ReadType> &chunk) {
+            StreamState &state = streams_[ticket.stream];
+            std::unique_lock<std::mutex> lock(state.lock);
+            state.turn_changed.wait(lock, [&] { return state.read == ticket.chunk; });
+
+            auto &stream = streams[ticket.stream];
+            size_t cnt = 0;
+            while (cnt < chunk.size() && !stream.eof())
+                stream >> chunk[cnt++];
+            if (stream.eof()) {
+                std::lock_guard<std::mutex> queue_lock(lock_);
+                if (!exhausted_[ticket.stream]) {
+                    exhausted_[ticket.stream] = true;
+                    live_ -= 1;
+                }
+            }
+
+            state.read += 1;
+            state.turn_changed.notify_all();
+            return cnt;
+        }
+
+        // Passes the buffer of the processed chunk to the merger
+        void Done(const Ticket &ticket) {
+            std::lock_guard<std::mutex> lock(lock_);
+            done_.emplace(ticket.seq, ticket);
+            chunk_done_.notify_one();
+        }
+
+        // Called once all the workers are finished
+        void Close() {
+            std::lock_guard<std::mutex> lock(lock_);
+            closed_ = true;
+            chunk_done_.notify_one();
+        }
+
+        // Calls merge(buffer) for the non-empty chunks in the order they were
+        // taken and returns the buffers to the workers
+        template<class MergeF>
+        void Merge(MergeF merge) {
+            std::unique_lock<std::mutex> lock(lock_);
+            for (size_t seq = 0; ; ++seq) {
+                chunk_done_.wait(lock, [&] { return done_.count(seq) || (closed_ && seq == next_seq_); });
+                auto it = done_.find(seq);
+                if (it == done_.end())
+                    break;
+
+                Ticket ticket = it->second;
+                done_.erase(it);
+                if (ticket.reads) {
+                    lock.unlock();
+                    merge(ticket.buffer);
+                    lock.lock();
+                }
+                free_buffers_.push_back(ticket.buffer);
+                buffer_freed_.notify_one();
+            }
+        }
+
+    private:
+        struct StreamState {
+            std::mutex lock;
+            std::condition_variable turn_changed;
+            // Number of chunks read from the stream
+            size_t read = 0;
+        };
+
+        std::vector<StreamState> streams_;
+
+        std::mutex lock_;
+        std::condition_variable buffer_freed_, chunk_done_;
+        std::vector<size_t> taken_;
+        std::vector<uint8_t> exhausted_;
+        size_t live_, cursor_, next_seq_;
+        bool closed_;
+        std::vector<size_t> free_buffers_;
+        // Processed chunks waiting for the merge, by the order they were taken
+        std::map<size_t, Ticket> done_;
+    };
+
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const SequenceMapperT& mapper,
+                        MappingPathCache *cache, size_t threads_count) {
         std::string lib_str = std::to_string(lib_index);
         TIME_TRACE_SCOPE("SequenceMapperNotifier::ProcessLibrary", lib_str);
         if (threads_count == 0)
-            threads_count = streams.size();
+            threads_count = omp_get_max_threads();
+
+        size_t nworkers = std::max<size_t>(threads_count, 2) - 1;
+        // Every worker could wait for the merge of a chunk taken before its own
+        size_t nbuffers = 2 * nworkers;
 
         streams.reset();
-        NotifyStartProcessLibrary(lib_index, threads_count);
-        size_t counter = 0, n = 15;
-
-        #pragma omp parallel for num_threads(threads_count) shared(counter)
-        for (size_t i = 0; i < streams.size(); ++i) {
-            size_t size = 0;
-            ReadType r;
-            auto& stream = streams[i];
-            while (!stream.eof()) {
-                if (size == BUFFER_SIZE) {
-                    #pragma omp critical
-                    {
-                        counter += size;
-                        if (counter >> n) {
-                            INFO("Processed " << counter << " reads");
-                            n += 1;
-                        }
-                        size = 0;
-                        NotifyMergeBuffer(lib_index, i);
+        NotifyStartProcessLibrary(lib_index, nbuffers);
+
+        size_t nstreams = streams.size();
+        bool replay = cache && cache->ready();
+        if (replay) {
+            VERIFY(cache->streams() == nstreams);
+            INFO("Using cached mapping paths");
+        } else if (cache)
+            cache->Reset(nstreams);
+
+        const size_t npaths = PathsPerRead<ReadType>();
+        ChunkQueue queue(nstreams, nbuffers);
+        std::atomic<size_t> counter(0), next_report(1 << 15);
+
+        std::thread merger([&] {
+            queue.Merge([&](size_t buffer) { NotifyMergeBuffer(lib_index, buffer); });
+        });
+
+        #pragma omp parallel num_threads(nworkers)
+        {
+            std::vector<ReadType> chunk(CHUNK_SIZE);
+            std::vector<MappingPath<EdgeId>> paths(npaths * CHUNK_SIZE);
+            Ticket ticket;
+            while (queue.Take(ticket)) {
+                size_t cnt = queue.Read(streams, ticket, chunk);
+                if (cnt) {
+                    if (replay)
+                        cache->Load(ticket.stream, ticket.chunk, paths.data(), npaths * cnt);
+                    else {
+                        for (size_t i = 0; i < cnt; ++i)
+                            MapRead(chunk[i], mapper, &paths[npaths * i]);
+                        if (cache)
+                            cache->Store(ticket.stream, ticket.chunk, paths.data(), npaths * cnt);
                     }
+
+                    for (size_t i = 0; i < cnt; ++i)
+                        NotifyProcessRead(chunk[i], &paths[npaths * i], lib_index, ticket.buffer);
+
+                    size_t total = (counter += cnt);
+                    size_t report = next_report;
+                    if (total >= report && next_report.compare_exchange_strong(report, 2 * report))
+                        INFO("Processed " << total << " reads");
                 }
-                stream >> r;
-                ++size;
-                NotifyProcessRead(r, mapper, lib_index, i);
+
+                ticket.reads = cnt;
+                queue.Done(ticket);
             }
-            #pragma omp atomic
-            counter += size;
         }
 
-        for (size_t i = 0; i < threads_count; ++i)
-            NotifyMergeBuffer(lib_index, i);
+        queue.Close();
+        merger.join();
+
+        if (cache && !replay)
+            cache->Finish();
 
         INFO("Total " << counter << " reads processed");
         NotifyStopProcessLibrary(lib_index);
     }
 
-private:
+    // Writes PathsPerRead<ReadType>() mapping paths of the read
+    template<class ReadType>
+    void MapRead(const ReadType& r, const SequenceMapperT& mapper, MappingPath<EdgeId> *paths) const;
+
     template<class ReadType>
-    void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, size_t ilib, size_t ithread) const;
+    void NotifyProcessRead(const ReadType& r, const MappingPath<EdgeId> *paths, size_t ilib, size_t ithread) const;
 
     void NotifyStartProcessLibrary(size_t ilib, size_t thread_count) const;
 
@@ -0,0 +1,385 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "sequence/rtseq.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
+
+#include <folly/SmallLocks.h>
+#include <boost/iterator/iterator_facade.hpp>
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <vector>
+#include <cstring>
+
+namespace debruijn_graph {
+
+// K-mer -> k-mer map stored as a set of open addressing tables with inline
+// fixed-width keys and values. The table is sharded by the high bits of the
+// key hash. Lookups do not take any locks and could run concurrently with each
+// other, updates lock only the shard they touch. Lookups must not run
+// concurrently with updates of the same shard: pointers to values stay valid
+// only until the next update of the shard.
+// Collisions are resolved by Robin Hood linear probing with ties broken by the
+// key, and a shard grows to the smallest capacity that fits its size. So
+// unless entries were erased (erase never shrinks a shard), the layout (and the
+// iteration order) depends only on the set of keys, not on the order of
+// insertions; e.g. a loaded map iterates exactly as the saved one.
+class ShardedKMerMap {
+    typedef RtSeq Kmer;
+    typedef RtSeq Seq;
+    typedef typename Seq::DataType RawSeqData;
+    // Key followed by the value
+    typedef std::array<RawSeqData, 2 * Seq::DataSize> Entry;
+
+    static constexpr unsigned SHARD_BITS = 6;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    enum SlotState : uint8_t { EMPTY = 0, FULL = 1 };
+
+    struct Shard {
+        std::vector<uint8_t> state;
+        // Key followed by the value for every slot
+        std::vector<RawSeqData> data;
+        size_t size = 0;
+        folly::MicroSpinLock lock;
+
+        Shard() { lock.init(); }
+
+        size_t capacity() const { return state.size(); }
+    };
+
+    class iterator : public boost::iterator_facade<iterator,
+                                                   const std::pair<Kmer, Seq>,
+                                                   std::forward_iterator_tag,
+                                                   const std::pair<Kmer, Seq>> {
+      public:
+        iterator(const ShardedKMerMap &map, size_t shard, size_t slot)
+                : map_(&map), shard_(shard), slot_(slot) {
+            skip_empty();
+        }
+
+      private:
+        friend class boost::iterator_core_access;
+
+        void skip_empty() {
+            while (shard_ < map_->shards_.size()) {
+                const Shard &shard = map_->shards_[shard_];
+                while (slot_ < shard.capacity() && shard.state[slot_] != FULL)
+                    slot_ += 1;
+                if (slot_ < shard.capacity())
+                    return;
+                shard_ += 1;
+                slot_ = 0;
+            }
+        }
+
+        void increment() {
+            slot_ += 1;
+            skip_empty();
+        }
+
+        bool equal(const iterator &other) const {
+            return shard_ == other.shard_ && slot_ == other.slot_;
+        }
+
+        const std::pair<Kmer, Seq> dereference() const {
+            const RawSeqData *key = map_->key(map_->shards_[shard_], slot_);
+            return std::make_pair(Kmer(map_->k_, key), Seq(map_->k_, key + map_->rawcnt_));
+        }
+
+        const ShardedKMerMap *map_;
+        size_t shard_;
+        size_t slot_;
+    };
+
+  public:
+    ShardedKMerMap(unsigned k)
+            : k_(k), rawcnt_((unsigned)Seq::GetDataSize(k)), shards_(size_t(1) << SHARD_BITS) {}
+
+    ShardedKMerMap(const ShardedKMerMap &) = delete;
+    ShardedKMerMap &operator=(const ShardedKMerMap &) = delete;
+
+    void erase(const Kmer &key) {
+        Shard &shard = shard_of(key.data());
+        std::lock_guard<folly::MicroSpinLock> guard(shard.lock);
+
+        size_t slot = lookup(shard, key.data());
+        if (slot == -1ULL)
+            return;
+
+        // Shift the rest of the cluster back
+        size_t mask = shard.capacity() - 1;
+        for (size_t next = (slot + 1) & mask;
+             shard.state[next] == FULL && displacement(shard, next) != 0;
+             slot = next, next = (next + 1) & mask)
+            memcpy(this->key(shard, slot), this->key(shard, next), 2 * rawcnt_ * sizeof(RawSeqData));
+
+        shard.state[slot] = EMPTY;
+        shard.size -= 1;
+    }
+
+    void set(const Kmer &key, const Seq &value) {
+        Shard &shard = shard_of(key.data());
+        std::lock_guard<folly::MicroSpinLock> guard(shard.lock);
+
+        size_t slot = lookup(shard, key.data());
+        if (slot != -1ULL) {
+            memcpy(this->value(shard, slot), value.data(), rawcnt_ * sizeof(RawSeqData));
+            return;
+        }
+
+        if (capacity_for(shard.size + 1) > shard.capacity())
+            rehash(shard, capacity_for(shard.size + 1));
+        Entry entry;
+        std::copy(key.data(), key.data() + rawcnt_, entry.begin());
+        std::copy(value.data(), value.data() + rawcnt_, entry.begin() + rawcnt_);
+        insert(shard, entry.data());
+    }
+
+    bool count(const Kmer &key) const {
+        return find(key.data()) != nullptr;
+    }
+
+    const RawSeqData *find(const Kmer &key) const {
+        return find(key.data());
+    }
+
+    const RawSeqData *find(const RawSeqData *key) const {
+        const Shard &shard = shard_of(key);
+        size_t slot = lookup(shard, key);
+        return slot == -1ULL ? nullptr : value(shard, slot);
+    }
+
+    void clear() {
+        for (auto &shard : shards_) {
+            shard.state.clear();
+            shard.state.shrink_to_fit();
+            shard.data.clear();
+            shard.data.shrink_to_fit();
+            shard.size = 0;
+        }
+    }
+
+    size_t size() const {
+        size_t res = 0;
+        for (const auto &shard : shards_)
+            res += shard.size;
+        return res;
+    }
+
+    iterator begin() const {
+        return iterator(*this, 0, 0);
+    }
+
+    iterator end() const {
+        return iterator(*this, shards_.size(), 0);
+    }
+
+    // Replaces every value with the result of fn(key, value). The values are
+    // computed for all the entries first and are assigned afterwards, so fn
+    // might look up the map itself.
+    template<class F>
+    void parallel_transform(F fn) {
+        std::vector<std::vector<RawSeqData>> updated(shards_.size());
+
+#       pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            const Shard &shard = shards_[i];
+            auto &values = updated[i];
+            values.reserve(shard.size * rawcnt_);
+            for (size_t slot = 0; slot < shard.capacity(); ++slot) {
+                if (shard.state[slot] != FULL)
+                    continue;
+                const RawSeqData *res = fn(key(shard, slot), value(shard, slot));
+                values.insert(values.end(), res, res + rawcnt_);
+            }
+        }
+
+#       pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            Shard &shard = shards_[i];
+            const RawSeqData *res = updated[i].data();
+            for (size_t slot = 0; slot < shard.capacity(); ++slot) {
+                if (shard.state[slot] != FULL)
+                    continue;
+                memcpy(value(shard, slot), res, rawcnt_ * sizeof(RawSeqData));
+                res += rawcnt_;
+            }
+            updated[i] = std::vector<RawSeqData>();
+        }
+    }
+
+    // Number of entries followed by raw key / value pairs
+    void BinWrite(std::ostream &file) const {
+        size_t sz = size();
+        file.write((const char *) &sz, sizeof(sz));
+
+        std::vector<RawSeqData> buf;
+        for (const auto &shard : shards_) {
+            buf.clear();
+            for (size_t slot = 0; slot < shard.capacity(); ++slot) {
+                if (shard.state[slot] == FULL)
+                    buf.insert(buf.end(), key(shard, slot), key(shard, slot) + 2 * rawcnt_);
+            }
+            file.write((const char *) buf.data(), buf.size() * sizeof(RawSeqData));
+        }
+    }
+
+    void BinRead(std::istream &file) {
+        clear();
+
+        size_t sz;
+        file.read((char *) &sz, sizeof(sz));
+
+        // Entries of every chunk are bucketed by shard, then every shard is
+        // filled by a single thread
+        const size_t chunk = 1 << 20;
+        std::vector<RawSeqData> buf;
+        std::vector<uint8_t> shard_idx;
+        std::vector<uint32_t> order;
+        std::vector<size_t> starts(shards_.size() + 1);
+        for (size_t read = 0; read < sz; ) {
+            size_t cnt = std::min(chunk, sz - read);
+            buf.resize(cnt * 2 * rawcnt_);
+            file.read((char *) buf.data(), buf.size() * sizeof(RawSeqData));
+
+            shard_idx.resize(cnt);
+#           pragma omp parallel for
+            for (size_t i = 0; i < cnt; ++i)
+                shard_idx[i] = uint8_t(hash(buf.data() + i * 2 * rawcnt_, rawcnt_) >> (64 - SHARD_BITS));
+
+            std::fill(starts.begin(), starts.end(), 0);
+            for (size_t i = 0; i < cnt; ++i)
+                starts[shard_idx[i] + 1] += 1;
+            for (size_t j = 1; j < starts.size(); ++j)
+                starts[j] += starts[j - 1];
+            order.resize(cnt);
+            {
+                std::vector<size_t> pos(starts.begin(), starts.end() - 1);
+                for (size_t i = 0; i < cnt; ++i)
+                    order[pos[shard_idx[i]]++] = uint32_t(i);
+            }
+
+#           pragma omp parallel for schedule(dynamic)
+            for (size_t j = 0; j < shards_.size(); ++j) {
+                for (size_t p = starts[j]; p < starts[j + 1]; ++p) {
+                    const RawSeqData *entry = buf.data() + order[p] * 2 * rawcnt_;
+                    set(Kmer(k_, entry), Seq(k_, entry + rawcnt_));
+                }
+            }
+            read += cnt;
+        }
+    }
+
+  private:
+    static size_t hash(const RawSeqData *key, unsigned rawcnt) {
+        return XXH3_64bits(key, rawcnt * sizeof(RawSeqData));
+    }
+
+    Shard &shard_of(const RawSeqData *key) {
+        return shards_[hash(key, rawcnt_) >> (64 - SHARD_BITS)];
+    }
+
+    const Shard &shard_of(const RawSeqData *key) const {
+        return shards_[hash(key, rawcnt_) >> (64 - SHARD_BITS)];
+    }
+
+    RawSeqData *key(Shard &shard, size_t slot) const {
+        return shard.data.data() + slot * 2 * rawcnt_;
+    }
+
+    const RawSeqData *key(const Shard &shard, size_t slot) const {
+        return shard.data.data() + slot * 2 * rawcnt_;
+    }
+
+    RawSeqData *value(Shard &shard, size_t slot) const {
+        return key(shard, slot) + rawcnt_;
+    }
+
+    const RawSeqData *value(const Shard &shard, size_t slot) const {
+        return key(shard, slot) + rawcnt_;
+    }
+
+    // Distance from the home slot of the entry in the slot
+    size_t displacement(const Shard &shard, size_t slot) const {
+        return (slot - hash(key(shard, slot), rawcnt_)) & (shard.capacity() - 1);
+    }
+
+    // Returns the slot holding the key or -1ULL
+    size_t lookup(const Shard &shard, const RawSeqData *k) const {
+        if (!shard.size)
+            return -1ULL;
+
+        size_t mask = shard.capacity() - 1;
+        for (size_t slot = hash(k, rawcnt_) & mask; ; slot = (slot + 1) & mask) {
+            if (shard.state[slot] == EMPTY)
+                return -1ULL;
+            if (std::equal(k, k + rawcnt_, key(shard, slot)))
+                return slot;
+        }
+    }
+
+    // Inserts the key / value pair, the key must not be present. The entry
+    // buffer is used as a scratch space.
+    void insert(Shard &shard, RawSeqData *entry) const {
+        size_t mask = shard.capacity() - 1;
+        size_t slot = hash(entry, rawcnt_) & mask;
+        for (size_t dist = 0; shard.state[slot] == FULL; slot = (slot + 1) & mask, ++dist) {
+            // Entries farther from home go first, equally far ones are ordered by the key
+            RawSeqData *cur = key(shard, slot);
+            size_t cur_dist = displacement(shard, slot);
+            if (cur_dist < dist ||
+                (cur_dist == dist && std::lexicographical_compare(entry, entry + rawcnt_, cur, cur + rawcnt_))) {
+                std::swap_ranges(entry, entry + 2 * rawcnt_, cur);
+                dist = cur_dist;
+            }
+        }
+
+        memcpy(key(shard, slot), entry, 2 * rawcnt_ * sizeof(RawSeqData));
+        shard.state[slot] = FULL;
+        shard.size += 1;
+    }
+
+    // The smallest capacity keeping the load factor at most 3/4
+    static size_t capacity_for(size_t size) {
+        size_t capacity = MIN_CAPACITY;
+        while (4 * size > 3 * capacity)
+            capacity *= 2;
+        return capacity;
+    }
+
+    // Rebuilds the shard with the given capacity
+    void rehash(Shard &shard, size_t capacity) {
+        Shard old;
+        std::swap(old.state, shard.state);
+        std::swap(old.data, shard.data);
+
+        shard.state.assign(capacity, EMPTY);
+        shard.data.resize(capacity * 2 * rawcnt_);
+        shard.size = 0;
+        Entry entry;
+        for (size_t slot = 0; slot < old.capacity(); ++slot) {
+            if (old.state[slot] != FULL)
+                continue;
+            std::copy(key(old, slot), key(old, slot) + 2 * rawcnt_, entry.begin());
+            insert(shard, entry.data());
+        }
+    }
+
+    unsigned k_;
+    unsigned rawcnt_;
+    std::vector<Shard> shards_;
+};
+
+}
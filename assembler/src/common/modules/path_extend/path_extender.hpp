@@ -17,6 +17,8 @@
 #include "assembly_graph/graph_support/scaff_supplementary.hpp"
 
 #include <cmath>
+#include <functional>
+#include <unordered_set>
 
 namespace path_extend {
 
@@ -407,6 +409,11 @@ public:
         DEBUG("add cycle");
         p.first.PrintDEBUG();
     }
+
+    void Clear() {
+        visited_cycles_coverage_map_.Clear();
+        path_storage_.clear();
+    }
 };
 
 class PathExtender {
@@ -417,6 +424,9 @@ public:
     virtual ~PathExtender() = default;
     virtual bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage = nullptr) = 0;
 
+    // Forgets everything learned while growing the previous paths
+    virtual void Reset() {}
+
 protected:
     const Graph &g_;
     DECL_LOGGER("PathExtender")
@@ -424,29 +434,60 @@ protected:
 
 
 class CompositeExtender {
+public:
+    typedef std::vector<std::shared_ptr<PathExtender>> ExtendersT;
+    // Creates a new set of extenders working on top of the given coverage map
+    // and used edges storage
+    typedef std::function<ExtendersT(const GraphCoverageMap&, UsedUniqueStorage&)> ExtendersFactory;
+
 private:
-    bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage);
+    struct Worker;
+    struct SeedResult;
+
+    bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage, const ExtendersT &extenders);
+    bool CheckSeed(const BidirectionalPath &seed, UsedUniqueStorage &used_storage) const;
+    void GrowSeed(const BidirectionalPath &seed, PathContainer& result,
+                  GraphCoverageMap &cover_map, const ExtendersT &extenders);
     void GrowAllPaths(PathContainer& paths, PathContainer& result);
+    void GrowAllPathsParallel(PathContainer& paths, PathContainer& result);
+    void Speculate(const BidirectionalPath &seed, Worker &worker, SeedResult &res);
+    void Commit(const BidirectionalPath &seed, SeedResult &res, PathContainer& result,
+                std::unordered_set<EdgeId> &changed);
+    void CommitPaths(const SeedResult &res, PathContainer& result);
 
 public:
     CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
                       UsedUniqueStorage &unique,
-                      const std::vector<std::shared_ptr<PathExtender>> &pes)
+                      const ExtendersT &pes)
             : g_(g),
               cover_map_(cov_map),
               used_storage_(unique),
               extenders_(pes) {}
 
+    // Unless the factory is empty, seeds are extended in parallel, every thread
+    // uses its own extenders created by the factory. The result does not depend
+    // on the number of threads.
+    CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
+                      UsedUniqueStorage &unique,
+                      const ExtendersT &pes,
+                      ExtendersFactory factory)
+            : CompositeExtender(g, cov_map, unique, pes) {
+        factory_ = std::move(factory);
+    }
+
     void GrowAll(PathContainer& paths, PathContainer& result);
     void GrowPath(BidirectionalPath& path, PathContainer* paths_storage) {
-        while (MakeGrowStep(path, paths_storage)) { }
+        while (MakeGrowStep(path, paths_storage, extenders_)) { }
     }
 
 private:
     const Graph &g_;
     GraphCoverageMap &cover_map_;
     UsedUniqueStorage &used_storage_;
-    std::vector<std::shared_ptr<PathExtender>> extenders_;
+    ExtendersT extenders_;
+    ExtendersFactory factory_;
+
+    DECL_LOGGER("CompositeExtender")
 };
 
 
@@ -495,6 +536,10 @@ public:
     bool TryToResolveTwoLoops(BidirectionalPath& path);
     bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) override;
 
+    void Reset() override {
+        is_detector_.Clear();
+    }
+
 private:
     bool ResolveShortLoop(BidirectionalPath& p) {
         if (use_short_loop_cov_resolver_) {
@@ -7,21 +7,46 @@
 
 #include "path_extender.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
 namespace path_extend {
 
+// Thread-local state of the parallel extension
+struct CompositeExtender::Worker {
+    GraphCoverageMap cover_map;
+    UsedUniqueStorage used_storage;
+    ExtendersT extenders;
+
+    Worker(const GraphCoverageMap &base_map, const UsedUniqueStorage &base_storage)
+            : cover_map(&base_map), used_storage(&base_storage) {}
+};
+
+struct CompositeExtender::SeedResult {
+    bool grown = false;
+    PathContainer paths;
+    // Unique edges used by the extension
+    std::vector<EdgeId> used;
+    // Edges whose coverage or usage was looked up in the shared state
+    std::vector<EdgeId> lookups;
+};
+
 void CompositeExtender::GrowAll(PathContainer& paths, PathContainer& result) {
     result.clear();
-    GrowAllPaths(paths, result);
+    if (factory_)
+        GrowAllPathsParallel(paths, result);
+    else
+        GrowAllPaths(paths, result);
     result.FilterEmptyPaths();
 }
 
-bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) {
+bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage,
+                                     const ExtendersT &extenders) {
     DEBUG("make grow step composite extender");
 
     size_t current = 0;
-    while (current < extenders_.size()) {
-        DEBUG("step " << current << " of total " << extenders_.size());
-        if (extenders_[current]->MakeGrowStep(path, paths_storage)) {
+    while (current < extenders.size()) {
+        DEBUG("step " << current << " of total " << extenders.size());
+        if (extenders[current]->MakeGrowStep(path, paths_storage)) {
             return true;
         }
         ++current;
@@ -29,48 +54,162 @@ bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* pat
     return false;
 }
 
+bool CompositeExtender::CheckSeed(const BidirectionalPath &seed, UsedUniqueStorage &used_storage) const {
+    //In 2015 modes do not use a seed already used in paths.
+    //FIXME what is the logic here?
+    if (!used_storage.UniqueCheckEnabled())
+        return true;
+
+    for (size_t ind = 0; ind < seed.Size(); ind++) {
+        EdgeId eid = seed.At(ind);
+        auto path_id = seed.GetId();
+        if (used_storage.IsUsedAndUnique(eid, path_id)) {
+            DEBUG("Used edge " << g_.int_id(eid));
+            DEBUG("skipping already used seed");
+            return false;
+        }
+        used_storage.insert(eid, path_id);
+    }
+    return true;
+}
+
+void CompositeExtender::GrowSeed(const BidirectionalPath &seed, PathContainer& result,
+                                 GraphCoverageMap &cover_map, const ExtendersT &extenders) {
+    BidirectionalPath &path = CreatePath(result, cover_map, seed);
+
+    size_t count_trying = 0;
+    size_t current_path_len = 0;
+    do {
+        current_path_len = path.Length();
+        count_trying++;
+        while (MakeGrowStep(path, &result, extenders)) { }
+        while (MakeGrowStep(*path.GetConjPath(), &result, extenders)) { }
+    } while (count_trying < 10 && (path.Length() != current_path_len));
+    DEBUG("result path " << path.GetId());
+    path.PrintDEBUG();
+}
+
 void CompositeExtender::GrowAllPaths(PathContainer& paths, PathContainer& result) {
     for (size_t i = 0; i < paths.size(); ++i) {
         VERBOSE_POWER_T2(i, 100, "Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
         if (paths.size() > 10 && i % (paths.size() / 10 + 1) == 0) {
             INFO("Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
         }
-        //In 2015 modes do not use a seed already used in paths.
-        //FIXME what is the logic here?
-        if (used_storage_.UniqueCheckEnabled()) {
-            bool was_used = false;
-            const BidirectionalPath &p = paths.Get(i);
-            for (size_t ind =0; ind < p.Size(); ind++) {
-                EdgeId eid = p.At(ind);
-                auto path_id = p.GetId();
-                if (used_storage_.IsUsedAndUnique(eid, path_id)) {
-                    DEBUG("Used edge " << g_.int_id(eid));
-                    was_used = true;
-                    break;
-                } else {
-                    used_storage_.insert(eid, path_id);
-                }
-            }
-            if (was_used) {
-                DEBUG("skipping already used seed");
-                continue;
-            }
+        if (!CheckSeed(paths.Get(i), used_storage_))
+            continue;
+
+        if (!cover_map_.IsCovered(paths.Get(i)))
+            GrowSeed(paths.Get(i), result, cover_map_, extenders_);
+    }
+}
+
+// Extends the seed against the state of the coverage map and used edges
+// storage left by the previous rounds. Nothing shared is modified.
+void CompositeExtender::Speculate(const BidirectionalPath &seed, Worker &worker, SeedResult &res) {
+    UsedUniqueStorage &used_storage = worker.used_storage;
+    used_storage.clear();
+    worker.cover_map.Clear();
+    if (!CheckSeed(seed, used_storage) || cover_map_.IsCovered(seed))
+        return;
+
+    for (const auto &extender : worker.extenders)
+        extender->Reset();
+    GrowSeed(seed, res.paths, worker.cover_map, worker.extenders);
+    worker.cover_map.Unsubscribe(res.paths.Get(0));
+    worker.cover_map.Unsubscribe(res.paths.GetConjugate(0));
+
+    // Edges of the seed are marked as used by the seed check and are never
+    // added by the extension itself
+    for (EdgeId e : used_storage.used()) {
+        if (!used_storage.IsUsed(e, seed.GetId()))
+            res.used.push_back(e);
+    }
+
+    res.lookups.assign(worker.cover_map.base_lookups().begin(), worker.cover_map.base_lookups().end());
+    res.lookups.insert(res.lookups.end(), used_storage.base_lookups().begin(), used_storage.base_lookups().end());
+    res.grown = true;
+}
+
+// Applies the result of the speculative extension as if the seeds were
+// processed one by one. If the extension looked up an edge changed by one of
+// the preceding seeds of the round, the seed is extended again.
+void CompositeExtender::Commit(const BidirectionalPath &seed, SeedResult &res, PathContainer& result,
+                               std::unordered_set<EdgeId> &changed) {
+    size_t first = result.size();
+    if (CheckSeed(seed, used_storage_) && !cover_map_.IsCovered(seed)) {
+        bool conflict = !res.grown;
+        for (EdgeId e : res.lookups)
+            conflict |= changed.count(e) > 0;
+
+        if (conflict) {
+            DEBUG("Conflict on seed " << seed.GetId() << ", extending again");
+            for (const auto &extender : extenders_)
+                extender->Reset();
+            GrowSeed(seed, result, cover_map_, extenders_);
+        } else {
+            CommitPaths(res, result);
+        }
+    }
+
+    // The seed check marks the seed edges as used even if the seed is skipped
+    for (size_t i = 0; i < seed.Size(); ++i) {
+        changed.insert(seed.At(i));
+        changed.insert(g_.conjugate(seed.At(i)));
+    }
+    for (size_t i = first; i < result.size(); ++i) {
+        for (EdgeId e : result.Get(i))
+            changed.insert(e);
+        for (EdgeId e : result.GetConjugate(i))
+            changed.insert(e);
+    }
+}
+
+// Paths are copied to obtain ids in the order of seeds
+void CompositeExtender::CommitPaths(const SeedResult &res, PathContainer& result) {
+    for (size_t i = 0; i < res.paths.size(); ++i) {
+        auto p = result.AddPair(BidirectionalPath::clone(res.paths.Get(i)),
+                                BidirectionalPath::clone(res.paths.GetConjugate(i)));
+        if (i == 0) {
+            cover_map_.Subscribe(p);
+            for (EdgeId e : res.used)
+                used_storage_.insert(e, p.first.GetId());
         }
+    }
+}
+
+void CompositeExtender::GrowAllPathsParallel(PathContainer& paths, PathContainer& result) {
+    size_t nthreads = omp_get_max_threads();
+    INFO("Extending " << paths.size() << " seeds using " << nthreads << " threads");
+
+    // Extenders keep references to the worker state, so workers are never moved
+    std::vector<Worker> workers;
+    workers.reserve(nthreads);
+    for (size_t i = 0; i < nthreads; ++i) {
+        workers.emplace_back(cover_map_, used_storage_);
+        workers.back().extenders = factory_(workers.back().cover_map, workers.back().used_storage);
+    }
 
-        if (!cover_map_.IsCovered(paths.Get(i))) {
-            BidirectionalPath &path = CreatePath(result, cover_map_,
-                                                 paths.Get(i));
-
-            size_t count_trying = 0;
-            size_t current_path_len = 0;
-            do {
-                current_path_len = path.Length();
-                count_trying++;
-                GrowPath(path, &result);
-                GrowPath(*path.GetConjPath(), &result);
-            } while (count_trying < 10 && (path.Length() != current_path_len));
-                DEBUG("result path " << path.GetId());
-                path.PrintDEBUG();
+    // Seeds of a round are extended speculatively in parallel and committed in
+    // order, so the round size affects the amount of repeated work only. Still
+    // it is fixed, so the rounds are the same for any number of threads.
+    const size_t ROUND_SIZE = 1024;
+    size_t reported = 0;
+    for (size_t start = 0; start < paths.size(); start += ROUND_SIZE) {
+        size_t end = std::min(start + ROUND_SIZE, paths.size());
+        std::vector<SeedResult> round(end - start);
+
+#       pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = start; i < end; ++i)
+            Speculate(paths.Get(i), workers[omp_get_thread_num()], round[i - start]);
+
+        // Edges whose coverage or usage was changed during the round
+        std::unordered_set<EdgeId> changed;
+        for (size_t i = start; i < end; ++i)
+            Commit(paths.Get(i), round[i - start], result, changed);
+
+        if (paths.size() > 10 && end * 10 / paths.size() > reported) {
+            reported = end * 10 / paths.size();
+            INFO("Processed " << end << " paths from " << paths.size() << " (" << end * 100 / paths.size() << "%)");
         }
     }
 }
@@ -15,6 +15,9 @@
 #include "adt/flat_map.hpp"
 #include "parallel_hashmap/phmap.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 namespace path_extend {
 
 using namespace debruijn_graph;
@@ -30,9 +33,40 @@ private:
 
     phmap::parallel_flat_hash_map<EdgeId, MapDataT> edge_coverage_;
     const MapDataT empty_;
+    // Paths of the base map are reported along with the own ones, the base is never modified
+    const GraphCoverageMap *base_;
+    mutable std::unordered_set<EdgeId> base_lookups_;
+
+    const GraphCoverageMap *Base(EdgeId e) const {
+        if (base_)
+            base_lookups_.insert(e);
+        return base_;
+    }
 
-    void EdgeAdded(EdgeId e, BidirectionalPath &path) {
-        edge_coverage_[e][&path] += 1;
+    const MapDataT *Find(EdgeId e) const {
+        auto iter = edge_coverage_.find(e);
+        return (iter != edge_coverage_.end() ? &iter->second : nullptr);
+    }
+
+    void EdgeAdded(EdgeId e, BidirectionalPath &path, size_t cnt = 1) {
+        edge_coverage_[e][&path] += cnt;
+    }
+
+    // Repeated edges of the range are counted at once
+    void EdgesAdded(BidirectionalPath &path, size_t from, size_t to) {
+        std::vector<EdgeId> edges;
+        edges.reserve(to - from);
+        for (size_t i = from; i < to; ++i)
+            edges.push_back(path.At(i));
+        std::sort(edges.begin(), edges.end());
+
+        for (size_t i = 0; i < edges.size(); ) {
+            size_t j = i + 1;
+            while (j < edges.size() && edges[j] == edges[i])
+                ++j;
+            EdgeAdded(edges[i], path, j - i);
+            i = j;
+        }
     }
 
     void EdgeRemoved(EdgeId e, BidirectionalPath &path) {
@@ -55,9 +89,7 @@ private:
         if (subscribe)
             path.Subscribe(*this);
         
-        for (size_t i = 0; i < path.Size(); ++i) {
-            EdgeAdded(path.At(i), path);
-        }
+        EdgesAdded(path, 0, path.Size());
     }
 
 public:
@@ -66,11 +98,15 @@ public:
 
     GraphCoverageMap(GraphCoverageMap&&) = default;
 
-    explicit GraphCoverageMap(const Graph& g) : g_(g) {
+    explicit GraphCoverageMap(const Graph& g) : g_(g), base_(nullptr) {
         //FIXME heavy constructor
         edge_coverage_.reserve(g_.e_size());
     }
 
+    // Map layered over the base one. The base must not be modified while the
+    // map is in use, the edges looked up in it are recorded (see base_lookups())
+    explicit GraphCoverageMap(const GraphCoverageMap *base) : g_(base->g_), base_(base) {}
+
     GraphCoverageMap(const Graph& g, const PathContainer& paths, bool subscribe = false) :
             GraphCoverageMap(g) {
         AddPaths(paths, subscribe);
@@ -94,6 +130,23 @@ public:
         ProcessPath(ppair.second, true);
     }
 
+    // Forgets the path and stops listening to it
+    void Unsubscribe(BidirectionalPath &path) {
+        path.Unsubscribe(*this);
+        for (size_t i = 0; i < path.Size(); ++i)
+            EdgeRemoved(path.At(i), path);
+    }
+
+    void Clear() {
+        edge_coverage_.clear();
+        base_lookups_.clear();
+    }
+
+    // Edges looked up in the base map since the last Clear()
+    const std::unordered_set<EdgeId> &base_lookups() const {
+        return base_lookups_;
+    }
+
     //Inherited from PathListener
     void FrontEdgeAdded(EdgeId e, BidirectionalPath &path, const Gap&) override {
         EdgeAdded(e, path);
@@ -104,6 +157,11 @@ public:
         EdgeAdded(e, path);
     }
 
+    //Inherited from PathListener
+    void BackEdgesAdded(BidirectionalPath &path, size_t from) override {
+        EdgesAdded(path, from, path.Size());
+    }
+
     //Inherited from PathListener
     void FrontEdgeRemoved(EdgeId e, BidirectionalPath &path) override {
         EdgeRemoved(e, path);
@@ -115,25 +173,26 @@ public:
     }
 
     const MapDataT &GetEdgePaths(EdgeId e) const {
-        auto iter = edge_coverage_.find(e);
-        if (iter != edge_coverage_.end()) {
-            return iter->second;
-        }
-        return empty_;
+        VERIFY_MSG(!base_, "Paths of a layered coverage map are not stored together");
+        auto entry = Find(e);
+        return (entry ? *entry : empty_);
     }
 
     size_t Count(EdgeId e, const BidirectionalPath &path) const {
-        auto entry = edge_coverage_.find(e);
-        if (entry == edge_coverage_.end())
-            return 0;
+        auto base = Base(e);
+        size_t res = (base ? base->Count(e, path) : 0);
+        auto entry = Find(e);
+        if (!entry)
+            return res;
 
-        auto cov = entry->second.find(const_cast<BidirectionalPath*>(&path));
-        return (cov == entry->second.end() ? 0 : cov->second);
+        auto cov = entry->find(const_cast<BidirectionalPath*>(&path));
+        return res + (cov == entry->end() ? 0 : cov->second);
     }
 
     size_t GetCoverage(EdgeId e) const {
-        auto iter = edge_coverage_.find(e);
-        return (iter != edge_coverage_.end() ? iter->second.size() : 0);
+        auto base = Base(e);
+        auto entry = Find(e);
+        return (base ? base->GetCoverage(e) : 0) + (entry ? entry->size() : 0);
     }
 
     bool IsCovered(EdgeId e) const {
@@ -149,17 +208,19 @@ public:
     }
 
     BidirectionalPathSet GetCoveringPaths(EdgeId e) const {
-        BidirectionalPathSet res;
-        auto iter = edge_coverage_.find(e);
-        if (iter == edge_coverage_.end())
+        auto base = Base(e);
+        BidirectionalPathSet res = (base ? base->GetCoveringPaths(e) : BidirectionalPathSet());
+        auto entry = Find(e);
+        if (!entry)
             return res;
 
-        for (const auto &entry : iter->second)
-            res.insert(entry.first);
+        for (const auto &path : *entry)
+            res.insert(path.first);
 
         return res;
     }
 
+    // Own entries only, the base map is not included
     auto begin() const {
         return edge_coverage_.begin();
     }
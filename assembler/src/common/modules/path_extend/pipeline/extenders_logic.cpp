@@ -58,10 +58,9 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakeLongReadsExtender(size_t lib_
 
 shared_ptr<SimpleExtender> ExtendersGenerator::MakeLongEdgePEExtender(size_t lib_index,
                                                                       bool investigate_loops) const {
-    const auto &clustered_indices = gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices");
 
     const auto &lib = dataset_info_.reads[lib_index];
-    auto paired_lib = MakeNewLib(graph_, lib, clustered_indices[lib_index]);
+    auto paired_lib = MakeNewLib(graph_, lib, clustered_indices_[lib_index]);
     //INFO("Threshold for lib #" << lib_index << ": " << paired_lib->GetSingleThreshold());
 
     shared_ptr<WeightCounter> wc =
@@ -113,8 +112,7 @@ shared_ptr<PathExtender> ExtendersGenerator::MakeScaffoldingExtender(size_t lib_
 
     const auto &lib = dataset_info_.reads[lib_index];
     const auto &pset = params_.pset;
-    const auto &scaffolding_indices = gp_.get<PairedInfoIndicesT<Graph>>("scaffolding_indices");
-    shared_ptr<PairedInfoLibrary> paired_lib = MakeNewLib(graph_, lib, scaffolding_indices[lib_index]);
+    shared_ptr<PairedInfoLibrary> paired_lib = MakeNewLib(graph_, lib, scaffolding_indices_[lib_index]);
 
     shared_ptr<WeightCounter> counter = make_shared<ReadCountWeightCounter>(graph_, paired_lib);
 
@@ -200,18 +198,17 @@ shared_ptr<PathExtender> ExtendersGenerator::MakeMatePairScaffoldingExtender(siz
     const auto &lib = dataset_info_.reads[lib_index];
     const auto &pset = params_.pset;
     const auto &paired_indices = gp_.get<UnclusteredPairedInfoIndicesT<Graph>>();
-    const auto &clustered_indices = gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices");
 
     shared_ptr<PairedInfoLibrary> paired_lib;
     INFO("Creating Scaffolding 2015 extender for lib #" << lib_index);
 
     //FIXME: DimaA
-    if (paired_indices[lib_index].size() > clustered_indices[lib_index].size()) {
+    if (paired_indices[lib_index].size() > clustered_indices_[lib_index].size()) {
         INFO("Paired unclustered indices not empty, using them");
         paired_lib = MakeNewLib(graph_, lib, paired_indices[lib_index]);
-    } else if (clustered_indices[lib_index].size()) {
+    } else if (clustered_indices_[lib_index].size()) {
         INFO("clustered indices not empty, using them");
-        paired_lib = MakeNewLib(graph_, lib, clustered_indices[lib_index]);
+        paired_lib = MakeNewLib(graph_, lib, clustered_indices_[lib_index]);
     } else {
         ERROR("All paired indices are empty!");
     }
@@ -242,8 +239,7 @@ shared_ptr<PathExtender> ExtendersGenerator::MakeMatePairScaffoldingExtender(siz
 
 shared_ptr<SimpleExtender> ExtendersGenerator::MakeCoordCoverageExtender(size_t lib_index) const {
     const auto& lib = dataset_info_.reads[lib_index];
-    const auto &clustered_indices = gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices");
-    auto paired_lib = MakeNewLib(graph_, lib, clustered_indices[lib_index]);
+    auto paired_lib = MakeNewLib(graph_, lib, clustered_indices_[lib_index]);
 
     auto provider = make_shared<CoverageAwareIdealInfoProvider>(graph_, paired_lib, lib.data().unmerged_read_length);
 
@@ -274,8 +270,7 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakeCoordCoverageExtender(size_t
 shared_ptr<SimpleExtender> ExtendersGenerator::MakeRNAExtender(size_t lib_index, bool investigate_loops) const {
 
     const auto &lib = dataset_info_.reads[lib_index];
-    const auto &clustered_indices = gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices");
-    auto paired_lib = MakeNewLib(graph_, lib, clustered_indices[lib_index]);
+    auto paired_lib = MakeNewLib(graph_, lib, clustered_indices_[lib_index]);
 //    INFO("Threshold for lib #" << lib_index << ": " << paired_lib->GetSingleThreshold());
 
     auto cip = make_shared<CoverageAwareIdealInfoProvider>(graph_, paired_lib, lib.data().unmerged_read_length);
@@ -320,8 +315,7 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakeSimpleCoverageExtender(size_t
 
 shared_ptr<SimpleExtender> ExtendersGenerator::MakePEExtender(size_t lib_index, bool investigate_loops) const {
     const auto &lib = dataset_info_.reads[lib_index];
-    const auto &clustered_indices = gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices");
-    shared_ptr<PairedInfoLibrary> paired_lib = MakeNewLib(graph_, lib, clustered_indices[lib_index]);
+    shared_ptr<PairedInfoLibrary> paired_lib = MakeNewLib(graph_, lib, clustered_indices_[lib_index]);
     VERIFY_MSG(!paired_lib->IsMp(), "Tried to create PE extender for MP library");
     auto opts = params_.pset.extension_options;
 //    INFO("Threshold for lib #" << lib_index << ": " << paired_lib->GetSingleThreshold());
@@ -10,6 +10,8 @@
 #include "modules/path_extend/gap_analyzer.hpp"
 #include "launch_support.hpp"
 
+#include "paired_info/frozen_paired_info.hpp"
+
 namespace path_extend {
 
 using namespace debruijn_graph;
@@ -84,6 +86,10 @@ class ExtendersGenerator {
 
     const PELaunchSupport &support_;
 
+    // Read-only snapshots of clustered_indices and scaffolding_indices
+    const omnigraph::de::FrozenPairedInfoIndicesT<Graph> &clustered_indices_;
+    const omnigraph::de::FrozenPairedInfoIndicesT<Graph> &scaffolding_indices_;
+
 public:
     ExtendersGenerator(const config::dataset &dataset_info,
                        const PathExtendParamsContainer &params,
@@ -91,7 +97,9 @@ public:
                        const GraphCoverageMap &cover_map,
                        const UniqueData &unique_data,
                        UsedUniqueStorage &used_unique_storage,
-                       const PELaunchSupport& support) :
+                       const PELaunchSupport& support,
+                       const omnigraph::de::FrozenPairedInfoIndicesT<Graph> &clustered_indices,
+                       const omnigraph::de::FrozenPairedInfoIndicesT<Graph> &scaffolding_indices) :
         dataset_info_(dataset_info),
         params_(params),
         gp_(gp),
@@ -99,7 +107,9 @@ public:
         cover_map_(cover_map),
         unique_data_(unique_data),
         used_unique_storage_(used_unique_storage),
-        support_(support) { }
+        support_(support),
+        clustered_indices_(clustered_indices),
+        scaffolding_indices_(scaffolding_indices) { }
 
     Extenders MakePBScaffoldingExtenders() const;
 
@@ -39,7 +39,7 @@ PathExtendLauncher::ConstructPairedConnectionConditions(const ScaffoldingUniqueE
             if (lib.is_mate_pair())
                 paired_lib = MakeNewLib(graph_, lib, gp_.get<UnclusteredPairedInfoIndicesT<Graph>>()[lib_index]);
             else if (lib.type() == io::LibraryType::PairedEnd)
-                paired_lib = MakeNewLib(graph_, lib, gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices")[lib_index]);
+                paired_lib = MakeNewLib(graph_, lib, clustered_indices_[lib_index]);
             else {
                 INFO("Unusable for scaffold graph paired lib #" << lib_index);
                 continue;
@@ -137,7 +137,7 @@ void PathExtendLauncher::CountMisassembliesWithReference(const PathContainer &pa
     ScaffoldingUniqueEdgeStorage tmp_storage;
     if (!use_main_storage) {
         unresolvable_gap = params_.pset.genome_consistency_checker.unresolvable_jump;
-        ScaffoldingUniqueEdgeAnalyzer tmp_analyzer(gp_, params_.pset.genome_consistency_checker.unique_length, unique_data_.unique_variation_);
+        ScaffoldingUniqueEdgeAnalyzer tmp_analyzer(gp_, clustered_indices_, params_.pset.genome_consistency_checker.unique_length, unique_data_.unique_variation_);
         tmp_analyzer.FillUniqueEdgeStorage(tmp_storage);
     }
     debruijn_graph::GenomeConsistenceChecker genome_checker(gp_,
@@ -208,7 +208,7 @@ void PathExtendLauncher::EstimateUniqueEdgesParams() {
 
 
 void PathExtendLauncher::FillUniqueEdgeStorage() {
-    ScaffoldingUniqueEdgeAnalyzer unique_edge_analyzer(gp_, unique_data_.min_unique_length_, unique_data_.unique_variation_);
+    ScaffoldingUniqueEdgeAnalyzer unique_edge_analyzer(gp_, clustered_indices_, unique_data_.min_unique_length_, unique_data_.unique_variation_);
     unique_edge_analyzer.FillUniqueEdgeStorage(unique_data_.main_unique_storage_);
 }
 
@@ -313,13 +313,13 @@ void PathExtendLauncher::TraverseLoops(PathContainer &paths, GraphCoverageMap &c
 }
 
 void PathExtendLauncher::AddScaffUniqueStorage(size_t uniqe_edge_len) {
-    ScaffoldingUniqueEdgeAnalyzer additional_edge_analyzer(gp_, (size_t) uniqe_edge_len,
+    ScaffoldingUniqueEdgeAnalyzer additional_edge_analyzer(gp_, clustered_indices_, (size_t) uniqe_edge_len,
                                                            unique_data_.unique_variation_);
     unique_data_.unique_storages_.push_back(ScaffoldingUniqueEdgeStorage());
     additional_edge_analyzer.FillUniqueEdgeStorage(unique_data_.unique_storages_.back());
 }
 
-Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &generator) {
+void PathExtendLauncher::FillMPUniqueEdgeStorages() {
     const pe_config::ParamSetT &pset = params_.pset;
 
     size_t cur_length = unique_data_.min_unique_length_ - pset.scaffolding2015.unique_length_step;
@@ -334,8 +334,6 @@ Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &gen
         INFO("Will add final extenders for length " << lower_bound);
         AddScaffUniqueStorage(lower_bound);
     }
-
-    return generator.MakeMPExtenders();
 }
 
 void PathExtendLauncher::FillPathContainer(size_t lib_index, size_t size_threshold) {
@@ -380,7 +378,7 @@ void PathExtendLauncher::FillLongReadsCoverageMaps() {
 void  PathExtendLauncher::FillPBUniqueEdgeStorages() {
     //FIXME magic constants
     //FIXME need to change for correct usage of prelimnary contigs in loops
-    ScaffoldingUniqueEdgeAnalyzer unique_edge_analyzer_pb(gp_, 500, 0.5);
+    ScaffoldingUniqueEdgeAnalyzer unique_edge_analyzer_pb(gp_, clustered_indices_, 500, 0.5);
 
     INFO("Filling backbone edges for long reads scaffolding...");
     if (params_.uneven_depth) {
@@ -407,38 +405,48 @@ void  PathExtendLauncher::FillPBUniqueEdgeStorages() {
     INFO(unique_data_.unique_pb_storage_.size() << " unique edges");
 }
 
-Extenders PathExtendLauncher::ConstructPBExtenders(const ExtendersGenerator &generator) {
-    FillPBUniqueEdgeStorages();
-    return generator.MakePBScaffoldingExtenders();
+bool PathExtendLauncher::UsePBExtenders() const {
+    return !config::PipelineHelper::IsPlasmidPipeline(params_.mode) && support_.HasLongReads() &&
+           params_.pset.sm != scaffolding_mode::sm_old;
 }
 
+bool PathExtendLauncher::UseMPExtenders() const {
+    return support_.HasMPReads() && params_.pset.sm != scaffolding_mode::sm_old;
+}
 
-Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_map,
-                                                 UsedUniqueStorage &used_unique_storage) {
-    INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
+void PathExtendLauncher::PrepareExtenders() {
     if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) &&  (support_.SingleReadsMapped() || support_.HasLongReads()))
         FillLongReadsCoverageMaps();
-    ExtendersGenerator generator(dataset_info_, params_, gp_, cover_map,
-                                 unique_data_, used_unique_storage, support_);
-    Extenders extenders = generator.MakeBasicExtenders();
-
-    //long reads scaffolding extenders.
 
     if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) && support_.HasLongReads()) {
-        if (params_.pset.sm == scaffolding_mode::sm_old) {
+        if (UsePBExtenders())
+            FillPBUniqueEdgeStorages();
+        else
             INFO("Will not use new long read scaffolding algorithm in this mode");
-        } else {
-            utils::push_back_all(extenders, ConstructPBExtenders(generator));
-        }
     }
 
     if (support_.HasMPReads()) {
-        if (params_.pset.sm == scaffolding_mode::sm_old) {
+        if (UseMPExtenders())
+            FillMPUniqueEdgeStorages();
+        else
             INFO("Will not use mate-pairs is this mode");
-        } else {
-            utils::push_back_all(extenders, ConstructMPExtenders(generator));
-        }
     }
+}
+
+Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_map,
+                                                 UsedUniqueStorage &used_unique_storage) const {
+    INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
+    ExtendersGenerator generator(dataset_info_, params_, gp_, cover_map,
+                                 unique_data_, used_unique_storage, support_,
+                                 clustered_indices_, scaffolding_indices_);
+    Extenders extenders = generator.MakeBasicExtenders();
+
+    //long reads scaffolding extenders.
+    if (UsePBExtenders())
+        utils::push_back_all(extenders, generator.MakePBScaffoldingExtenders());
+
+    if (UseMPExtenders())
+        utils::push_back_all(extenders, generator.MakeMPExtenders());
 
     if (params_.pset.use_coordinated_coverage)
         utils::push_back_all(extenders, generator.MakeCoverageExtenders());
@@ -595,6 +603,13 @@ void MakeConjugateEdgePairsDump(ConjugateDeBruijnGraph const & graph) {
         out << e << ' ' << graph.conjugate(e) << '\n';
 }
 
+void PathExtendLauncher::FreezePairedIndices() {
+    INFO("Freezing paired indices");
+    // The source indices are kept: they are saved and read by the later stages
+    Freeze(gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices"), clustered_indices_);
+    Freeze(gp_.get<PairedInfoIndicesT<Graph>>("scaffolding_indices"), scaffolding_indices_);
+}
+
 void PathExtendLauncher::Launch() {
     INFO("ExSPAnder repeat resolving tool started");
     fs::make_dir(params_.output_dir);
@@ -602,6 +617,8 @@ void PathExtendLauncher::Launch() {
 
     CheckCoverageUniformity();
 
+    FreezePairedIndices();
+
     if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) && support_.NeedsUniqueEdgeStorage()) {
         //Fill the storage to enable unique edge check
         EstimateUniqueEdgesParams();
@@ -627,10 +644,17 @@ void PathExtendLauncher::Launch() {
 
     GraphCoverageMap cover_map(graph_);
     UsedUniqueStorage used_unique_storage(unique_data_.main_unique_storage_, graph_);
+    PrepareExtenders();
     Extenders extenders = ConstructExtenders(cover_map, used_unique_storage);
+    CompositeExtender::ExtendersFactory extenders_factory;
+    if (params_.pset.parallel_extension) {
+        extenders_factory = [this](const GraphCoverageMap &cm, UsedUniqueStorage &us) {
+            return ConstructExtenders(cm, us);
+        };
+    }
     CompositeExtender composite_extender(graph_, cover_map,
                                          used_unique_storage,
-                                         extenders);
+                                         extenders, extenders_factory);
 
     auto paths = resolver.ExtendSeeds(seeds, composite_extender);
     DebugOutputPaths(paths, "raw_paths");
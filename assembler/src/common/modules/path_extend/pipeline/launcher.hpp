@@ -31,6 +31,13 @@ class PathExtendLauncher {
 
     UniqueData unique_data_;
 
+    // Paired indices are only read during path extension, so the extenders
+    // query their frozen copies
+    omnigraph::de::FrozenPairedInfoIndicesT<Graph> clustered_indices_;
+    omnigraph::de::FrozenPairedInfoIndicesT<Graph> scaffolding_indices_;
+
+    void FreezePairedIndices();
+
     std::vector<std::shared_ptr<ConnectionCondition>>
         ConstructPairedConnectionConditions(const ScaffoldingUniqueEdgeStorage &edge_storage) const;
 
@@ -70,13 +77,18 @@ class PathExtendLauncher {
 
     void PolishPaths(const PathContainer &paths, PathContainer &result, const GraphCoverageMap &cover_map) const;
 
-    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage);
+    bool UsePBExtenders() const;
 
-    Extenders ConstructMPExtenders(const ExtendersGenerator &generator);
+    bool UseMPExtenders() const;
 
-    void AddScaffUniqueStorage(size_t uniqe_edge_len);
+    //Fills the storages shared by all the extenders
+    void PrepareExtenders();
 
-    Extenders ConstructPBExtenders(const ExtendersGenerator &generator);
+    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage) const;
+
+    void FillMPUniqueEdgeStorages();
+
+    void AddScaffUniqueStorage(size_t uniqe_edge_len);
 
     void FilterPaths();
 
@@ -96,7 +108,9 @@ public:
         support_(dataset_info, params),
         contig_name_generator_(MakeContigNameGenerator(params_.mode, gp)),
         writer_(graph_, contig_name_generator_),
-        unique_data_() {
+        unique_data_(),
+        clustered_indices_(graph_, dataset_info.reads.lib_count()),
+        scaffolding_indices_(graph_, dataset_info.reads.lib_count()) {
         unique_data_.min_unique_length_ = params.pset.scaffolding2015.unique_length_upper_bound;
         unique_data_.unique_variation_ = params.pset.uniqueness_analyser.unique_coverage_variation;
     }
@@ -17,7 +17,9 @@ std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, Edg
 void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
     std::vector<size_t> path_lower_bounds;
     size_t path_upper_bound = PairInfoPathLengthUpperBound(graph_.k(), insert_size_, delta_);
-    PathProcessor <Graph> paths_proc(graph_, graph_.EdgeEnd(e1), path_upper_bound);
+    PathProcessor <Graph> paths_proc(graph_, graph_.EdgeEnd(e1), path_upper_bound,
+                                     PathProcessor<Graph>::MAX_DIJKSTRA_VERTICES,
+                                     workspaces_.local());
 
     for (auto &entry : second_edges) {
         EdgeId e2 = entry.first;
@@ -43,6 +43,7 @@ private:
     const size_t insert_size_;
     const int gap_;
     const double delta_;
+    mutable ThreadWorkspaces<PathProcessor<debruijn_graph::Graph>::Workspace> workspaces_;
 };
 
 class AbstractDistanceEstimator {
@@ -0,0 +1,234 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "index_point.hpp"
+#include "paired_info.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/verify.hpp"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace omnigraph {
+
+namespace de {
+
+/**
+ * @brief Read-only snapshot of a paired index in CSR form.
+ * @detail Neighbours of every edge are stored sorted in a single array and
+ *         addressed by the edge int_id, the points of all histograms are stored
+ *         expanded (i.e. the conjugate points are restored and the distances
+ *         are computed) in another one. Provides the subset of PairedIndex
+ *         interface needed by the consumers that only read the index
+ *         (e.g. PairedInfoLibraryWithIndex). The snapshot is not updated when
+ *         the graph or the source index changes.
+ */
+template<class G>
+class FrozenPairedIndex {
+  public:
+    typedef G Graph;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef omnigraph::de::Point Point;
+
+    /**
+     * @brief Points between two edges, ordered by distance.
+     */
+    class HistProxy {
+      public:
+        HistProxy(const Point *begin, const Point *end)
+                : begin_(begin), end_(end) {}
+
+        const Point *begin() const { return begin_; }
+        const Point *end() const { return end_; }
+
+        size_t size() const { return size_t(end_ - begin_); }
+        bool empty() const { return begin_ == end_; }
+
+      private:
+        const Point *begin_;
+        const Point *end_;
+    };
+
+    typedef std::pair<EdgeId, HistProxy> EdgeHist;
+
+    /**
+     * @brief Neighbourhood of an edge: pairs of the second edge and the histogram.
+     */
+    class EdgeProxy {
+      public:
+        class Iterator : public boost::iterator_facade<Iterator, EdgeHist, boost::forward_traversal_tag, EdgeHist> {
+          public:
+            Iterator(const FrozenPairedIndex &index, size_t pos)
+                    : index_(&index), pos_(pos) {}
+
+          private:
+            friend class boost::iterator_core_access;
+
+            void increment() { ++pos_; }
+
+            bool equal(const Iterator &other) const { return pos_ == other.pos_; }
+
+            EdgeHist dereference() const {
+                return std::make_pair(index_->neighbours_[pos_], index_->Hist(pos_));
+            }
+
+            const FrozenPairedIndex *index_;
+            size_t pos_;
+        };
+
+        EdgeProxy(const FrozenPairedIndex &index, size_t begin, size_t end)
+                : index_(index), begin_(begin), end_(end) {}
+
+        Iterator begin() const { return Iterator(index_, begin_); }
+        Iterator end() const { return Iterator(index_, end_); }
+
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+
+      private:
+        const FrozenPairedIndex &index_;
+        size_t begin_, end_;
+    };
+
+    typedef typename EdgeProxy::Iterator EdgeIterator;
+
+    explicit FrozenPairedIndex(const Graph &g)
+            : graph_(g), size_(0) {
+        clear();
+    }
+
+    /**
+     * @brief Fills the snapshot with the contents of the index.
+     */
+    template<class Index>
+    void Build(const Index &index) {
+        clear();
+        rows_.assign(graph_.max_eid() + 2, 0);
+
+        // Count the neighbours of every edge, then place them
+        for (auto it = index.data_begin(); it != index.data_end(); ++it)
+            rows_[it->first.int_id() + 1] = it->second.size();
+        for (size_t i = 1; i < rows_.size(); ++i)
+            rows_[i] += rows_[i - 1];
+
+        neighbours_.reserve(rows_.back());
+        hists_.reserve(rows_.back() + 1);
+        points_.reserve(index.size());
+        for (auto it = index.data_begin(); it != index.data_end(); ++it) {
+            EdgeId e1 = it->first;
+            size_t row = rows_[e1.int_id()];
+            VERIFY(neighbours_.size() == row);
+            for (const auto &entry : it->second) {
+                EdgeId e2 = entry.first;
+                // Neighbours are looked up by binary search
+                VERIFY_DEV(neighbours_.size() == row || neighbours_.back() < e2);
+                neighbours_.push_back(e2);
+                hists_.push_back(points_.size());
+                for (Point p : index.Get(e1, e2))
+                    points_.push_back(p);
+            }
+        }
+        hists_.push_back(points_.size());
+        size_ = index.size();
+
+        DEBUG("Paired index frozen: " << neighbours_.size() << " edge pairs, "
+              << points_.size() << " points");
+    }
+
+    void clear() {
+        rows_.assign(1, 0);
+        neighbours_.clear();
+        hists_.clear();
+        points_.clear();
+        size_ = 0;
+    }
+
+    /**
+     * @brief Returns the size of the source index.
+     */
+    size_t size() const { return size_; }
+
+    const Graph &graph() const { return graph_; }
+
+    /**
+     * @brief Returns the neighbourhood of the edge, both straight and conjugate pairs.
+     */
+    EdgeProxy Get(EdgeId e) const {
+        size_t id = e.int_id();
+        if (id + 1 >= rows_.size())
+            return EdgeProxy(*this, 0, 0);
+        return EdgeProxy(*this, rows_[id], rows_[id + 1]);
+    }
+
+    EdgeProxy operator[](EdgeId e) const {
+        return Get(e);
+    }
+
+    /**
+     * @brief Returns all points between two edges.
+     */
+    HistProxy Get(EdgeId e1, EdgeId e2) const {
+        size_t id = e1.int_id();
+        if (id + 1 >= rows_.size())
+            return HistProxy(nullptr, nullptr);
+
+        auto begin = neighbours_.begin() + rows_[id], end = neighbours_.begin() + rows_[id + 1];
+        auto it = std::lower_bound(begin, end, e2);
+        if (it == end || *it != e2)
+            return HistProxy(nullptr, nullptr);
+
+        return Hist(size_t(it - neighbours_.begin()));
+    }
+
+    bool contains(EdgeId e1, EdgeId e2) const {
+        size_t id = e1.int_id();
+        if (id + 1 >= rows_.size())
+            return false;
+        return std::binary_search(neighbours_.begin() + rows_[id], neighbours_.begin() + rows_[id + 1], e2);
+    }
+
+  private:
+    HistProxy Hist(size_t pos) const {
+        return HistProxy(points_.data() + hists_[pos], points_.data() + hists_[pos + 1]);
+    }
+
+    const Graph &graph_;
+    // Edge int_id -> the first neighbour of the edge
+    std::vector<size_t> rows_;
+    std::vector<EdgeId> neighbours_;
+    // Neighbour -> the first point of the histogram
+    std::vector<size_t> hists_;
+    std::vector<Point> points_;
+    size_t size_;
+
+    DECL_LOGGER("FrozenPairedIndex");
+};
+
+template<class Graph>
+using FrozenPairedInfoIndicesT = PairedIndices<FrozenPairedIndex<Graph>>;
+
+/**
+ * @brief Freezes every non-empty index of the collection.
+ */
+template<class Graph, class Indices>
+void Freeze(const Indices &indices, FrozenPairedInfoIndicesT<Graph> &frozen) {
+    VERIFY(indices.size() == frozen.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (indices[i].size())
+            frozen[i].Build(indices[i]);
+        else
+            frozen[i].clear();
+    }
+}
+
+}
+
+}
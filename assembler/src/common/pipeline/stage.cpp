@@ -111,6 +111,7 @@ void CompositeStageBase::run(debruijn_graph::GraphPack& gp,
         }
     }
 
+    std::string prev_saves;
     for (auto et = phases_.end(); start_phase != et; ++start_phase) {
         PhaseBase *phase = start_phase->get();
 
@@ -127,8 +128,10 @@ void CompositeStageBase::run(debruijn_graph::GraphPack& gp,
 
             TIME_TRACE_SCOPE("save phase", composite_id);
             phase->save(gp, parent_->saves_policy().SavesPath(), composite_id.c_str());
-            //TODO: currently no phases are writing saves.
-            //When they will, erase the previous saves when SavesPolicy::Last
+            if (!prev_saves.empty() &&
+                parent_->saves_policy().EnabledCheckpoints() == SavesPolicy::Checkpoints::Last)
+                fs::remove_if_exists(fs::append_path(parent_->saves_policy().SavesPath(), prev_saves));
+            prev_saves = composite_id;
         }
     }
 
@@ -0,0 +1,193 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "sequence.hpp"
+#include "rtseq.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace kmer_extractor_impl {
+
+typedef RtSeq::DataType DataType;
+
+// Words reserved for every k-mer in the output of the kernels, rounded up to
+// the width of AVX2 register
+const size_t kStride = (RtSeq::DataSize + 3) / 4 * 4;
+
+// The kernels cut words [0, stride) of k-mers starting at positions
+// [from, from + cnt) of the packed stream: every word is a funnel shift of two
+// adjacent words of the stream by the same amount.
+inline void cut_kmers_scalar(const DataType *s, size_t from, size_t cnt, size_t words,
+                             DataType *out) {
+    for (size_t i = 0; i < cnt; ++i, out += kStride) {
+        size_t p = from + i, q = p >> 5;
+        unsigned r = unsigned(p & 31) << 1;
+        for (size_t w = 0; w < words; ++w)
+            out[w] = r ? (s[q + w] >> r) | (s[q + w + 1] << (64 - r)) : s[q + w];
+    }
+}
+
+#if defined(__x86_64__)
+inline void cut_kmers_sse2(const DataType *s, size_t from, size_t cnt, size_t words,
+                           DataType *out) {
+    for (size_t i = 0; i < cnt; ++i, out += kStride) {
+        size_t p = from + i, q = p >> 5;
+        __m128i r = _mm_cvtsi32_si128(int(p & 31) << 1);
+        __m128i l = _mm_cvtsi32_si128(64 - (int(p & 31) << 1));
+        for (size_t w = 0; w < words; w += 2) {
+            __m128i lo = _mm_loadu_si128((const __m128i*)(s + q + w));
+            __m128i hi = _mm_loadu_si128((const __m128i*)(s + q + w + 1));
+            _mm_storeu_si128((__m128i*)(out + w),
+                             _mm_or_si128(_mm_srl_epi64(lo, r), _mm_sll_epi64(hi, l)));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+inline void cut_kmers_avx2(const DataType *s, size_t from, size_t cnt, size_t words,
+                           DataType *out) {
+    for (size_t i = 0; i < cnt; ++i, out += kStride) {
+        size_t p = from + i, q = p >> 5;
+        __m128i r = _mm_cvtsi32_si128(int(p & 31) << 1);
+        __m128i l = _mm_cvtsi32_si128(64 - (int(p & 31) << 1));
+        for (size_t w = 0; w < words; w += 4) {
+            __m256i lo = _mm256_loadu_si256((const __m256i*)(s + q + w));
+            __m256i hi = _mm256_loadu_si256((const __m256i*)(s + q + w + 1));
+            _mm256_storeu_si256((__m256i*)(out + w),
+                                _mm256_or_si256(_mm256_srl_epi64(lo, r), _mm256_sll_epi64(hi, l)));
+        }
+    }
+}
+#endif
+
+typedef void (*CutKMersFn)(const DataType *, size_t, size_t, size_t, DataType *);
+
+inline CutKMersFn cut_kmers_kernel() {
+#if defined(__x86_64__)
+    static const CutKMersFn kernel = (__builtin_cpu_supports("avx2") ? cut_kmers_avx2 : cut_kmers_sse2);
+#else
+    static const CutKMersFn kernel = cut_kmers_scalar;
+#endif
+    return kernel;
+}
+
+}
+
+/**
+ * Extracts k-mers of a sequence in bulk. Instead of shifting the previous
+ * k-mer by a single nucleotide (which touches every word of RtSeq), each k-mer
+ * is cut directly from the packed sequence. The reverse complementary k-mers
+ * are cut the same way from the packed reverse complement of the sequence.
+ * The kernel is chosen at runtime (AVX2 / SSE2 / scalar).
+ */
+class KMerExtractor {
+    typedef kmer_extractor_impl::DataType DataType;
+
+  public:
+    // Preferred number of k-mers requested at once
+    static const size_t BATCH_SIZE = 64;
+
+    explicit KMerExtractor(unsigned k)
+            : k_(k), words_(RtSeq::GetDataSize(k)),
+              last_mask_(k & 31 ? (DataType(1) << ((k & 31) << 1)) - 1 : ~DataType(0)),
+              nucls_(0), kernel_(kmer_extractor_impl::cut_kmers_kernel()) {
+        VERIFY(k <= RtSeq::max_size);
+    }
+
+    KMerExtractor(unsigned k, const Sequence &s)
+            : KMerExtractor(k) {
+        reset(s);
+    }
+
+    /**
+     * Extractor of the calling thread. It is reused between the calls, so
+     * its buffers are not reallocated for every sequence. The extractor is
+     * valid until the next call with another k on the same thread.
+     */
+    static KMerExtractor &local(unsigned k) {
+        static thread_local KMerExtractor extractor(k);
+        if (extractor.k_ != k)
+            extractor = KMerExtractor(k);
+        return extractor;
+    }
+
+    // Returns the number of k-mers in the sequence
+    size_t reset(const Sequence &s) {
+        nucls_ = s.size();
+
+        // Kernels might read a whole register past the last k-mer
+        size_t words = (nucls_ + 31) / 32 + kmer_extractor_impl::kStride + 1;
+        fwd_.assign(words, 0);
+        rc_.assign(words, 0);
+        s.copy_packed(fwd_.data());
+        (!s).copy_packed(rc_.data());
+
+        return size();
+    }
+
+    size_t size() const {
+        return nucls_ < k_ ? 0 : nucls_ - k_ + 1;
+    }
+
+    /**
+     * Writes k-mers starting at positions [from, from + cnt). If is_minimal is
+     * given, also marks the k-mers that are not greater than their reverse
+     * complement (see RtSeq::IsMinimal)
+     */
+    void kmers(size_t from, size_t cnt, RtSeq *res, bool *is_minimal = nullptr) const {
+        const size_t stride = kmer_extractor_impl::kStride;
+        DataType fwd[BATCH_SIZE * stride], rc[BATCH_SIZE * stride];
+
+        VERIFY_DEV(from + cnt <= size());
+        for (size_t start = 0; start < cnt; start += BATCH_SIZE) {
+            size_t n = std::min(size_t(BATCH_SIZE), cnt - start);
+            kernel_(fwd_.data(), from + start, n, words_, fwd);
+            for (size_t i = 0; i < n; ++i)
+                res[start + i] = RtSeq(k_, fwd + i * stride);
+
+            if (!is_minimal)
+                continue;
+
+            // Reverse complement of the k-mer at position p starts at
+            // position size() - 1 - p of the reverse complement
+            kernel_(rc_.data(), size() - (from + start + n), n, words_, rc);
+            for (size_t i = 0; i < n; ++i)
+                is_minimal[start + i] = minimal(fwd + i * stride, rc + (n - 1 - i) * stride);
+        }
+    }
+
+  private:
+    // Compares the k-mer with its reverse complement nucleotide-wise
+    bool minimal(const DataType *fwd, const DataType *rc) const {
+        for (size_t w = 0; w < words_; ++w) {
+            DataType mask = (w + 1 == words_ ? last_mask_ : ~DataType(0));
+            DataType diff = (fwd[w] ^ rc[w]) & mask;
+            if (!diff)
+                continue;
+
+            unsigned shift = unsigned(__builtin_ctzll(diff)) & ~1u;
+            return ((fwd[w] >> shift) & 3) < ((rc[w] >> shift) & 3);
+        }
+
+        return true;
+    }
+
+    unsigned k_;
+    size_t words_;
+    DataType last_mask_;
+    size_t nucls_;
+    kmer_extractor_impl::CutKMersFn kernel_;
+    std::vector<DataType> fwd_;
+    std::vector<DataType> rc_;
+};
@@ -8,9 +8,11 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <string>
 #include <memory>
 #include <cstring>
+#include <cstdint>
 
 #include "seq.hpp"
 #include "rtseq.hpp"
@@ -32,17 +34,35 @@ class Sequence {
     // Number of bits in STN (for faster div and mod)
     const static size_t STNBits = log_<STN, 2>::value;
 
+  public:
+    // Releases the external buffer of the given size in bytes
+    typedef void (*ReleaseF)(const void *data, size_t bytes);
+
+  private:
     class ManagedNuclBuffer final : public llvm::ThreadSafeRefCountedBase<ManagedNuclBuffer>,
                                     protected llvm::TrailingObjects<ManagedNuclBuffer, ST> {
         friend TrailingObjects;
 
-        ManagedNuclBuffer() {}
+        // Either the trailing nucleotides or the external buffer
+        ST *data_;
+        // Set for external buffers only
+        ReleaseF release_;
+        size_t bytes_;
+
+        ManagedNuclBuffer()
+                : data_(getTrailingObjects<ST>()), release_(nullptr), bytes_(0) {}
 
-        ManagedNuclBuffer(size_t nucls, ST *buf) {
-            std::uninitialized_copy(buf, buf + Sequence::DataSize(nucls), data());
+        ManagedNuclBuffer(size_t nucls, ST *buf)
+                : ManagedNuclBuffer() {
+            std::uninitialized_copy(buf, buf + Sequence::DataSize(nucls), data_);
         }
 
       public:
+        ~ManagedNuclBuffer() {
+            if (release_)
+                release_(data_, bytes_);
+        }
+
         void operator delete(void *p) { ::operator delete(p); }
 
         static ManagedNuclBuffer *create(size_t nucls) {
@@ -55,8 +75,19 @@ class Sequence {
             return new (mem) ManagedNuclBuffer(nucls, data);
         }
 
-        const ST *data() const { return getTrailingObjects<ST>(); }
-        ST *data() { return getTrailingObjects<ST>(); }
+        static ManagedNuclBuffer *wrap(const ST *data, size_t bytes, ReleaseF release) {
+            void *mem = ::operator new(totalSizeToAlloc<ST>(0));
+            ManagedNuclBuffer *res = new (mem) ManagedNuclBuffer();
+            // External buffers are never written, the only non-const accesses
+            // of the data are those of newly created sequences
+            res->data_ = const_cast<ST*>(data);
+            res->release_ = release;
+            res->bytes_ = bytes;
+            return res;
+        }
+
+        const ST *data() const { return data_; }
+        ST *data() { return data_; }
     };
 
     size_t size_ : 32;
@@ -173,6 +204,22 @@ public:
     Sequence(const Sequence &s)
             : Sequence(s, s.from_, s.size_, s.rtl_) {}
 
+    /**
+     * Sequence viewing an external buffer of nucleotides packed 4 per byte
+     * (e.g. a memory-mapped file). Nucleotides at byte offset b start at
+     * position 4 * b, so the buffer must be aligned to ST and its size must
+     * not exceed 2^29 bytes. No data is copied, the buffer is released via
+     * release(data, bytes) once no sequence refers to it.
+     */
+    static Sequence Wrap(const void *data, size_t bytes, ReleaseF release) {
+        VERIFY(bytes < (size_t(1) << 29));
+        VERIFY(reinterpret_cast<uintptr_t>(data) % alignof(ST) == 0);
+        Sequence res;
+        res.size_ = 4 * bytes;
+        res.data_ = ManagedNuclBuffer::wrap(static_cast<const ST*>(data), bytes, release);
+        return res;
+    }
+
     const Sequence &operator=(const Sequence &rhs) {
         if (&rhs == this)
             return *this;
@@ -286,6 +333,13 @@ public:
         return true;
     }
 
+    /**
+     * Writes the nucleotides packed the same way as in RtSeq (2 bits per
+     * nucleotide, the first one in the lowest bits of the first word) into
+     * the first (size() + 31) / 32 words of dst
+     */
+    inline void copy_packed(ST *dst) const;
+
 public:
     inline bool BinRead(std::istream &file);
     inline bool BinWrite(std::ostream &file) const;
@@ -318,6 +372,48 @@ Seq Sequence::end(size_t k) const {
     return Seq(unsigned(k), *this, size_ - k);
 }
 
+void Sequence::copy_packed(ST *dst) const {
+    size_t words = DataSize(size_);
+    if (!words)
+        return;
+
+    const ST *bytes = data_->data();
+    size_t last = (from_ + size_ - 1) >> STNBits;
+    size_t shift = (from_ & (STN - 1)) << 1;
+    for (size_t i = 0, j = from_ >> STNBits; i < words; ++i, ++j) {
+        ST w = bytes[j] >> shift;
+        if (shift && j < last)
+            w |= bytes[j + 1] << (STBits - shift);
+        dst[i] = w;
+    }
+    if (size_ & (STN - 1))
+        dst[words - 1] &= (ST(1) << ((size_ & (STN - 1)) << 1)) - 1;
+
+    if (!rtl_)
+        return;
+
+    // Reverse complement every word and the order of words, the nucleotides
+    // end up aligned to the end of the last word
+    std::reverse(dst, dst + words);
+    for (size_t i = 0; i < words; ++i) {
+        ST w = ~dst[i];
+        w = ((w >> 2) & 0x3333333333333333ULL) | ((w & 0x3333333333333333ULL) << 2);
+        w = ((w >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((w & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        dst[i] = __builtin_bswap64(w);
+    }
+
+    size_t pad = ((words << STNBits) - size_) << 1;
+    if (!pad)
+        return;
+
+    for (size_t i = 0; i < words; ++i) {
+        ST w = dst[i] >> pad;
+        if (i + 1 < words)
+            w |= dst[i + 1] << (STBits - pad);
+        dst[i] = w;
+    }
+}
+
 // O(1)
 //including from, excluding to
 //safe if not #DEFINE NDEBUG
@@ -6,6 +6,7 @@
 //***************************************************************************
 
 #include "construction.hpp"
+#include "construction_storage.hpp"
 
 #include "assembly_graph/construction/early_simplification.hpp"
 #include "modules/alignment/edge_index.hpp"
@@ -19,28 +20,69 @@
 #include "io/reads/coverage_filtering_read_wrapper.hpp"
 #include "io/reads/multifile_reader.hpp"
 
+#include "io/binary/binary.hpp"
+
+#include "utils/filesystem/path_helper.hpp"
 #include "utils/filesystem/temporary.hpp"
 #include "utils/ph_map/coverage_hash_map_builder.hpp"
 
+#include <fstream>
+
 
 namespace debruijn_graph {
 
-struct ConstructionStorage {
-    using CoverageMap = utils::PerfectHashMap<RtSeq, uint32_t, utils::slim_kmer_index_traits<RtSeq>, utils::DefaultStoring>;
+void ConstructionStorage::save(const std::string &dir) const {
+    fs::make_dirs(dir);
+    if (cqf) {
+        std::string cqf_file = fs::append_path(dir, "cqf");
+        if (!cqf_file_.empty() && cqf_file_ != cqf_file && fs::check_existence(cqf_file_))
+            fs::link_or_copy(cqf_file_, cqf_file);
+        else
+            cqf->serialize(cqf_file);
+        cqf_file_ = cqf_file;
+    }
+
+    if (kmers)
+        kmers->save(dir);
+
+    // Coverage map is not saved: it is built by the last phase
+    if (ext_index.size()) {
+        std::ofstream ofs(fs::append_path(dir, "ext_index"), std::ios::binary);
+        io::binary::BinWrite(ofs, ext_index);
+        if (!ofs)
+            throw std::ios_base::failure("Cannot save extension index to " + dir);
+        ext_index.SaveKMers(fs::append_path(dir, "ext_index_kmers"));
+    }
+}
 
-    ConstructionStorage(unsigned k)
-            : ext_index(k) {}
+void ConstructionStorage::load(const std::string &dir) {
+    INFO("Loading construction storage from " << dir);
+    if (!fs::check_existence(dir))
+        throw std::ios_base::failure("No construction checkpoint in " + dir);
+
+    std::string cqf_file = fs::append_path(dir, "cqf");
+    if (fs::check_existence(cqf_file)) {
+        cqf.reset(new qf::cqf(cqf_file));
+        cqf_file_ = cqf_file;
+        // Input streams should be wrapped the same way as after the filtering
+        unsigned kplusone = ext_index.k() + 1;
+        rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(kplusone);
+        read_streams = io::CovFilteringWrap(std::move(read_streams), kplusone, hasher, *cqf,
+                                            params.read_cov_threshold);
+    }
 
-    utils::DeBruijnExtensionIndex<> ext_index;
+    if (fs::check_existence(fs::append_path(dir, "kmers.info")))
+        kmers.reset(new kmers::KMerDiskStorage<RtSeq>(kmers::KMerDiskStorage<RtSeq>::load(workdir, dir)));
 
-    std::unique_ptr<qf::cqf> cqf;
-    std::unique_ptr<kmers::KMerDiskStorage<RtSeq>> kmers;
-    std::unique_ptr<CoverageMap> coverage_map;
-    config::debruijn_config::construction params;
-    io::ReadStreamList<io::SingleReadSeq> read_streams;
-    io::ReadStreamList<io::SingleReadSeq> contigs_streams;
-    fs::TmpDir workdir;
-};
+    std::string ext_index_file = fs::append_path(dir, "ext_index");
+    if (fs::check_existence(ext_index_file)) {
+        std::ifstream ifs(ext_index_file, std::ios::binary);
+        io::binary::BinRead(ifs, ext_index);
+        if (!ifs)
+            throw std::ios_base::failure("Cannot load extension index from " + dir);
+        ext_index.LoadKMers(fs::append_path(dir, "ext_index_kmers"), workdir);
+    }
+}
 
 bool add_trusted_contigs(io::DataSet<config::LibraryData> &libraries,
                        io::ReadStreamList<io::SingleReadSeq> &trusted_list) {
@@ -187,29 +229,28 @@ class CoverageFilter: public Construction::Phase {
         unsigned kplusone = index.k() + 1;
         rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(kplusone);
 
-        INFO("Estimating k-mers cardinality");
-        size_t kmers = EstimateCardinalityUpperBound(kplusone, read_streams, hasher, KmerFilter());
-
-        // Create main CQF using # of slots derived from estimated # of k-mers
-        storage().cqf.reset(new qf::cqf(kmers));
-
-        INFO("Building k-mer coverage histogram");
-        FillCoverageHistogram(*storage().cqf, kplusone, hasher, read_streams, rthr, KmerFilter());
+        // Cardinality estimation and coverage histogram share a single pass over the reads
+        INFO("Estimating k-mers cardinality and building k-mer coverage histogram");
+        storage().cqf = SketchCoverageHistogram(kplusone, hasher, read_streams, rthr,
+                                                storage().workdir, storage().params.read_buffer_size,
+                                                KmerFilter());
 
         // Replace input streams with wrapper ones
         storage().read_streams = io::CovFilteringWrap(std::move(read_streams), kplusone, hasher, *storage().cqf, rthr);
     }
 
     void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+              const std::string &load_from,
+              const char* prefix) override {
+        storage().load(fs::append_path(load_from, prefix));
     }
 
     void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+              const std::string &save_to,
+              const char* prefix) const override {
+        auto dir = fs::append_path(save_to, prefix);
+        fs::remove_if_exists(dir);
+        storage().save(dir);
     }
 
 };
@@ -247,15 +288,17 @@ public:
     }
 
     void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+              const std::string &load_from,
+              const char* prefix) override {
+        storage().load(fs::append_path(load_from, prefix));
     }
 
     void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+              const std::string &save_to,
+              const char* prefix) const override {
+        auto dir = fs::append_path(save_to, prefix);
+        fs::remove_if_exists(dir);
+        storage().save(dir);
     }
 };
 
@@ -276,15 +319,17 @@ public:
     }
 
     void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+              const std::string &load_from,
+              const char* prefix) override {
+        storage().load(fs::append_path(load_from, prefix));
     }
 
     void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+              const std::string &save_to,
+              const char* prefix) const override {
+        auto dir = fs::append_path(save_to, prefix);
+        fs::remove_if_exists(dir);
+        storage().save(dir);
     }
 };
 
@@ -305,15 +350,17 @@ public:
     }
 
     void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+              const std::string &load_from,
+              const char* prefix) override {
+        storage().load(fs::append_path(load_from, prefix));
     }
 
     void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+              const std::string &save_to,
+              const char* prefix) const override {
+        auto dir = fs::append_path(save_to, prefix);
+        fs::remove_if_exists(dir);
+        storage().save(dir);
     }
 };
 
@@ -331,15 +378,17 @@ public:
     }
 
     void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+              const std::string &load_from,
+              const char* prefix) override {
+        storage().load(fs::append_path(load_from, prefix));
     }
 
     void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+              const std::string &save_to,
+              const char* prefix) const override {
+        auto dir = fs::append_path(save_to, prefix);
+        fs::remove_if_exists(dir);
+        storage().save(dir);
     }
 };
 
@@ -357,17 +406,18 @@ public:
         DeBruijnGraphExtentionConstructor<Graph>(gp.get_mutable<Graph>(), storage().ext_index).ConstructGraph(storage().params.keep_perfect_loops);
     }
 
-    void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+    void load(debruijn_graph::GraphPack &gp,
+              const std::string &load_from,
+              const char* prefix) override {
+        AssemblyStage::load(gp, load_from, prefix);
+        storage().load(fs::append_path(load_from, prefix));
     }
 
-    void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        //FIXME why commented here and others
-        // VERIFY_MSG(false, "implement me");
+    void save(const debruijn_graph::GraphPack &gp,
+              const std::string &save_to,
+              const char* prefix) const override {
+        AssemblyStage::save(gp, save_to, prefix);
+        storage().save(fs::append_path(save_to, prefix));
     }
 };
 
@@ -385,16 +435,16 @@ public:
         index.Attach();
     }
 
-    void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+    void load(debruijn_graph::GraphPack &gp,
+              const std::string &load_from,
+              const char* prefix) override {
+        AssemblyStage::load(gp, load_from, prefix);
     }
 
-    void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+    void save(const debruijn_graph::GraphPack &gp,
+              const std::string &save_to,
+              const char* prefix) const override {
+        AssemblyStage::save(gp, save_to, prefix);
     }
 };
 
@@ -450,16 +500,17 @@ public:
         gp.get_mutable<GenomicInfo>().set_cov_histogram(hist);
     }
 
-    void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+    void load(debruijn_graph::GraphPack &gp,
+              const std::string &load_from,
+              const char* prefix) override {
+        // Nothing is left in the storage for the next phases
+        AssemblyStage::load(gp, load_from, prefix);
     }
 
-    void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+    void save(const debruijn_graph::GraphPack &gp,
+              const std::string &save_to,
+              const char* prefix) const override {
+        AssemblyStage::save(gp, save_to, prefix);
     }
 
 };
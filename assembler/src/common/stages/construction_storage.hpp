@@ -0,0 +1,51 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "adt/cqf.hpp"
+#include "io/reads/read_stream_vector.hpp"
+#include "io/reads/single_read.hpp"
+#include "pipeline/config_struct.hpp"
+#include "utils/extension_index/kmer_extension_index.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/kmer_mph/kmer_index_builder.hpp"
+
+#include <memory>
+#include <string>
+
+namespace debruijn_graph {
+
+/// State shared by the phases of graph construction
+struct ConstructionStorage {
+    using CoverageMap = utils::PerfectHashMap<RtSeq, uint32_t, utils::slim_kmer_index_traits<RtSeq>, utils::DefaultStoring>;
+
+    ConstructionStorage(unsigned k)
+            : ext_index(k) {}
+
+    utils::DeBruijnExtensionIndex<> ext_index;
+
+    std::unique_ptr<qf::cqf> cqf;
+    std::unique_ptr<kmers::KMerDiskStorage<RtSeq>> kmers;
+    std::unique_ptr<CoverageMap> coverage_map;
+    config::debruijn_config::construction params;
+    io::ReadStreamList<io::SingleReadSeq> read_streams;
+    io::ReadStreamList<io::SingleReadSeq> contigs_streams;
+    fs::TmpDir workdir;
+
+    // Phase checkpoints: everything built so far is stored into the directory.
+    // The k-mer files are hard linked, so they survive the removal of the
+    // working directory and could be reused by any number of restarts.
+    void save(const std::string &dir) const;
+    void load(const std::string &dir);
+
+  private:
+    // The CQF does not change after the filtering, so it is serialized once
+    // and the file is hard linked into the later checkpoints
+    mutable std::string cqf_file_;
+};
+
+}
@@ -53,6 +53,7 @@ private:
     size_t max_length_bound_;
     double max_coverage_bound_;
     int requested_iterations_;
+    bool local_;
 
     std::string ReadNext() {
         if (!tokenized_input_.empty()) {
@@ -172,6 +173,8 @@ private:
             RelaxMin(min_coverage_bound, cov_bound);
             return CoverageUpperBound<Graph>(g_, cov_bound);
         } else if (next_token_ == "nbr") {
+            // Alternative paths are searched with Dijkstra
+            local_ = false;
             return NotBulgeECCondition<Graph>(g_);
         } else if (next_token_ == "rcec_cb") {
             ReadNext();
@@ -220,7 +223,8 @@ public:
               //iter_run_progress_((double) (curr_iteration + 1) / (double) iteration_cnt),
               max_length_bound_(0),
               max_coverage_bound_(0.),
-              requested_iterations_(1) {
+              requested_iterations_(1),
+              local_(true) {
         DEBUG("Creating parser for string " << input);
         std::vector<std::string> tmp_tokenized_input;
         boost::split(tmp_tokenized_input, input_, boost::is_any_of(" ,;"), boost::token_compress_on);
@@ -263,6 +267,12 @@ public:
         return requested_iterations_;
     }
 
+    /// @return false if some parsed condition depends on more than the
+    ///         edge neighbourhood, so the edges cannot be checked in batches
+    bool local() const {
+        return local_;
+    }
+
 private:
     DECL_LOGGER("ConditionParser");
 };
@@ -334,15 +344,27 @@ protected:
 
     bool Process(EdgeId e) override {
         TRACE("Checking edge " << this->g().str(e) << " for the removal condition");
-        if (remove_condition_(e)) {
+        if (Check(e)) {
             TRACE("Check passed, removing");
-            edge_remover_.DeleteEdge(e);
+            Apply(e);
             return true;
         }
         TRACE("Check not passed");
         return false;
     }
 
+    bool Check(EdgeId e) const override {
+        return remove_condition_(e);
+    }
+
+    void Apply(EdgeId e) override {
+        edge_remover_.DeleteEdge(e);
+    }
+
+    void Neighbourhood(EdgeId e, std::vector<typename Graph::VertexId> &vertices) const override {
+        omnigraph::EdgeRemovalNeighbourhood(this->g(), e, vertices);
+    }
+
 public:
     LowCoverageEdgeRemovingAlgorithm(Graph &g,
                                      const std::string &condition_str,
@@ -365,6 +387,8 @@ public:
                 std::make_shared<omnigraph::ParallelInterestingElementFinder<Graph>>(
                         AddAlternativesPresenceCondition(g, parser()),
                         simplif_info.chunk_cnt());
+        if (parser.local())
+            this->ProcessInBatches();
     }
 
 private:
@@ -555,14 +579,19 @@ AlgoPtr<Graph> TipClipperInstance(Graph &g,
                                   const EdgeConditionT<Graph> &condition,
                                   const SimplifInfoContainer &info,
                                   EdgeRemovalHandlerF<Graph> removal_handler = nullptr,
-                                  bool track_changes = true) {
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
+                                  bool track_changes = true,
+                                  bool batched = false) {
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
                                                                         AddTipCondition(g, condition),
                                                                         info.chunk_cnt(),
                                                                         removal_handler,
                                                                         /*canonical_only*/true,
                                                                         LengthComparator<Graph>(g),
                                                                         track_changes);
+    // The condition must depend only on the edge neighbourhood
+    if (batched)
+        algo->ProcessInBatches();
+    return algo;
 }
 
 template<class Graph>
@@ -575,7 +604,8 @@ AlgoPtr<Graph> TipClipperInstance(Graph &g,
 
     ConditionParser<Graph> parser(g, tc_config.condition, info);
     auto condition = parser();
-    auto algo = TipClipperInstance(g, condition, info, removal_handler);
+    auto algo = TipClipperInstance(g, condition, info, removal_handler,
+                                   /*track changes*/true, /*batched*/parser.local());
     CHECK_FATAL_ERROR(parser.requested_iterations() != 0, "To disable tip clipper pass empty string");
     if (parser.requested_iterations() == 1)
         return algo;
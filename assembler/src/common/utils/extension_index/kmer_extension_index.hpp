@@ -84,6 +84,16 @@ public:
         return mask_;
     }
 
+    template<class Writer>
+    void BinWrite(Writer &writer) const {
+        io::binary::BinWrite(writer, mask_);
+    }
+
+    template<class Reader>
+    void BinRead(Reader &reader) {
+        io::binary::BinRead(reader, mask_);
+    }
+
     template<class Key>
     InOutMask conjugate(const Key & /*k*/) const {
         return InOutMask(invert_byte(mask_));
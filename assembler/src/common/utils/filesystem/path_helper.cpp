@@ -12,6 +12,7 @@
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -155,6 +156,22 @@ void remove_if_exists(std::string const& path) {
     }
 }
 
+void link_or_copy(std::string const& from, std::string const& to) {
+    remove_if_exists(to);
+    if (link(from.c_str(), to.c_str()) == 0)
+        return;
+
+    std::ifstream src(from, std::ios::binary);
+    std::ofstream dst(to, std::ios::binary);
+    if (!src || !dst)
+        throw std::ios_base::failure("Cannot copy file " + from + " to " + to);
+    // Inserting an empty buffer sets failbit
+    if (filesize(from))
+        dst << src.rdbuf();
+    if (!dst)
+        throw std::ios_base::failure("Cannot copy file " + from + " to " + to);
+}
+
 //TODO do we need to screen anything but whitespaces?
 std::string screen_whitespaces(std::string const &path) {
     std::string to_search = " ";
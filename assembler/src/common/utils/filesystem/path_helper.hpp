@@ -43,6 +43,10 @@ bool check_existence(std::string const &path);
 
 void remove_if_exists(std::string const &path);
 
+// Makes a hard link to the file (copies it if the link cannot be made, e.g.
+// across file systems), the destination is replaced
+void link_or_copy(std::string const &from, std::string const &to);
+
 std::string screen_whitespaces(std::string const &path);
 
 /**
@@ -5,8 +5,15 @@
 #include "adt/cqf.hpp"
 #include "ph_map/storing_traits.hpp"
 #include "io/reads/read_processor.hpp"
+#include "utils/filesystem/temporary.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 #include "utils/logger/logger.hpp"
+#include "utils/memory_limit.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <vector>
 
 namespace utils {
 
@@ -95,15 +102,19 @@ public:
     }
 
     void ProcessKmer(const RtSeq &/*kmer*/, uint64_t hash) {
+        ProcessHash(hash);
+    }
+
+    void ProcessHash(uint64_t hash, uint64_t count = 1) {
         // First try and insert in the main QF. If lock can't be
         // acquired in the first attempt then insert the item in the
         // local QF.
         if (cqf_.lookup(hash, /* lock */ true) >= thr_)
             return;
 
-        if (!cqf_.add(hash, /* count */ 1,
+        if (!cqf_.add(hash, count,
                 /* lock */ true, /* spin */ false)) {
-            local_cqf_.add(hash, /* count */ 1,
+            local_cqf_.add(hash, count,
                     /* lock */ false, /* spin */ false);
             if (local_cqf_.insertions() > local_cqf_.slots() / 2)
                 cqf_.merge(local_cqf_);
@@ -112,6 +123,93 @@ public:
 
 };
 
+/// Feeds k-mer hashes into the HLL and stages them for the CQF, which could
+/// not be created until the number of distinct k-mers is estimated. Full
+/// staging buffers are sorted and spilled to disk, every hash is staged at
+/// most thr times.
+class KmerSketchProcessor {
+    hll::hll<> &hll_;
+    fs::TmpDir workdir_;
+    const size_t capacity_;
+    const unsigned thr_;
+    std::vector<uint64_t> buffer_;
+    fs::TmpFile spill_;
+    size_t spilled_;
+
+public:
+    KmerSketchProcessor(hll::hll<> &hll, fs::TmpDir workdir,
+                        size_t capacity, unsigned thr)
+            : hll_(hll), workdir_(workdir),
+              capacity_(std::max(capacity, size_t(1))), thr_(std::max(thr, 1u)),
+              spilled_(0) {
+        buffer_.reserve(capacity_);
+    }
+
+    void ProcessKmer(const RtSeq &/*kmer*/, uint64_t hash) {
+        hll_.add(hash);
+        buffer_.push_back(hash);
+        if (buffer_.size() >= capacity_)
+            Spill();
+    }
+
+    size_t spilled() const { return spilled_; }
+
+    /// Replays all the staged hashes into the CQF and releases the buffers.
+    void Flush(CQFProcessor &processor) {
+        Collapse();
+        Replay(processor);
+
+        if (spill_) {
+            std::ifstream is(spill_->file(), std::ios::binary);
+            while (is) {
+                buffer_.resize(capacity_);
+                is.read(reinterpret_cast<char*>(buffer_.data()), std::streamsize(capacity_ * sizeof(uint64_t)));
+                buffer_.resize(size_t(is.gcount()) / sizeof(uint64_t));
+                Replay(processor);
+            }
+            spill_.reset();
+        }
+
+        std::vector<uint64_t>().swap(buffer_);
+    }
+
+private:
+    // Sorts the buffer and truncates the runs of equal hashes to thr
+    void Collapse() {
+        std::sort(buffer_.begin(), buffer_.end());
+        size_t out = 0;
+        for (size_t i = 0, run = 0; i < buffer_.size(); ++i) {
+            run = (i && buffer_[i] == buffer_[i - 1] ? run + 1 : 1);
+            if (run <= thr_)
+                buffer_[out++] = buffer_[i];
+        }
+        buffer_.resize(out);
+    }
+
+    void Spill() {
+        Collapse();
+        if (!spill_)
+            spill_ = workdir_->tmp_file("kmer_sketch");
+
+        std::ofstream os(spill_->file(), std::ios::binary | std::ios::app);
+        os.write(reinterpret_cast<const char*>(buffer_.data()), std::streamsize(buffer_.size() * sizeof(uint64_t)));
+        CHECK_FATAL_ERROR(os, "Failed to write " << spill_->file());
+        spilled_ += buffer_.size();
+        buffer_.clear();
+    }
+
+    // Runs of equal hashes are added at once
+    void Replay(CQFProcessor &processor) const {
+        for (size_t i = 0; i < buffer_.size(); ) {
+            size_t j = i + 1;
+            while (j < buffer_.size() && buffer_[j] == buffer_[i])
+                ++j;
+            processor.ProcessHash(buffer_[i], j - i);
+            i = j;
+        }
+    }
+};
+
 template<class Hasher, class KMerFilter = utils::StoringTypeFilter<utils::SimpleStoring>>
 class HllFiller {
  private:
@@ -269,4 +367,78 @@ void FillCoverageHistogram(qf::cqf &cqf, unsigned k, const Hasher &hasher, ReadS
     INFO("Total " << reads << " reads processed");
 }
 
+/// Fused EstimateCardinalityUpperBound() and FillCoverageHistogram(): the
+/// reads are processed once. The CQF is sized by the HLL estimate obtained
+/// at the end of the pass, the k-mers are staged meanwhile in the buffers of
+/// buffer_size bytes per stream (spilled into workdir when full).
+template<class Hasher, class ReadStream, class KMerFilter = utils::StoringTypeFilter<utils::SimpleStoring>>
+std::unique_ptr<qf::cqf> SketchCoverageHistogram(unsigned k, const Hasher &hasher, ReadStream &streams,
+                                                 unsigned thr, fs::TmpDir workdir, size_t buffer_size = 0,
+                                                 const KMerFilter &filter = utils::StoringTypeFilter<utils::SimpleStoring>()) {
+    unsigned stream_num = unsigned(streams.size());
+    if (buffer_size == 0) {
+        buffer_size = 536870912ull;
+        size_t mem_limit = (size_t)((double)(utils::get_free_memory()) / (stream_num * 3));
+        INFO("Memory available for k-mer staging buffers: " << (double)mem_limit / 1024.0 / 1024.0 / 1024.0 << " Gb");
+        buffer_size = std::min(buffer_size, mem_limit);
+    }
+
+    std::vector<hll::hll<>> hlls(stream_num);
+    std::vector<KmerSketchProcessor> processors;
+    processors.reserve(stream_num);
+    for (unsigned i = 0; i < stream_num; ++i)
+        processors.emplace_back(hlls[i], workdir, buffer_size / sizeof(uint64_t), thr);
+
+    INFO("Counting threshold " << thr);
+    streams.reset();
+    size_t reads = 0, n = 15;
+    while (!streams.eof()) {
+        #pragma omp parallel for reduction(+:reads)
+        for (unsigned i = 0; i < stream_num; ++i) {
+            reads += FillFromStream(streams[i], hasher, processors[i], k, 1000000, filter);
+        }
+
+        if (reads >> n) {
+            INFO("Processed " << reads << " reads");
+            n += 1;
+        }
+    }
+    INFO("Total " << reads << " reads processed");
+
+    size_t spilled = 0;
+    for (const auto &processor : processors)
+        spilled += processor.spilled();
+    if (spilled)
+        INFO("Spilled " << spilled << " k-mers to disk");
+
+    for (size_t i = 1; i < hlls.size(); ++i) {
+        hlls[0].merge(hlls[i]);
+        hlls[i].clear();
+    }
+
+    size_t kmers = size_t(hlls[0].upper_bound_cardinality());
+    INFO("Estimated " << kmers << " distinct kmers");
+
+    // Create main CQF using # of slots derived from estimated # of k-mers
+    std::unique_ptr<qf::cqf> cqf(new qf::cqf(kmers));
+    std::vector<qf::cqf> local_cqfs;
+    local_cqfs.reserve(stream_num);
+    for (unsigned i = 0; i < stream_num; ++i)
+        local_cqfs.emplace_back(1 << 16, cqf->hash_bits());
+
+    INFO("Filling k-mer coverage histogram");
+    #pragma omp parallel for
+    for (unsigned i = 0; i < stream_num; ++i) {
+        CQFProcessor processor(*cqf, local_cqfs[i], thr);
+        processors[i].Flush(processor);
+    }
+
+    INFO("Merging local CQF");
+    for (unsigned i = 0; i < stream_num; ++i) {
+        cqf->merge(local_cqfs[i]);
+    }
+
+    return cqf;
+}
+
 }
@@ -0,0 +1,114 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <string>
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace kmers {
+
+// Set of raw k-mer bucket files that stay open during the whole split. Every
+// flush appends a sorted run to the bucket file with a single large write and
+// records its length. Run lengths are kept in memory and written to the
+// companion .idx file on close(), so only one descriptor per bucket is used.
+// Different buckets might be appended concurrently, however, a single bucket
+// must not be written by several threads at the same time.
+class RawKMerBucketWriters {
+    struct Bucket {
+        std::string fname;
+        int fd = -1;
+        std::vector<size_t> runs;
+    };
+
+public:
+    RawKMerBucketWriters() = default;
+    RawKMerBucketWriters(const RawKMerBucketWriters &) = delete;
+    RawKMerBucketWriters &operator=(const RawKMerBucketWriters &) = delete;
+    RawKMerBucketWriters(RawKMerBucketWriters &&) = default;
+    RawKMerBucketWriters &operator=(RawKMerBucketWriters &&other) {
+        close();
+        buckets_ = std::move(other.buckets_);
+        other.buckets_.clear();
+        return *this;
+    }
+
+    ~RawKMerBucketWriters() {
+        close();
+    }
+
+    template<class Files>
+    void open(const Files &files) {
+        close();
+
+        buckets_.resize(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            Bucket &bucket = buckets_[i];
+            bucket.fname = files[i]->file();
+            bucket.fd = ::open(bucket.fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, (mode_t) 0600);
+            CHECK_FATAL_ERROR(bucket.fd != -1,
+                              "Cannot open temporary file " << bucket.fname << " for writing. Reason: " << strerror(errno) << ". Error code: " << errno);
+        }
+    }
+
+    bool is_open() const { return !buckets_.empty(); }
+    size_t size() const { return buckets_.size(); }
+
+    void append(size_t idx, const void *data, size_t el_size, size_t cnt) {
+        Bucket &bucket = buckets_.at(idx);
+        VERIFY(bucket.fd != -1);
+
+        write_all(bucket.fd, data, el_size * cnt, bucket.fname);
+        bucket.runs.push_back(cnt);
+    }
+
+    void close() {
+        for (Bucket &bucket : buckets_) {
+            if (bucket.fd == -1)
+                continue;
+
+            int res = ::close(bucket.fd);
+            CHECK_FATAL_ERROR(res == 0,
+                              "I/O error! Cannot close " << bucket.fname << ". Reason: " << strerror(errno) << ". Error code: " << errno);
+            bucket.fd = -1;
+
+            std::string idx_fname = bucket.fname + ".idx";
+            int fd = ::open(idx_fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, (mode_t) 0600);
+            CHECK_FATAL_ERROR(fd != -1,
+                              "Cannot open temporary file " << idx_fname << " for writing. Reason: " << strerror(errno) << ". Error code: " << errno);
+            write_all(fd, bucket.runs.data(), bucket.runs.size() * sizeof(size_t), idx_fname);
+            ::close(fd);
+        }
+
+        buckets_.clear();
+    }
+
+private:
+    static void write_all(int fd, const void *data, size_t amount, const std::string &fname) {
+        const char *buf = static_cast<const char*>(data);
+        while (amount) {
+            ssize_t res = ::write(fd, buf, amount);
+            if (res == -1 && errno == EINTR)
+                continue;
+            CHECK_FATAL_ERROR(res > 0,
+                              "I/O error! Incomplete write to " << fname << "! Reason: " << strerror(errno) << ". Error code: " << errno);
+            buf += res;
+            amount -= size_t(res);
+        }
+    }
+
+    std::vector<Bucket> buckets_;
+};
+
+}
@@ -12,6 +12,7 @@
 #include <boomphf/BooPHF.h>
 
 #include <vector>
+#include <algorithm>
 #include <cmath>
 
 #define XXH_INLINE_ALL
@@ -89,6 +90,28 @@ public:
     return (idx == -1ULL ? idx : segment_starts_[bucket] + idx);
   }
 
+  // Batched version of seq_idx(): all the k-mers are hashed and the bitset
+  // words they need are prefetched before any of them is resolved
+  void seq_idx(const KMerSeq *s, size_t n, size_t *res) const {
+    const size_t batch = 32;
+    size_t buckets[batch];
+    boomphf::hash_pair_t hashes[batch];
+
+    for (size_t start = 0; start < n; start += batch) {
+      size_t cnt = std::min(batch, n - start);
+      for (size_t i = 0; i < cnt; ++i) {
+        buckets[i] = seq_bucket(s[start + i]);
+        hashes[i] = index_[buckets[i]].hash(s[start + i]);
+        index_[buckets[i]].prefetch(hashes[i]);
+      }
+
+      for (size_t i = 0; i < cnt; ++i) {
+        size_t idx = index_[buckets[i]].lookup_hash(hashes[i]);
+        res[start + i] = (idx == -1ULL ? idx : segment_starts_[buckets[i]] + idx);
+      }
+    }
+  }
+
   size_t raw_seq_idx(const KMerRawReference data) const {
     size_t bucket = raw_seq_bucket(data);
     size_t idx = index_[bucket].lookup(data);
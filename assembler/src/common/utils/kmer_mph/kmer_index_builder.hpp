@@ -18,15 +18,15 @@
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/filesystem/file_limit.hpp"
 #include "utils/perf/timetracer.hpp"
+#include "utils/perf/perfcounter.hpp"
 
 #include "adt/kmer_vector.hpp"
+#include "adt/kmer_radix_sort.hpp"
 #include "adt/iterator_range.hpp"
 #include "adt/loser_tree.hpp"
 
 #include <boomphf/BooPHF.h>
 
-#include <libcxx/sort.hpp>
-
 #include <algorithm>
 #ifdef USE_GLIBCXX_PARALLEL
 #include <parallel/algorithm>
@@ -165,6 +165,46 @@ class KMerDiskStorage {
   size_t num_buckets() const { return buckets_.size(); }
   KMerSegmentPolicy segment_policy() const { return segment_policy_; }
 
+  // Stores the k-mer files into the directory. The files are never changed
+  // once written, so they are hard linked whenever possible.
+  void save(const std::string &dir) const {
+    std::ofstream ofs(fs::append_path(dir, "kmers.info"));
+    ofs << k_ << ' ' << segment_policy_.num_segments() << ' '
+        << buckets_.size() << ' ' << bool(all_kmers_) << '\n';
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      if (buckets_[i])
+        fs::link_or_copy(*buckets_[i], fs::append_path(dir, "kmers." + std::to_string(i)));
+    }
+    if (all_kmers_)
+      fs::link_or_copy(*all_kmers_, fs::append_path(dir, "final_kmers"));
+    if (!ofs)
+      throw std::ios_base::failure("Cannot save k-mer storage to " + dir);
+  }
+
+  // Loads the storage stored by save(), the files are placed into the work dir
+  static KMerDiskStorage load(fs::TmpDir work_dir, const std::string &dir) {
+    std::ifstream ifs(fs::append_path(dir, "kmers.info"));
+    unsigned k;
+    size_t num_segments, num_buckets;
+    bool merged;
+    if (!(ifs >> k >> num_segments >> num_buckets >> merged))
+      throw std::ios_base::failure("Cannot load k-mer storage from " + dir);
+
+    KMerDiskStorage res(work_dir, k, KMerSegmentPolicy(num_segments));
+    res.resize(num_buckets);
+    for (size_t i = 0; i < num_buckets; ++i) {
+      std::string file = fs::append_path(dir, "kmers." + std::to_string(i));
+      if (fs::check_existence(file))
+        fs::link_or_copy(file, *res.create(i));
+    }
+    if (merged) {
+      res.all_kmers_ = work_dir->tmp_file("final_kmers");
+      fs::link_or_copy(fs::append_path(dir, "final_kmers"), *res.all_kmers_);
+    }
+
+    return res;
+  }
+
   void merge() {
     INFO("Merging final buckets.");
     TIME_TRACE_SCOPE("KMerDiskStorage::MergeFinal");
@@ -248,12 +288,40 @@ public:
 
     INFO("Starting k-mer counting.");
     KMerDiskStorage<Seq> res(work_dir_, this->k(), splitter_->bucket_policy());
+
+    // Skewed buckets would dominate the wall time if merged by a single
+    // thread. Merge all the ordinary buckets in parallel and then merge the
+    // large ones one by one using all the threads.
+    std::vector<size_t> small, large;
+    {
+        size_t total_size = 0;
+        std::vector<size_t> sizes(raw_kmers.size());
+        for (size_t i = 0; i < raw_kmers.size(); ++i)
+            total_size += (sizes[i] = fs::filesize(*raw_kmers[i]));
+
+        size_t large_size = 2 * total_size / raw_kmers.size();
+        for (size_t i = 0; i < raw_kmers.size(); ++i) {
+            if (num_threads > 1 && sizes[i] > large_size)
+                large.push_back(i);
+            else
+                small.push_back(i);
+        }
+    }
+
     size_t kmers = 0;
     {
         TIME_TRACE_SCOPE("KMerDiskCounter::Count");
 #       pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
-        for (size_t i = 0; i < raw_kmers.size(); ++i) {
-          kmers += MergeKMers(*raw_kmers[i], *res.create(i));
+        for (size_t j = 0; j < small.size(); ++j) {
+          size_t i = small[j];
+          kmers += MergeKMers(*raw_kmers[i], *res.create(i), 1);
+          raw_kmers[i].reset();
+        }
+
+        if (large.size())
+          INFO("Merging " << large.size() << " large buckets in parallel");
+        for (size_t i : large) {
+          kmers += MergeKMers(*raw_kmers[i], *res.create(i), num_threads);
           raw_kmers[i].reset();
         }
     }
@@ -278,85 +346,118 @@ private:
   std::unique_ptr<kmers::KMerSplitter<Seq>> splitter_;
   fs::TmpDir work_dir_;
 
-  size_t MergeKMers(const std::string &ifname, const std::string &ofname) {
-    MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
+  typedef typename Seq::DataType DataType;
+  typedef typename MMappedRecordArrayReader<DataType>::iterator RawIterator;
+  typedef adt::iterator_range<RawIterator> RawRun;
+
+  // Cuts every run into (at most) nparts pieces using pivots sampled from the
+  // runs themselves. All copies of the same k-mer belong to the same piece, so
+  // pieces could be merged independently and simply concatenated afterwards.
+  std::vector<std::vector<RawRun>> PartitionRuns(const std::vector<RawRun> &runs, size_t total, size_t nparts) const {
+    adt::array_less<DataType> less;
+
+    std::vector<RawIterator> samples;
+    size_t nsamples = 32 * nparts;
+    for (const auto &run : runs) {
+      size_t sz = run.end() - run.begin();
+      size_t cnt = std::min(sz, (nsamples * sz + total - 1) / total);
+      for (size_t i = 0; i < cnt; ++i)
+        samples.push_back(run.begin() + i * sz / cnt);
+    }
+    std::sort(samples.begin(), samples.end(),
+              [&](const RawIterator &lhs, const RawIterator &rhs) { return less(*lhs, *rhs); });
+
+    std::vector<RawIterator> pivots;
+    for (size_t i = 1; i < nparts && !samples.empty(); ++i)
+      pivots.push_back(samples[i * samples.size() / nparts]);
+
+    std::vector<std::vector<RawRun>> parts(pivots.size() + 1);
+    for (const auto &run : runs) {
+      auto beg = run.begin();
+      for (size_t i = 0; i < pivots.size(); ++i) {
+        auto end = std::lower_bound(beg, run.end(), *pivots[i], less);
+        parts[i].push_back(adt::make_range(beg, end));
+        beg = end;
+      }
+      parts.back().push_back(adt::make_range(beg, run.end()));
+    }
+
+    return parts;
+  }
+
+  size_t MergeKMers(const std::string &ifname, const std::string &ofname, unsigned num_threads) {
+    MMappedRecordArrayReader<DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
 
     std::string IdxFileName = ifname + ".idx";
     if (FILE *f = fopen(IdxFileName.c_str(), "rb")) {
       fclose(f);
+      TIME_TRACE_SCOPE("KMerDiskCounter::MergeKMers", ifname);
+      utils::perf_counter pc;
+
       MMappedRecordReader<size_t> index(ifname + ".idx", true, -1ULL);
 
       // INFO("Total runs: " << index.size());
 
       // Prepare runs
-      std::vector<adt::iterator_range<decltype(ins.begin())>> ranges;
+      std::vector<RawRun> ranges;
       auto beg = ins.begin();
       for (size_t sz : index) {
         auto end = std::next(beg, sz);
         ranges.push_back(adt::make_range(beg, end));
-        VERIFY(std::is_sorted(beg, end, adt::array_less<typename Seq::DataType>()));
+        VERIFY(std::is_sorted(beg, end, adt::array_less<DataType>()));
         beg = end;
       }
 
-      // Construct tree on top entries of runs
-      adt::loser_tree<decltype(beg),
-              adt::array_less<typename Seq::DataType>> tree(ranges);
+      size_t total = 0;
+      {
+        // The output is written in place into a single file reserved for the
+        // worst case (no duplicates at all) and truncated afterwards.
+        MMappedRecordArrayWriter<DataType> os(ofname, Seq::GetDataSize(this->k()));
+        if (ins.size() == 0)
+          return 0;
+        os.resize(ins.size());
+
+        auto parts = PartitionRuns(ranges, ins.size(), num_threads > 1 ? 4 * num_threads : 1);
+        std::vector<size_t> offsets(parts.size() + 1, 0), counts(parts.size(), 0);
+        for (size_t i = 0; i < parts.size(); ++i) {
+          offsets[i + 1] = offsets[i];
+          for (const auto &run : parts[i])
+            offsets[i + 1] += run.end() - run.begin();
+        }
 
-      if (tree.empty()) {
-        FILE *g = fopen(ofname.c_str(), "ab");
-        if (!g)
-          FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-        fclose(g);
-        return 0;
-      }
+#       pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+        for (size_t i = 0; i < parts.size(); ++i) {
+          adt::loser_tree<RawIterator, adt::array_less<DataType>> tree(parts[i]);
+          counts[i] = tree.multi_merge_unique(os.begin() + offsets[i]);
+        }
 
-      // Write it down!
-      adt::KMerVector<Seq> buf(this->k(), 1024*1024);
-      size_t total = 0;
-      while (!tree.empty()) {
-          buf.clear();
-          buf.push_back(tree.pop());
-          size_t cnt = 1;
-
-          while (cnt < buf.capacity()) {
-            while (!tree.empty() &&
-                   adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
-              tree.replay();
-
-            if (tree.empty())
-              break;
-
-            buf.push_back(tree.top());
-            tree.replay();
-            cnt += 1;
-          }
-
-          // Handle the last value
-          while (!tree.empty() &&
-                 adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
-            tree.replay();
-
-          total += buf.size();
-
-          FILE *g = fopen(ofname.c_str(), "ab");
-          if (!g)
-            FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-          size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), g);
-          if (res != buf.size())
-            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-          fclose(g);
+        // Close the gaps left by the duplicates
+        size_t el_bytes = ins.begin().data_size();
+        for (size_t i = 0; i < parts.size(); ++i) {
+          if (total != offsets[i])
+            memmove((char*)os.data() + total * el_bytes, (char*)os.data() + offsets[i] * el_bytes, counts[i] * el_bytes);
+          total += counts[i];
+        }
       }
 
+      int res = truncate(ofname.c_str(), total * ins.begin().data_size());
+      CHECK_FATAL_ERROR(res == 0,
+                        "truncate(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno);
+
+      DEBUG("Merged " << ranges.size() << " runs of " << ifname << " using " << num_threads << " threads: "
+            << total << " unique k-mers out of " << ins.size() << ", "
+            << (double)ins.size() / std::max(pc.time(), 1e-6) / 1e6 << "M k-mers per second");
+
       return total;
     } else {
       // Sort the stuff
-      libcxx::sort(ins.begin(), ins.end(), adt::array_less<typename Seq::DataType>());
+      adt::kmer_radix_sort(ins.begin(), ins.end());
 
       // FIXME: Use something like parallel version of unique_copy but with explicit
       // resizing.
-      auto it = std::unique(ins.begin(), ins.end(), adt::array_equal_to<typename Seq::DataType>());
+      auto it = std::unique(ins.begin(), ins.end(), adt::array_equal_to<DataType>());
 
-      MMappedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(this->k()));
+      MMappedRecordArrayWriter<DataType> os(ofname, Seq::GetDataSize(this->k()));
       os.resize(it - ins.begin());
       std::copy(ins.begin(), it, os.begin());
 
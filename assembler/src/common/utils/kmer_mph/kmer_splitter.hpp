@@ -7,14 +7,15 @@
 #pragma once
 
 #include "kmer_buckets.hpp"
+#include "kmer_bucket_writer.hpp"
 
 #include "adt/kmer_vector.hpp"
+#include "adt/kmer_radix_sort.hpp"
 #include "utils/filesystem/file_limit.hpp"
 #include "utils/filesystem/temporary.hpp"
 #include "utils/memory_limit.hpp"
 #include "utils/logger/logger.hpp"
 
-#include <libcxx/sort.hpp>
 #include <string>
 #include <cstdio>
 
@@ -67,6 +68,7 @@ protected:
     using KMerBuffer = std::vector<SeqKMerVector>;
 
     std::vector<KMerBuffer> kmer_buffers_;
+    RawKMerBucketWriters writers_;
     size_t cell_size_;
     size_t num_files_;
 
@@ -86,6 +88,8 @@ protected:
             WARN("Failed to setup necessary limit for number of open files. The process might crash later on.");
             WARN("Do 'ulimit -n " << file_limit << "' in the console to overcome the limit");
         }
+        // Bucket files are kept open until ClearBuffers()
+        writers_.open(out);
 
         if (reads_buffer_size == 0) {
             reads_buffer_size = 536870912ull;
@@ -119,6 +123,7 @@ protected:
 
     void DumpBuffers(const RawKMers &ostreams) {
         VERIFY(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_);
+        VERIFY(writers_.size() == num_files_);
 
 #   pragma omp parallel for
         for (size_t k = 0; k < num_files_; ++k) {
@@ -134,31 +139,11 @@ protected:
                 for (size_t j = 0; j < buffer.size(); ++j)
                     SortBuffer.push_back(buffer[j]);
             }
-            libcxx::sort(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::less2_fast());
+            adt::kmer_radix_sort(SortBuffer);
             auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
 
-#     pragma omp critical
-            {
-                size_t cnt =  it - SortBuffer.begin();
-
-                // Write k-mers
-                FILE *f = fopen(ostreams[k]->file().c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                size_t res = fwrite(SortBuffer.data(), SortBuffer.el_data_size(), cnt, f);
-                if (res != cnt)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
-
-                // Write index
-                f = fopen((ostreams[k]->file() + ".idx").c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                res = fwrite(&cnt, sizeof(cnt), 1, f);
-                if (res != 1)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
-            }
+            // Every bucket is owned by a single iteration, so no synchronization is necessary here
+            writers_.append(k, SortBuffer.data(), SortBuffer.el_data_size(), it - SortBuffer.begin());
         }
 
         for (auto & entry : kmer_buffers_)
@@ -167,6 +152,7 @@ protected:
     }
 
     void ClearBuffers() {
+        writers_.close();
         for (auto & entry : kmer_buffers_)
             for (auto & eentry : entry) {
                 eentry.clear();
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "kmer_splitter.hpp"
+#include "sequence/kmer_extractor.hpp"
 #include "io/reads/io_helper.hpp"
 #include "adt/iterator_range.hpp"
 
@@ -27,14 +28,20 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
       if (seq.size() < this->K_)
         return false;
 
-      RtSeq kmer = seq.start<RtSeq>(this->K_) >> 'A';
+      KMerExtractor &extractor = KMerExtractor::local(this->K_);
+      size_t nkmers = extractor.reset(seq);
+      RtSeq kmers[KMerExtractor::BATCH_SIZE];
+      bool is_minimal[KMerExtractor::BATCH_SIZE];
       bool stop = false;
-      for (size_t j = this->K_ - 1; j < seq.size(); ++j) {
-        kmer <<= seq[j];
-        if (!kmer_filter_.filter(kmer))
-          continue;
-
-        stop |= this->push_back_internal(kmer, thread_id);
+      for (size_t from = 0; from < nkmers; from += KMerExtractor::BATCH_SIZE) {
+        size_t cnt = std::min(size_t(KMerExtractor::BATCH_SIZE), nkmers - from);
+        extractor.kmers(from, cnt, kmers, is_minimal);
+        for (size_t i = 0; i < cnt; ++i) {
+          if (!kmer_filter_.filter(kmers[i], is_minimal[i]))
+            continue;
+
+          stop |= this->push_back_internal(kmers[i], thread_id);
+        }
       }
 
       return stop;
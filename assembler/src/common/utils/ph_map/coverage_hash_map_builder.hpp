@@ -6,6 +6,7 @@
 //***************************************************************************
 
 #include "perfect_hash_map_builder.hpp"
+#include "sequence/kmer_extractor.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 #include <cstdlib>
 
@@ -14,9 +15,11 @@ namespace utils {
 struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
     template<class ReadStream, class Index>
     void FillCoverageFromStream(ReadStream &stream, Index &index) const {
-        typedef typename Index::KeyType Kmer;
         unsigned k = index.k();
 
+        KMerExtractor extractor(k);
+        RtSeq kmers[KMerExtractor::BATCH_SIZE];
+        bool is_minimal[KMerExtractor::BATCH_SIZE];
         while (!stream.eof()) {
             typename ReadStream::ReadT r;
             stream >> r;
@@ -25,14 +28,21 @@ struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
             if (seq.size() < k)
                 continue;
 
-            typename Index::KeyWithHash kwh = index.ConstructKWH(seq.start<Kmer>(k) >> 'A');
-            for (size_t j = k - 1; j < seq.size(); ++j) {
-                kwh <<= seq[j];
-                if (!kwh.is_minimal() || !index.valid(kwh))
-                    continue;
+            size_t nkmers = extractor.reset(seq);
+            for (size_t from = 0; from < nkmers; from += KMerExtractor::BATCH_SIZE) {
+                size_t cnt = std::min(size_t(KMerExtractor::BATCH_SIZE), nkmers - from);
+                extractor.kmers(from, cnt, kmers, is_minimal);
+                for (size_t i = 0; i < cnt; ++i) {
+                    if (!StoringTypeFilter<typename Index::storing_type>::filter(kmers[i], is_minimal[i]))
+                        continue;
+
+                    typename Index::KeyWithHash kwh = index.ConstructKWH(kmers[i]);
+                    if (!index.valid(kwh))
+                        continue;
 
 #                   pragma omp atomic
-                index.get_raw_value_reference(kwh) += 1;
+                    index.get_raw_value_reference(kwh) += 1;
+                }
             }
         }
     }
@@ -36,6 +36,16 @@ public:
     SimpleKeyWithHash(Key key, const HashFunction &hash)
             : hash_(hash), key_(key), idx_(0), ready_(false) {}
 
+    // The index of the key is already known
+    SimpleKeyWithHash(Key key, const HashFunction &hash, IdxType idx, bool /*is_minimal*/)
+            : hash_(hash), key_(key), idx_(idx), ready_(true) {}
+
+    // The key the index is computed for
+    static Key hashed_key(const Key &key, bool &is_minimal) {
+        is_minimal = true;
+        return key;
+    }
+
     Key key() const {
         return key_;
     }
@@ -136,6 +146,16 @@ private:
     InvertableKeyWithHash(Key key, const HashFunction &hash)
             : hash_(hash), key_(key), idx_(0), is_minimal_(false), ready_(false) {}
 
+    // The index of the canonical key is already known
+    InvertableKeyWithHash(Key key, const HashFunction &hash, IdxType idx, bool is_minimal)
+            : hash_(hash), key_(key), idx_(idx), is_minimal_(is_minimal), ready_(true) {}
+
+    // The key the index is computed for, its minimality is reported
+    static Key hashed_key(const Key &key, bool &is_minimal) {
+        is_minimal = key.IsMinimal();
+        return is_minimal ? key : !key;
+    }
+
     const Key &key() const {
         return key_;
     }
@@ -192,6 +192,18 @@ public:
         return io::make_raw_kmer_iterator<KMer>(*this->kmers_, base::k(), parts);
     }
 
+    // The map itself is (de)serialized via BinWrite / BinRead, the k-mers
+    // file is stored separately
+    void SaveKMers(const std::string &file) const {
+        VERIFY(kmers_ && "Index should be built");
+        fs::link_or_copy(*kmers_, file);
+    }
+
+    void LoadKMers(const std::string &file, fs::TmpDir workdir) {
+        kmers_ = workdir->tmp_file("final_kmers");
+        fs::link_or_copy(file, *kmers_);
+    }
+
     friend struct KeyIteratingIndexBuilder;
 };
 
@@ -17,6 +17,7 @@
 #include "utils/verify.hpp"
 
 #include <vector>
+#include <algorithm>
 #include <cstdlib>
 #include <cstdint>
 
@@ -86,6 +87,7 @@ public:
     using KeyBase::index_ptr_;
     typedef typename KeyBase::KMerIndexT KMerIndexT;
     typedef typename StoringTraits<K, KMerIndexT, StoringType>::KeyWithHash KeyWithHash;
+    typedef StoringType storing_type;
 
     PerfectHashMap(unsigned k)
             : KeyBase(k) {}
@@ -99,6 +101,32 @@ public:
         return KeyWithHash(key, *index_ptr_);
     }
 
+    // Constructs KWHs for a batch of keys. The indices are computed for the
+    // whole batch at once, so the memory accesses of the lookups overlap.
+    void ConstructKWH(const KeyType *keys, size_t n, std::vector<KeyWithHash> &res) const {
+        const size_t batch = 32;
+        KeyType hashed[batch];
+        size_t idx[batch];
+        bool is_minimal[batch];
+
+        res.clear();
+        res.reserve(n);
+        for (size_t start = 0; start < n; start += batch) {
+            size_t cnt = std::min(batch, n - start);
+            for (size_t i = 0; i < cnt; ++i)
+                hashed[i] = KeyWithHash::hashed_key(keys[start + i], is_minimal[i]);
+            index_ptr_->seq_idx(hashed, cnt, idx);
+            for (size_t i = 0; i < cnt; ++i)
+                res.emplace_back(keys[start + i], *index_ptr_, idx[i], is_minimal[i]);
+        }
+    }
+
+    // Hints the cache about the value that is going to be read
+    void prefetch_value(const KeyWithHash &kwh) const {
+        if (KeyBase::valid(kwh.idx()))
+            __builtin_prefetch(&data_[kwh.idx()]);
+    }
+
     bool valid(const KeyWithHash &kwh) const {
         return KeyBase::valid(kwh.idx());
     }
@@ -85,6 +85,11 @@ struct StoringTypeFilter<SimpleStoring> {
     static bool filter(const Kmer &/*kmer*/) {
         return true;
     }
+
+    template<class Kmer>
+    static bool filter(const Kmer &/*kmer*/, bool /*is_minimal*/) {
+        return true;
+    }
 };
 
 template<>
@@ -98,6 +103,12 @@ struct StoringTypeFilter<InvertableStoring> {
     static bool filter(const Kmer &kmer) {
         return kmer.IsMinimal();
     }
+
+    // Minimality is already known (e.g. from KMerExtractor)
+    template<class Kmer>
+    static bool filter(const Kmer &/*kmer*/, bool is_minimal) {
+        return is_minimal;
+    }
 };
 
 }
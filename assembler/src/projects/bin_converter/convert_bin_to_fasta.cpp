@@ -49,7 +49,7 @@ void process_cmdline(int argc, char **argv, convert_bin_to_fasta::Args &args) {
     bool print_help = false;
 
     auto cli = (
-        (option("--prefix") & value("path", args.prefix_file)) % "Prefix of .off and .seq file for contigs in binary format",
+        (option("--prefix") & value("path", args.prefix_file)) % "Prefix of .seq and .blk (or legacy .off) files for contigs in binary format",
         (option("--info_file") & value("path", args.info_file)) % "Path to info file for contigs in binary format",
         (option("-o", "--output_file") & value("path", args.output_file)) % "Output file name",
         (option("-h", "--help").set(print_help)) % "Show help"
@@ -70,7 +70,7 @@ void process_cmdline(int argc, char **argv, convert_bin_to_fasta::Args &args) {
     }
 
     if (args.prefix_file == "" || args.info_file == "") {
-        std::cerr << "ERROR: No binary file were specified (you should specify info file and prefix to .off and .seq)"
+        std::cerr << "ERROR: No binary file were specified (you should specify info file and prefix to .seq and .blk)"
                   << std::endl << std::endl;
         std::cout << help_message << std::endl;
         exit(-1);
@@ -78,6 +78,8 @@ void load(hammer_config& cfg, boost::property_tree::ptree const& pt) {
   load(cfg.input_trim_quality, pt, "input_trim_quality");
   cfg.input_qvoffset_opt = pt.get_optional<int>("input_qvoffset");
   load(cfg.output_dir, pt, "output_dir");
+  cfg.output_gzip = false;
+  load(cfg.output_gzip, pt, "output_gzip", false);
 
   cfg.general_max_nthreads = spades_set_omp_threads(cfg.general_max_nthreads);
 }
@@ -35,6 +35,7 @@ struct hammer_config {
   boost::optional<int> input_qvoffset_opt;
   int input_qvoffset;
   std::string output_dir;
+  bool output_gzip;
 
   bool general_do_everything_after_first_iteration;
   int general_hard_memory_limit;
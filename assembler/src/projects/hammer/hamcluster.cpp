@@ -14,6 +14,8 @@
 #include "config_struct_hammer.hpp"
 #include "globals.hpp"
 
+#include "utils/memory_limit.hpp"
+
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -109,9 +111,9 @@ static void processBlockQuadratic(dsu::ConcurrentDSU  &uf,
   }
 }
 
-void KMerHamClusterer::cluster(const std::string &prefix,
-                               const KMerData &data,
-                               dsu::ConcurrentDSU &uf) {
+void KMerHamClusterer::cluster_on_disk(const std::string &prefix,
+                                       const KMerData &data,
+                                       dsu::ConcurrentDSU &uf) {
   // First pass - split & sort the k-mers
   std::string fname = prefix + ".first", bfname = fname + ".blocks", kfname = fname + ".kmers";
   std::ofstream bfs(bfname, std::ios::out | std::ios::binary);
@@ -133,8 +135,6 @@ void KMerHamClusterer::cluster(const std::string &prefix,
 
   size_t big_blocks1 = 0;
   {
-    unsigned block_thr = cfg::get().hamming_blocksize_quadratic_threshold;
-
     INFO("Splitting sub-kmers, pass 1.");
     SubKMerSplitter Splitter(bfname, kfname);
 
@@ -145,7 +145,7 @@ void KMerHamClusterer::cluster(const std::string &prefix,
 
     std::pair<size_t, size_t> stat =
       Splitter.split([&] (const std::vector<size_t>::iterator &start, size_t sz) {
-        if (sz < block_thr) {
+        if (sz < block_thr_) {
           // Merge small blocks.
           processBlockQuadratic(uf, start, sz, data, tau_);
         } else {
@@ -204,6 +204,171 @@ void KMerHamClusterer::cluster(const std::string &prefix,
   }
 }
 
+// K-mers are compared by their 2-bit packed words: the XOR of the words is
+// folded into one bit per nucleotide and counted. SWAR popcount is used, so
+// the loop over the block is vectorized without any special target flags.
+typedef hammer::KMer::DataType KMerWord;
+static const size_t KMerWords = hammer::KMer::DataSize;
+
+static inline unsigned hamdistPacked(const KMerWord *x, const KMerWord *y) {
+  const KMerWord odd = KMerWord(0x5555555555555555ULL);
+  unsigned dist = 0;
+  for (size_t w = 0; w < KMerWords; ++w) {
+    KMerWord v = x[w] ^ y[w];
+    v = (v | (v >> 1)) & odd;
+    v = (v & KMerWord(0x3333333333333333ULL)) + ((v >> 2) & KMerWord(0x3333333333333333ULL));
+    v = (v + (v >> 4)) & KMerWord(0x0F0F0F0F0F0F0F0FULL);
+    dist += unsigned((v * KMerWord(0x0101010101010101ULL)) >> (sizeof(KMerWord) * 8 - 8));
+  }
+  return dist;
+}
+
+static void processBlockPacked(dsu::ConcurrentDSU &uf,
+                               const size_t *block, size_t block_size,
+                               const std::vector<hammer::KMer> &kmers,
+                               unsigned tau,
+                               std::vector<KMerWord> &packed, std::vector<unsigned> &dist) {
+  packed.resize(block_size * KMerWords);
+  for (size_t i = 0; i < block_size; ++i) {
+    const KMerWord *data = kmers[block[i]].data();
+    std::copy(data, data + KMerWords, packed.begin() + i * KMerWords);
+  }
+
+  dist.resize(block_size);
+  for (size_t i = 0; i < block_size; ++i) {
+    const KMerWord *x = packed.data() + i * KMerWords;
+    for (size_t j = i + 1; j < block_size; ++j)
+      dist[j] = hamdistPacked(x, packed.data() + j * KMerWords);
+
+    size_t bx = block[i];
+    for (size_t j = i + 1; j < block_size; ++j) {
+      size_t by = block[j];
+      if (dist[j] <= tau &&
+          !uf.same(bx, by) &&
+          canMerge(uf, bx, by)) {
+        uf.unite(bx, by);
+      }
+    }
+  }
+}
+
+// Sorts the projections of the k-mers and returns the starts of the blocks of
+// equal sub-k-mers (followed by the size)
+template<class SubKMerSerializer>
+static void splitProjections(const std::vector<hammer::KMer> &kmers,
+                             std::vector<SubKMer> &subkmers, size_t *idx, size_t sz,
+                             const SubKMerSerializer &serializer,
+                             std::vector<size_t> &starts, int nthreads) {
+  subkmers.resize(sz);
+# pragma omp parallel for if(nthreads != 1)
+  for (size_t i = 0; i < sz; ++i)
+    subkmers[i] = serializer.serialize(kmers[idx[i]]);
+
+  using PairSort = parallel_radix_sort::PairSort<SubKMer, size_t, SubKMer, EncoderKMer>;
+  PairSort::InitAndSort(subkmers.data(), idx, sz, nthreads);
+
+  starts.clear();
+  for (size_t i = 0; i < sz; ++i) {
+    if (i == 0 || subkmers[i] != subkmers[i - 1])
+      starts.push_back(i);
+  }
+  starts.push_back(sz);
+}
+
+size_t KMerHamClusterer::in_memory_footprint(size_t kmers) const {
+  // k-mers, projections with indices (doubled by the sort) and big blocks
+  return kmers * (sizeof(hammer::KMer) + 2 * (sizeof(SubKMer) + sizeof(size_t)) +
+                  (tau_ + 1) * sizeof(size_t));
+}
+
+void KMerHamClusterer::cluster(const std::string &prefix,
+                               const KMerData &data,
+                               dsu::ConcurrentDSU &uf) {
+  size_t needed = in_memory_footprint(data.size()), available = utils::get_free_memory();
+  if (needed < available / 2) {
+    INFO("Clustering in memory, approx. " << needed / 1024 / 1024 << " Mb needed");
+    cluster_in_memory(data, uf);
+  } else {
+    INFO("Not enough memory for in-memory clustering (" << needed / 1024 / 1024 << " Mb needed, "
+         << available / 1024 / 1024 << " Mb available), clustering on disk");
+    cluster_on_disk(prefix, data, uf);
+  }
+}
+
+// Same passes as cluster_on_disk(): blocks of k-mers sharing a sub-k-mer are
+// processed in parallel, big blocks are split again by the strided sub-k-mers
+// once all the small blocks are done.
+void KMerHamClusterer::cluster_in_memory(const KMerData &data,
+                                         dsu::ConcurrentDSU &uf) {
+  size_t sz = data.size();
+  std::vector<hammer::KMer> kmers(sz);
+# pragma omp parallel for
+  for (size_t i = 0; i < sz; ++i)
+    kmers[i] = data.kmer(i);
+
+  std::vector<size_t> big_blocks, big_starts;
+  {
+    std::vector<SubKMer> subkmers;
+    std::vector<size_t> idx(sz), starts;
+    for (unsigned i = 0; i < tau_ + 1; ++i) {
+      size_t from = (*Globals::subKMerPositions)[i];
+      size_t to = (*Globals::subKMerPositions)[i+1];
+
+      INFO("Splitting sub-kmers: [" << from << ", " << to << ")");
+      for (size_t j = 0; j < sz; ++j)
+        idx[j] = j;
+      splitProjections(kmers, subkmers, idx.data(), sz,
+                       SubKMerPartSerializer(from, to), starts, -1);
+
+      size_t nblocks = starts.size() - 1;
+#     pragma omp parallel
+      {
+        std::vector<KMerWord> packed;
+        std::vector<unsigned> dist;
+#       pragma omp for schedule(dynamic, 1024)
+        for (size_t b = 0; b < nblocks; ++b) {
+          size_t block_size = starts[b + 1] - starts[b];
+          if (block_size < block_thr_)
+            processBlockPacked(uf, idx.data() + starts[b], block_size, kmers, tau_, packed, dist);
+        }
+      }
+
+      for (size_t b = 0; b < nblocks; ++b) {
+        if (starts[b + 1] - starts[b] < block_thr_)
+          continue;
+        big_starts.push_back(big_blocks.size());
+        big_blocks.insert(big_blocks.end(), idx.begin() + starts[b], idx.begin() + starts[b + 1]);
+      }
+    }
+    big_starts.push_back(big_blocks.size());
+  }
+  INFO("Merge done, total " << (big_starts.size() - 1) * (tau_ + 1) << " new blocks generated.");
+
+  size_t nbig = big_starts.size() - 1, big_blocks2 = 0;
+# pragma omp parallel reduction(+:big_blocks2)
+  {
+    std::vector<SubKMer> subkmers;
+    std::vector<size_t> idx, starts;
+    std::vector<KMerWord> packed;
+    std::vector<unsigned> dist;
+#   pragma omp for schedule(dynamic)
+    for (size_t b = 0; b < nbig; ++b) {
+      for (unsigned i = 0; i < tau_ + 1; ++i) {
+        idx.assign(big_blocks.begin() + big_starts[b], big_blocks.begin() + big_starts[b + 1]);
+        splitProjections(kmers, subkmers, idx.data(), idx.size(),
+                         SubKMerStridedSerializer(i, tau_ + 1), starts, 1);
+        for (size_t s = 0; s + 1 < starts.size(); ++s) {
+          size_t block_size = starts[s + 1] - starts[s];
+          big_blocks2 += (block_size > 50);
+          processBlockPacked(uf, idx.data() + starts[s], block_size, kmers, tau_, packed, dist);
+        }
+      }
+    }
+  }
+
+  INFO("Merge done, saw " << big_blocks2 << " big blocks.");
+}
+
 enum {
   UNLOCKED = 0,
   PARTIALLY_LOCKED = 1,
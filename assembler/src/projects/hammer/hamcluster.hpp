@@ -139,12 +139,23 @@ class SubKMerSplitter {
 
 class KMerHamClusterer {
   unsigned tau_;
+  unsigned block_thr_;
 
  public:
-  KMerHamClusterer(unsigned tau)
-      : tau_(tau) {}
+  KMerHamClusterer(unsigned tau, unsigned block_thr)
+      : tau_(tau), block_thr_(block_thr) {}
 
+  /// cluster in memory if the sub-k-mer projections fit, on disk otherwise
   void cluster(const std::string &prefix, const KMerData &data, dsu::ConcurrentDSU &uf);
+
+  /// sub-k-mer blocks are sorted in files with the given prefix
+  void cluster_on_disk(const std::string &prefix, const KMerData &data, dsu::ConcurrentDSU &uf);
+  /// sub-k-mer blocks are radix-sorted in memory and processed in parallel
+  void cluster_in_memory(const KMerData &data, dsu::ConcurrentDSU &uf);
+
+  /// approximate memory needed by cluster_in_memory()
+  size_t in_memory_footprint(size_t kmers) const;
+
  private:
   DECL_LOGGER("Hamming Clustering");
 };
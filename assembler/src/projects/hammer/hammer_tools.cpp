@@ -11,6 +11,8 @@
 #include "globals.hpp"
 #include "kmer_data.hpp"
 #include "read_corrector.hpp"
+#include "read_cache.hpp"
+#include "read_output.hpp"
 
 #include "io/reads/ireadstream.hpp"
 #include "io/kmers/mmapped_writer.hpp"
@@ -19,6 +21,11 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 #include "config_struct_hammer.hpp"
 
@@ -78,8 +85,7 @@ string getFilename( const string & dirprefix, int iter_count, const string & suf
 
 CorrectionStats CorrectReadsBatch(std::vector<bool> &res,
                        std::vector<Read> &reads, size_t buf_size,
-                       const KMerData &data) {
-  unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
+                       const KMerData &data, unsigned correct_nthreads) {
   bool discard_singletons = cfg::get().bayes_discard_only_singletons;
   bool correct_threshold = cfg::get().correct_use_threshold;
   bool discard_bad = cfg::get().correct_discard_bad;
@@ -104,94 +110,220 @@ CorrectionStats CorrectReadsBatch(std::vector<bool> &res,
   return stats;
 }
 
-CorrectionStats CorrectReadFile(const KMerData &data,
-                     const std::string &fname,
-                     std::ofstream *outf_good, std::ofstream *outf_bad) {
-  int qvoffset = cfg::get().input_qvoffset;
-  int trim_quality = cfg::get().input_trim_quality;
+namespace {
+
+/// Queue of the fixed capacity between the pipeline stages, push blocks
+/// while the queue is full, pop blocks while it is empty and not closed
+template<class T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(capacity), closed_(false) {}
+
+  void push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [&]{ return items_.size() < capacity_; });
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+  }
 
-  unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
-  size_t read_buffer_size = correct_nthreads * cfg::get().correct_readbuffer;
-  std::vector<Read> reads(read_buffer_size);
-  std::vector<bool> res(read_buffer_size, false);
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [&]{ return !items_.empty() || closed_; });
+    if (items_.empty())
+      return false;
+    item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
 
-  ireadstream irs(fname, qvoffset);
-  VERIFY(irs.is_open());
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+  }
 
-  unsigned buffer_no = 0;
-  CorrectionStats stats;
-  while (!irs.eof()) {
-    size_t buf_size = 0;
-    for (; buf_size < read_buffer_size && !irs.eof(); ++buf_size) {
-      irs >> reads[buf_size];
-      reads[buf_size].trimNsAndBadQuality(trim_quality);
-    }
-    INFO("Prepared batch " << buffer_no << " of " << buf_size << " reads.");
+ private:
+  size_t capacity_;
+  bool closed_;
+  std::deque<T> items_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_, not_full_;
+};
 
-    stats += CorrectReadsBatch(res, reads, buf_size,
-                               data);
+struct ReadBatch {
+  std::vector<Read> reads[2];
+  std::vector<bool> res[2];
+  size_t size;
+  unsigned no;
+};
 
-    INFO("Processed batch " << buffer_no);
-    for (size_t i = 0; i < buf_size; ++i) {
-      reads[i].print(*(res[i] ? outf_good : outf_bad), qvoffset);
+/// Runs reader -> corrector -> writer pipeline over the read batches. Reader
+/// and writer have their own threads, correction is done in the current one.
+/// Three batches circulate, so while one of them is being corrected, the next
+/// one is read and the previous one is written.
+template<class Reader, class Writer>
+CorrectionStats CorrectPipelined(unsigned sides, const KMerData &data,
+                                 Reader read, Writer write) {
+  unsigned nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
+  // Same memory as 1.5 batches of the sequential version
+  size_t read_buffer_size = std::max(nthreads * cfg::get().correct_readbuffer / 2, 1u);
+  // Writer works concurrently with the correction, so the threads are split
+  // between them. Plain text output needs just one.
+  unsigned write_nthreads = cfg::get().output_gzip ? std::max(nthreads / 4, 1u) : 1;
+  unsigned correct_nthreads = std::max(nthreads - write_nthreads, 1u);
+
+  const size_t BATCHES = 3;
+  std::vector<ReadBatch> batches(BATCHES);
+  BoundedQueue<ReadBatch*> spare(BATCHES), prepared(1), corrected(1);
+  for (auto &batch : batches) {
+    for (unsigned side = 0; side < sides; ++side) {
+      batch.reads[side].resize(read_buffer_size);
+      batch.res[side].resize(read_buffer_size, false);
     }
-    INFO("Written batch " << buffer_no);
-    ++buffer_no;
+    spare.push(&batch);
   }
+
+  std::thread reader([&] {
+    ReadBatch *batch;
+    for (unsigned buffer_no = 0; spare.pop(batch); ++buffer_no) {
+      batch->no = buffer_no;
+      batch->size = read(*batch, read_buffer_size);
+      if (!batch->size)
+        break;
+      INFO("Prepared batch " << buffer_no << " of " << batch->size << " reads.");
+      prepared.push(batch);
+    }
+    prepared.close();
+  });
+
+  std::thread writer([&] {
+    ReadBatch *batch;
+    while (corrected.pop(batch)) {
+      write(*batch, write_nthreads);
+      INFO("Written batch " << batch->no);
+      spare.push(batch);
+    }
+  });
+
+  CorrectionStats stats;
+  ReadBatch *batch;
+  while (prepared.pop(batch)) {
+    for (unsigned side = 0; side < sides; ++side)
+      stats += CorrectReadsBatch(batch->res[side], batch->reads[side], batch->size, data, correct_nthreads);
+    INFO("Processed batch " << batch->no);
+    corrected.push(batch);
+  }
+  corrected.close();
+
+  // The reader might be waiting for a batch to fill after the last one
+  spare.close();
+  reader.join();
+  writer.join();
+
   return stats;
 }
 
-CorrectionStats CorrectPairedReadFiles(const KMerData &data,
-                            const std::string &fnamel, const std::string &fnamer,
-                            ofstream * ofbadl, ofstream * ofcorl, ofstream * ofbadr, ofstream * ofcorr, ofstream * ofunp) {
+/// Prints the reads of the batch to the outputs chosen by route(i, side) and
+/// writes them in the original order. Formatting and compression are done in
+/// parallel by pieces of the batch.
+template<class Route>
+void WriteBatch(const ReadBatch &batch, unsigned sides,
+                const std::vector<ReadOutput*> &outputs, Route route, unsigned nthreads) {
+  int qvoffset = cfg::get().input_qvoffset;
+
+  size_t pieces = 4 * nthreads;
+  size_t piece_size = (batch.size + pieces - 1) / pieces;
+  std::vector<std::vector<std::string>> packed(pieces, std::vector<std::string>(outputs.size()));
+# pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+  for (size_t piece = 0; piece < pieces; ++piece) {
+    std::vector<std::ostringstream> text(outputs.size());
+    for (size_t i = piece * piece_size; i < std::min(batch.size, (piece + 1) * piece_size); ++i)
+      for (unsigned side = 0; side < sides; ++side)
+        batch.reads[side][i].print(text[route(i, side)], qvoffset);
+
+    for (size_t out = 0; out < outputs.size(); ++out)
+      packed[piece][out] = outputs[out]->Pack(text[out].str());
+  }
+
+  for (const auto &piece : packed)
+    for (size_t out = 0; out < outputs.size(); ++out)
+      outputs[out]->Write(piece[out]);
+}
+
+}
+
+CorrectionStats CorrectReadFile(const KMerData &data,
+                     const std::string &fname,
+                     ReadOutput *outf_good, ReadOutput *outf_bad) {
   int qvoffset = cfg::get().input_qvoffset;
   int trim_quality = cfg::get().input_trim_quality;
 
-  unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
-  size_t read_buffer_size = correct_nthreads * cfg::get().correct_readbuffer;
-  std::vector<Read> l(read_buffer_size);
-  std::vector<Read> r(read_buffer_size);
-  std::vector<bool> left_res(read_buffer_size, false);
-  std::vector<bool> right_res(read_buffer_size, false);
+  ReadCacheStream irs(fname, qvoffset);
+  VERIFY(irs.is_open());
+
+  std::vector<ReadOutput*> outputs = { outf_good, outf_bad };
+  return CorrectPipelined(1, data,
+                          [&](ReadBatch &batch, size_t read_buffer_size) {
+                            size_t buf_size = 0;
+                            for (; buf_size < read_buffer_size && !irs.eof(); ++buf_size) {
+                              irs >> batch.reads[0][buf_size];
+                              batch.reads[0][buf_size].trimNsAndBadQuality(trim_quality);
+                            }
+                            return buf_size;
+                          },
+                          [&](const ReadBatch &batch, unsigned nthreads) {
+                            WriteBatch(batch, 1, outputs,
+                                       [&](size_t i, unsigned) { return batch.res[0][i] ? 0 : 1; },
+                                       nthreads);
+                          });
+}
 
-  unsigned buffer_no = 0;
+CorrectionStats CorrectPairedReadFiles(const KMerData &data,
+                            const std::string &fnamel, const std::string &fnamer,
+                            ReadOutput *ofbadl, ReadOutput *ofcorl, ReadOutput *ofbadr, ReadOutput *ofcorr, ReadOutput *ofunp) {
+  int qvoffset = cfg::get().input_qvoffset;
+  int trim_quality = cfg::get().input_trim_quality;
 
-  ireadstream irsl(fnamel, qvoffset), irsr(fnamer, qvoffset);
+  ReadCacheStream irsl(fnamel, qvoffset), irsr(fnamer, qvoffset);
   VERIFY(irsl.is_open()); VERIFY(irsr.is_open());
-  CorrectionStats stats;
 
-  while (!irsl.eof() && !irsr.eof()) {
-    size_t buf_size = 0;
-    for (; buf_size < read_buffer_size && !irsl.eof() && !irsr.eof(); ++buf_size) {
-      irsl >> l[buf_size]; irsr >> r[buf_size];
-      l[buf_size].trimNsAndBadQuality(trim_quality);
-      r[buf_size].trimNsAndBadQuality(trim_quality);
-    }
-    INFO("Prepared batch " << buffer_no << " of " << buf_size << " reads.");
-
-    stats += CorrectReadsBatch(left_res, l, buf_size,
-                      data);
-    stats += CorrectReadsBatch(right_res, r, buf_size,
-                      data);
-
-    INFO("Processed batch " << buffer_no);
-    for (size_t i = 0; i < buf_size; ++i) {
-      if (left_res[i] && right_res[i]) {
-        l[i].print(*ofcorl, qvoffset);
-        r[i].print(*ofcorr, qvoffset);
-      } else {
-        l[i].print(*(left_res[i] ? ofunp : ofbadl), qvoffset);
-        r[i].print(*(right_res[i] ? ofunp : ofbadr), qvoffset);
-      }
-    }
-    INFO("Written batch " << buffer_no);
-    ++buffer_no;
-  }
+  enum { BADL, CORL, BADR, CORR, UNP };
+  std::vector<ReadOutput*> outputs = { ofbadl, ofcorl, ofbadr, ofcorr, ofunp };
+  CorrectionStats stats =
+      CorrectPipelined(2, data,
+                       [&](ReadBatch &batch, size_t read_buffer_size) {
+                         std::vector<Read> &l = batch.reads[0], &r = batch.reads[1];
+                         size_t buf_size = 0;
+                         for (; buf_size < read_buffer_size && !irsl.eof() && !irsr.eof(); ++buf_size) {
+                           irsl >> l[buf_size]; irsr >> r[buf_size];
+                           l[buf_size].trimNsAndBadQuality(trim_quality);
+                           r[buf_size].trimNsAndBadQuality(trim_quality);
+                         }
+                         return buf_size;
+                       },
+                       [&](const ReadBatch &batch, unsigned nthreads) {
+                         const std::vector<bool> &left_res = batch.res[0], &right_res = batch.res[1];
+                         WriteBatch(batch, 2, outputs,
+                                    [&](size_t i, unsigned side) {
+                                      if (left_res[i] && right_res[i])
+                                        return side ? CORR : CORL;
+                                      if (side)
+                                        return right_res[i] ? UNP : BADR;
+                                      return left_res[i] ? UNP : BADL;
+                                    },
+                                    nthreads);
+                       });
   if (!irsl.eof() || !irsr.eof())
       FATAL_ERROR("Pair of read files " + fnamel + " and " + fnamer + " contain unequal amount of reads");
   return stats;
 }
 
+static std::string CorrectedSuffix() {
+  return cfg::get().output_gzip ? ".cor.fastq.gz" : ".cor.fastq";
+}
+
 std::string getLargestPrefix(const std::string &str1, const std::string &str2) {
   string substr = "";
   for (size_t i = 0; i != str1.size() && i != str2.size(); ++i) {
@@ -205,12 +337,11 @@ std::string getLargestPrefix(const std::string &str1, const std::string &str2) {
 
 std::string CorrectSingleReadSet(size_t ilib, size_t iread, const std::string &fn, CorrectionStats &stats) {
   std::string usuffix = std::to_string(ilib) + "_" +
-                        std::to_string(iread) + ".cor.fastq";
+                        std::to_string(iread) + CorrectedSuffix();
 
   std::string outcor = getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, usuffix);
-  std::ofstream ofgood(outcor.c_str());
-  std::ofstream ofbad(getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, "bad.fastq").c_str(),
-                      std::ios::out | std::ios::ate);
+  ReadOutput ofgood(outcor, cfg::get().output_gzip);
+  ReadOutput ofbad(getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, "bad.fastq"), false);
   stats += CorrectReadFile(*Globals::kmer_data, fn, &ofgood, &ofbad);
   return outcor;
 }
@@ -234,7 +365,7 @@ size_t CorrectAllReads() {
     for (auto I = lib.paired_begin(), E = lib.paired_end(); I != E; ++I, ++iread) {
       INFO("Correcting pair of reads: " << I->first << " and " << I->second);
       std::string usuffix =  std::to_string(ilib) + "_" +
-                             std::to_string(iread) + ".cor.fastq";
+                             std::to_string(iread) + CorrectedSuffix();
 
       std::string unpaired = getLargestPrefix(I->first, I->second) + "_unpaired.fastq";
 
@@ -242,13 +373,12 @@ size_t CorrectAllReads() {
       std::string outcorr = getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, usuffix);
       std::string outcoru = getReadsFilename(cfg::get().output_dir, unpaired,  Globals::iteration_no, usuffix);
 
-      std::ofstream ofcorl(outcorl.c_str());
-      std::ofstream ofbadl(getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, "bad.fastq").c_str(),
-                           std::ios::out | std::ios::ate);
-      std::ofstream ofcorr(outcorr.c_str());
-      std::ofstream ofbadr(getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, "bad.fastq").c_str(),
-                           std::ios::out | std::ios::ate);
-      std::ofstream ofunp (outcoru.c_str());
+      bool gzip = cfg::get().output_gzip;
+      ReadOutput ofcorl(outcorl, gzip);
+      ReadOutput ofbadl(getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, "bad.fastq"), false);
+      ReadOutput ofcorr(outcorr, gzip);
+      ReadOutput ofbadr(getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, "bad.fastq"), false);
+      ReadOutput ofunp (outcoru, gzip);
 
       stats += CorrectPairedReadFiles(*Globals::kmer_data,
                              I->first, I->second,
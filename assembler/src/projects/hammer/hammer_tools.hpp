@@ -19,6 +19,7 @@
 #include "globals.hpp"
 #include "kmer_stat.hpp"
 #include "io/kmers/mmapped_reader.hpp"
+#include "read_output.hpp"
 
 namespace hammer {
 
@@ -46,20 +47,19 @@ struct CorrectionStats {
 
 /// parallel correction of batch of reads
 CorrectionStats CorrectReadsBatch(std::vector<bool> &res, std::vector<Read> &reads, size_t buf_size,
-                       size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
-                       const KMerData &data);
+                       const KMerData &data, unsigned correct_nthreads);
 
 /// correct reads in a given file
 CorrectionStats CorrectReadFile(const KMerData &data,
                          size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
                          const std::string &fname,
-                         std::ofstream *outf_good, std::ofstream *outf_bad);
+                         ReadOutput *outf_good, ReadOutput *outf_bad);
 
 /// correct reads in a given pair of files
 CorrectionStats CorrectPairedReadFiles(const KMerData &data,
                             size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
                             const std::string &fnamel, const std::string &fnamer,
-                            std::ofstream * ofbadl, std::ofstream * ofcorl, std::ofstream * ofbadr, std::ofstream * ofcorr, std::ofstream * ofunp);
+                            ReadOutput * ofbadl, ReadOutput * ofcorl, ReadOutput * ofbadr, ReadOutput * ofcorr, ReadOutput * ofunp);
 /// correct all reads
 size_t CorrectAllReads();
 
@@ -8,12 +8,12 @@
 #include "kmer_data.hpp"
 #include "valid_kmer_generator.hpp"
 #include "config_struct_hammer.hpp"
+#include "read_cache.hpp"
 
 #include "adt/cqf.hpp"
 #include "adt/hll.hpp"
 
 #include "io/reads/read_processor.hpp"
-#include "io/reads/ireadstream.hpp"
 #include "io/kmers/kmer_iterator.hpp"
 
 #include "utils/kmer_mph/kmer_index_builder.hpp"
@@ -95,7 +95,7 @@ HammerFilteringKMerSplitter::RawKMers HammerFilteringKMerSplitter::Split(size_t
   BufferFiller filler(*this);
   for (const auto &reads : cfg::get().dataset.reads()) {
     INFO("Processing " << reads);
-    ireadstream irs(reads, cfg::get().input_qvoffset);
+    hammer::ReadCacheStream irs(reads, cfg::get().input_qvoffset);
     while (!irs.eof()) {
       hammer::ReadProcessor rp(nthreads);
       rp.Run(irs, filler);
@@ -286,7 +286,7 @@ void KMerDataCounter::BuildKMerIndex(KMerData &data) {
           KMerCountEstimator mcounter(omp_get_max_threads());
           for (const auto &reads : cfg::get().dataset.reads()) {
               INFO("Processing " << reads);
-              ireadstream irs(reads, cfg::get().input_qvoffset);
+              hammer::ReadCacheStream irs(reads, cfg::get().input_qvoffset);
               while (!irs.eof()) {
                   hammer::ReadProcessor rp(omp_get_max_threads());
                   rp.Run(irs, mcounter);
@@ -313,7 +313,7 @@ void KMerDataCounter::BuildKMerIndex(KMerData &data) {
       size_t n = 15, processed = 0;
       for (const auto &reads : cfg::get().dataset.reads()) {
           INFO("Processing " << reads);
-          ireadstream irs(reads, cfg::get().input_qvoffset);
+          hammer::ReadCacheStream irs(reads, cfg::get().input_qvoffset);
           while (!irs.eof()) {
               hammer::ReadProcessor rp(omp_get_max_threads());
               rp.Run(irs, mcounter);
@@ -375,7 +375,7 @@ void KMerDataCounter::FillKMerData(KMerData &data) {
   const auto& dataset = cfg::get().dataset;
   for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
     INFO("Processing " << *I);
-    ireadstream irs(*I, cfg::get().input_qvoffset);
+    hammer::ReadCacheStream irs(*I, cfg::get().input_qvoffset);
     hammer::ReadProcessor rp(omp_get_max_threads());
     rp.Run(irs, filler);
     VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
@@ -11,6 +11,7 @@
 #include "globals.hpp"
 #include "kmer_data.hpp"
 #include "expander.hpp"
+#include "read_cache.hpp"
 
 #include "adt/concurrent_dsu.hpp"
 #include "utils/segfault_handler.hpp"
@@ -18,6 +19,7 @@
 #include "io/reads/ireadstream.hpp"
 
 #include "utils/memory_limit.hpp"
+#include "utils/filesystem/path_helper.hpp"
 
 #include "utils/logger/logger.hpp"
 #include "utils/logger/log_writers.hpp"
@@ -35,18 +37,6 @@
 #include <cmath>
 #include <cstdlib>
 
-std::vector<uint32_t> * Globals::subKMerPositions = NULL;
-KMerData *Globals::kmer_data = NULL;
-int Globals::iteration_no = 0;
-
-char Globals::char_offset = 0;
-bool Globals::char_offset_user = true;
-
-double Globals::quality_probs[256] = { 0 };
-double Globals::quality_lprobs[256] = { 0 };
-double Globals::quality_rprobs[256] = { 0 };
-double Globals::quality_lrprobs[256] = { 0 };
-
 struct UfCmp {
   bool operator()(const std::vector<int> &lhs, const std::vector<int> &rhs) {
     return (lhs[0] < rhs[0]);
@@ -114,11 +104,23 @@ int main(int argc, char * argv[]) {
 
     int max_iterations = cfg::get().general_max_iterations;
 
+    // the read caches of the original inputs are reused by the later runs,
+    // the ones of the reads corrected by the iterations are removed
+    std::vector<std::string> original_reads;
+    for (const auto &reads : cfg::get().dataset.reads())
+      original_reads.push_back(reads);
+
     // now we can begin the iterations
     for (Globals::iteration_no = 0; Globals::iteration_no < max_iterations; ++Globals::iteration_no) {
       std::cout << "\n     === ITERATION " << Globals::iteration_no << " begins ===" << std::endl;
       bool do_everything = cfg::get().general_do_everything_after_first_iteration && (Globals::iteration_no > 0);
 
+      // all the passes over the reads below go through the binary read cache
+      std::vector<std::string> inputs;
+      for (const auto &reads : cfg::get().dataset.reads())
+        inputs.push_back(reads);
+      hammer::ReadCache::Prepare(inputs);
+
       // initialize k-mer structures
       Globals::kmer_data = new KMerData;
 
@@ -147,7 +149,8 @@ int main(int argc, char * argv[]) {
         std::string ham_prefix = hammer::getFilename(cfg::get().input_working_dir, Globals::iteration_no, "kmers.hamcls");
         INFO("Clustering Hamming graph.");
         if (cfg::get().general_tau > 1) {
-          KMerHamClusterer(cfg::get().general_tau).cluster(ham_prefix, *Globals::kmer_data, uf);
+          KMerHamClusterer(cfg::get().general_tau,
+                           cfg::get().hamming_blocksize_quadratic_threshold).cluster(ham_prefix, *Globals::kmer_data, uf);
         } else {
           TauOneKMerHamClusterer().cluster(ham_prefix, *Globals::kmer_data, uf);
         }
@@ -199,7 +202,7 @@ int main(int argc, char * argv[]) {
           Expander expander(*Globals::kmer_data);
           const io::DataSet<> &dataset = cfg::get().dataset;
           for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
-            ireadstream irs(*I, cfg::get().input_qvoffset);
+            hammer::ReadCacheStream irs(*I, cfg::get().input_qvoffset);
             hammer::ReadProcessor rp(expand_nthreads);
             rp.Run(irs, expander);
             VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
@@ -244,6 +247,11 @@ int main(int argc, char * argv[]) {
       // prepare the reads for next iteration
       delete Globals::kmer_data;
 
+      for (const auto &reads : inputs) {
+        if (std::find(original_reads.begin(), original_reads.end(), reads) == original_reads.end())
+          fs::remove_if_exists(hammer::ReadCache::Filename(reads));
+      }
+
       if (totalReads < 1) {
         INFO("Too few reads have changed in this iteration. Exiting.");
         break;
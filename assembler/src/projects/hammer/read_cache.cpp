@@ -0,0 +1,245 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "read_cache.hpp"
+
+#include "config_struct_hammer.hpp"
+
+#include "io/reads/ireadstream.hpp"
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hammer {
+
+namespace {
+
+const uint64_t MAGIC = 0x31484341435244ULL; // "DRCACH1"
+
+struct CacheHeader {
+  uint64_t magic;
+  uint64_t input_size;
+  int64_t input_mtime;
+  uint64_t reads;
+};
+
+struct RecordHeader {
+  uint32_t name_size;
+  uint32_t seq_size;
+  uint32_t qual_size;
+  uint32_t exceptions;
+};
+
+bool InputStat(const std::string &input, CacheHeader &header) {
+  struct stat st;
+  if (stat(input.c_str(), &st) != 0)
+    return false;
+
+  header.magic = MAGIC;
+  header.input_size = uint64_t(st.st_size);
+  header.input_mtime = int64_t(st.st_mtime);
+  header.reads = 0;
+  return true;
+}
+
+uint8_t PackedCode(char c) {
+  switch (c) {
+    case 'A': return 0;
+    case 'C': return 1;
+    case 'G': return 2;
+    case 'T': return 3;
+    default: return 4;
+  }
+}
+
+}
+
+std::string ReadCache::Filename(const std::string &input) {
+  return Filename(input, cfg::get().input_working_dir);
+}
+
+std::string ReadCache::Filename(const std::string &input, const std::string &dir) {
+  std::ostringstream tmp;
+  tmp << fs::basename(input) << '.' << std::hex << std::hash<std::string>()(input) << ".rcache";
+  return fs::append_path(dir, tmp.str());
+}
+
+bool ReadCache::Valid(const std::string &input, const std::string &cache) {
+  CacheHeader expected, header;
+  if (!InputStat(input, expected))
+    return false;
+
+  std::ifstream is(cache, std::ios::binary);
+  if (!is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    return false;
+
+  return header.magic == expected.magic &&
+         header.input_size == expected.input_size &&
+         header.input_mtime == expected.input_mtime;
+}
+
+void ReadCache::Build(const std::string &input, const std::string &cache) {
+  CacheHeader header;
+  bool stat_ok = InputStat(input, header);
+  CHECK_FATAL_ERROR(stat_ok, "Cannot stat " << input);
+
+  // The store is written under a temporary name, so an interrupted build
+  // never leaves a valid-looking store behind
+  std::string part = cache + ".part";
+  std::ofstream os(part, std::ios::binary);
+  CHECK_FATAL_ERROR(os, "Failed to open " << part);
+  CacheHeader unfinished = header;
+  unfinished.magic = 0;
+  os.write(reinterpret_cast<const char*>(&unfinished), sizeof(unfinished));
+
+  // Quality is stored as is
+  ireadstream irs(input, 0);
+  VERIFY(irs.is_open());
+  std::vector<uint8_t> packed;
+  std::vector<uint32_t> positions;
+  std::string chars;
+  while (!irs.eof()) {
+    Read r;
+    irs >> r;
+    const std::string &name = r.getName(), &seq = r.getSequenceString(), &qual = r.getQualityString();
+
+    packed.assign((seq.size() + 3) / 4, 0);
+    positions.clear();
+    chars.clear();
+    for (size_t i = 0; i < seq.size(); ++i) {
+      uint8_t code = PackedCode(seq[i]);
+      if (code > 3) {
+        positions.push_back(uint32_t(i));
+        chars.push_back(seq[i]);
+        code = 0;
+      }
+      packed[i / 4] = uint8_t(packed[i / 4] | (code << (2 * (i % 4))));
+    }
+
+    RecordHeader record = { uint32_t(name.size()), uint32_t(seq.size()), uint32_t(qual.size()),
+                            uint32_t(positions.size()) };
+    os.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    os.write(name.data(), std::streamsize(name.size()));
+    os.write(reinterpret_cast<const char*>(packed.data()), std::streamsize(packed.size()));
+    os.write(qual.data(), std::streamsize(qual.size()));
+    os.write(reinterpret_cast<const char*>(positions.data()), std::streamsize(positions.size() * sizeof(uint32_t)));
+    os.write(chars.data(), std::streamsize(chars.size()));
+    header.reads += 1;
+  }
+
+  os.seekp(0);
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  os.close();
+  CHECK_FATAL_ERROR(os, "Failed to write " << part);
+  CHECK_FATAL_ERROR(std::rename(part.c_str(), cache.c_str()) == 0, "Failed to rename " << part);
+}
+
+void ReadCache::Prepare(const std::vector<std::string> &inputs) {
+  Prepare(inputs, cfg::get().input_working_dir);
+}
+
+void ReadCache::Prepare(const std::vector<std::string> &inputs, const std::string &dir) {
+  std::vector<std::string> files(inputs);
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+
+# pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < files.size(); ++i) {
+    std::string cache = Filename(files[i], dir);
+    if (Valid(files[i], cache)) {
+      INFO("Reusing read cache for " << files[i]);
+      continue;
+    }
+
+    INFO("Caching reads of " << files[i]);
+    Build(files[i], cache);
+  }
+}
+
+ReadCacheStream::ReadCacheStream(const std::string &input, int offset)
+    : ReadCacheStream(input, offset, cfg::get().input_working_dir) {}
+
+ReadCacheStream::ReadCacheStream(const std::string &input, int offset, const std::string &dir)
+    : filename_(ReadCache::Filename(input, dir)), offset_(offset) {
+  VERIFY_MSG(ReadCache::Valid(input, filename_), "Read cache for " << input << " is missing or outdated");
+
+  int fd = ::open(filename_.c_str(), O_RDONLY);
+  CHECK_FATAL_ERROR(fd != -1, "open(2) failed. Reason: " << strerror(errno) << ". File: " << filename_);
+  struct stat st;
+  CHECK_FATAL_ERROR(fstat(fd, &st) == 0, "fstat(2) failed. Reason: " << strerror(errno) << ". File: " << filename_);
+  size_ = size_t(st.st_size);
+  void *data = mmap(NULL, size_, PROT_READ, MAP_FILE | MAP_PRIVATE, fd, 0);
+  CHECK_FATAL_ERROR(data != MAP_FAILED, "mmap(2) failed. Reason: " << strerror(errno) << ". File: " << filename_);
+  ::close(fd);
+  madvise(data, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(data);
+
+  reset();
+}
+
+ReadCacheStream::~ReadCacheStream() {
+  munmap(const_cast<char*>(data_), size_);
+}
+
+void ReadCacheStream::read(void *buf, size_t amount) {
+  VERIFY(pos_ + amount <= size_);
+  memcpy(buf, data_ + pos_, amount);
+  pos_ += amount;
+}
+
+void ReadCacheStream::reset() {
+  CacheHeader header;
+  pos_ = 0;
+  read(&header, sizeof(header));
+  VERIFY(header.magic == MAGIC);
+  reads_ = header.reads;
+  read_ = 0;
+}
+
+ReadCacheStream &ReadCacheStream::operator>>(Read &r) {
+  VERIFY(!eof());
+  RecordHeader record;
+  read(&record, sizeof(record));
+
+  name_.resize(record.name_size);
+  read(&name_[0], name_.size());
+  packed_.resize((record.seq_size + 3) / 4);
+  read(packed_.data(), packed_.size());
+  qual_.resize(record.qual_size);
+  read(&qual_[0], qual_.size());
+  exceptions_.resize(record.exceptions);
+  read(exceptions_.data(), exceptions_.size() * sizeof(uint32_t));
+
+  seq_.resize(record.seq_size);
+  for (size_t i = 0; i < seq_.size(); ++i)
+    seq_[i] = nucl(char((packed_[i / 4] >> (2 * (i % 4))) & 3));
+  for (uint32_t pos : exceptions_)
+    read(&seq_[pos], 1);
+
+  r.setName(name_.c_str());
+  if (record.qual_size)
+    r.setQuality(qual_.c_str(), offset_);
+  r.setSequence(seq_.c_str());
+  read_ += 1;
+
+  return *this;
+}
+
+};
@@ -0,0 +1,79 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#ifndef HAMMER_READ_CACHE_HPP
+#define HAMMER_READ_CACHE_HPP
+
+#include "io/reads/read.hpp"
+
+#include <string>
+#include <vector>
+
+namespace hammer {
+
+/// Binary store of the reads of a single input file. Every read is kept as
+/// its name, nucleotides packed 2 bits per base, raw (offset-less) quality
+/// and the list of non-ACGT positions with their original characters. The
+/// store remembers the size and mtime of the input and is rebuilt only when
+/// the input changes.
+class ReadCache {
+ public:
+  /// file name of the store of the input file in the working dir
+  static std::string Filename(const std::string &input);
+  static std::string Filename(const std::string &input, const std::string &dir);
+
+  /// whether the store is complete and matches the input file
+  static bool Valid(const std::string &input, const std::string &cache);
+
+  /// convert the input file into the store
+  static void Build(const std::string &input, const std::string &cache);
+
+  /// build (in parallel) the missing or outdated stores for all the files
+  static void Prepare(const std::vector<std::string> &inputs);
+  static void Prepare(const std::vector<std::string> &inputs, const std::string &dir);
+};
+
+/// Reads the memory-mapped store of the input file prepared by
+/// ReadCache::Prepare(). Drop-in replacement of ireadstream: yields the same
+/// reads with the same offset applied to the quality.
+class ReadCacheStream {
+  ReadCacheStream(const ReadCacheStream&) = delete;
+  ReadCacheStream &operator=(const ReadCacheStream&) = delete;
+
+ public:
+  typedef Read ReadT;
+
+  ReadCacheStream(const std::string &input, int offset);
+  ReadCacheStream(const std::string &input, int offset, const std::string &dir);
+  ~ReadCacheStream();
+
+  bool is_open() const { return true; }
+  bool eof() const { return read_ == reads_; }
+
+  ReadCacheStream &operator>>(Read &r);
+
+  void reset();
+  void close() {}
+
+ private:
+  void read(void *buf, size_t amount);
+
+  std::string filename_;
+  int offset_;
+  const char *data_;
+  size_t size_;
+  size_t pos_;
+  uint64_t reads_;
+  uint64_t read_;
+
+  std::string name_, seq_, qual_;
+  std::vector<uint8_t> packed_;
+  std::vector<uint32_t> exceptions_;
+};
+
+};
+
+#endif
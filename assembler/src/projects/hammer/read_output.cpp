@@ -0,0 +1,101 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "read_output.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <zlib.h>
+
+namespace hammer {
+
+namespace {
+
+// Same level as the one used to compress the corrected reads afterwards
+const int LEVEL = 7;
+
+const size_t HEADER_SIZE = 18, FOOTER_SIZE = 8;
+const size_t MAX_BLOCK_SIZE = 0x10000;
+// Even incompressible input of this size fits into a block
+const size_t MAX_INPUT_SIZE = 0xff00;
+
+// Empty block marking the end of BGZF file
+const char EOF_BLOCK[] = "\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x06\x00\x42\x43\x02\x00"
+                         "\x1b\x00\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00";
+
+void PutLE(char *dst, uint32_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i)
+    dst[i] = char((value >> (8 * i)) & 0xFF);
+}
+
+void AppendBlock(z_stream &zs, std::string &out, const char *data, size_t size) {
+  size_t start = out.size();
+  out.resize(start + MAX_BLOCK_SIZE);
+  char *block = &out[start];
+
+  int res = deflateReset(&zs);
+  CHECK_FATAL_ERROR(res == Z_OK, "deflateReset failed: " << res);
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  zs.avail_in = uInt(size);
+  zs.next_out = reinterpret_cast<Bytef*>(block + HEADER_SIZE);
+  zs.avail_out = uInt(MAX_BLOCK_SIZE - HEADER_SIZE - FOOTER_SIZE);
+  res = deflate(&zs, Z_FINISH);
+  CHECK_FATAL_ERROR(res == Z_STREAM_END, "deflate failed: " << res);
+  size_t block_size = HEADER_SIZE + zs.total_out + FOOTER_SIZE;
+
+  // gzip header with the "BC" extra field holding the block size
+  const char header[] = "\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x06\x00\x42\x43\x02\x00";
+  memcpy(block, header, HEADER_SIZE - 2);
+  PutLE(block + HEADER_SIZE - 2, uint32_t(block_size - 1), 2);
+
+  char *footer = block + block_size - FOOTER_SIZE;
+  PutLE(footer, uint32_t(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data), uInt(size))), 4);
+  PutLE(footer + 4, uint32_t(size), 4);
+
+  out.resize(start + block_size);
+}
+
+}
+
+ReadOutput::ReadOutput(const std::string &filename, bool compress)
+    : filename_(filename), compress_(compress), os_(filename, std::ios::out | std::ios::binary) {
+  CHECK_FATAL_ERROR(os_, "Failed to open " << filename_);
+}
+
+ReadOutput::~ReadOutput() {
+  if (compress_)
+    os_.write(EOF_BLOCK, sizeof(EOF_BLOCK) - 1);
+  os_.close();
+  CHECK_FATAL_ERROR(os_, "Failed to write " << filename_);
+}
+
+std::string ReadOutput::Pack(const std::string &text) const {
+  if (!compress_)
+    return text;
+
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  int res = deflateInit2(&zs, LEVEL, Z_DEFLATED, -15 /* raw deflate */, 8, Z_DEFAULT_STRATEGY);
+  CHECK_FATAL_ERROR(res == Z_OK, "deflateInit2 failed: " << res);
+
+  std::string packed;
+  packed.reserve(text.size() / 2);
+  for (size_t pos = 0; pos < text.size(); pos += MAX_INPUT_SIZE)
+    AppendBlock(zs, packed, text.data() + pos, std::min(MAX_INPUT_SIZE, text.size() - pos));
+
+  deflateEnd(&zs);
+  return packed;
+}
+
+void ReadOutput::Write(const std::string &packed) {
+  os_.write(packed.data(), std::streamsize(packed.size()));
+}
+
+};
@@ -0,0 +1,42 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#ifndef HAMMER_READ_OUTPUT_HPP
+#define HAMMER_READ_OUTPUT_HPP
+
+#include <fstream>
+#include <string>
+
+namespace hammer {
+
+/// Output file of corrected reads. Compressed output is a series of
+/// independent gzip members in BGZF format (at most 64K each), so separate
+/// pieces of text can be packed concurrently and then simply concatenated.
+class ReadOutput {
+  ReadOutput(const ReadOutput&) = delete;
+  ReadOutput &operator=(const ReadOutput&) = delete;
+
+ public:
+  ReadOutput(const std::string &filename, bool compress);
+  ~ReadOutput();
+
+  bool compressed() const { return compress_; }
+
+  /// converts the text into the bytes to be written, thread-safe
+  std::string Pack(const std::string &text) const;
+
+  /// appends the packed text to the file
+  void Write(const std::string &packed);
+
+ private:
+  std::string filename_;
+  bool compress_;
+  std::ofstream os_;
+};
+
+};
+
+#endif
@@ -64,7 +64,7 @@ class DebruijnEnvironment : public Environment {
         }
 
         inline bool IsCorrect() const {
-            if (!CheckFileExists(path_ + ".grseq"))
+            if (!fs::is_regular_file(path_ + ".grsnap") && !CheckFileExists(path_ + ".grseq"))
                 return false;
 
             size_t K = gp_.k();
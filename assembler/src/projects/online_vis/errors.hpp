@@ -80,7 +80,7 @@ namespace online_visualization {
   }
 
   bool CheckEnvIsCorrect(string path, size_t K) {
-    if (!CheckFileExists(path + ".grseq"))
+    if (!fs::is_regular_file(path + ".grsnap") && !CheckFileExists(path + ".grseq"))
       return false;
 
     if (!(K >= runtime_k::MIN_K && cfg::get().K < runtime_k::MAX_K)) {
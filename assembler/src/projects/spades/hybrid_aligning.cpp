@@ -307,6 +307,7 @@ void PacbioAlignLibrary(const Graph &graph,
 
     INFO("For library of " << lib_for_info);
     aligner.stats().Report();
+    galigner.ReportStats();
     INFO("Aligning of " << lib_for_info <<" finished");
 }
 
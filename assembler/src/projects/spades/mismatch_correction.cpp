@@ -251,8 +251,10 @@ public:
     }
 
     void StartProcessLibrary(size_t threads_count) override {
+        // Buffers start empty: every merge adds a buffer into statistics_, so
+        // seeding them with statistics_ would count earlier libraries again
         statistics_buffers_.clear();
-        statistics_buffers_.resize(threads_count, statistics_);
+        statistics_buffers_.resize(threads_count);
     }
 
     void StopProcessLibrary() override {
@@ -12,6 +12,7 @@
 #include "paired_info/pair_info_filler.hpp"
 
 #include "modules/alignment/long_read_mapper.hpp"
+#include "modules/alignment/mapping_path_cache.hpp"
 #include "modules/alignment/bwa_sequence_mapper.hpp"
 #include "modules/alignment/rna/ss_coverage_filler.hpp"
 
@@ -28,7 +29,14 @@ namespace debruijn_graph {
 namespace {
 
 using SequencingLib = io::SequencingLibrary<config::LibraryData>;
-using PairedInfoFilter = bf::counting_bloom_filter<std::pair<EdgeId, EdgeId>, 2>;
+struct EdgePairHasher {
+    uint64_t operator()(const std::pair<EdgeId, EdgeId> &e) const {
+        uint64_t h1 = e.first.hash();
+        return XXH3_64bits_withSeed(&h1, sizeof(h1), e.second.hash());
+    }
+};
+
+using PairedInfoFilter = bf::blocked_counting_bloom_filter<std::pair<EdgeId, EdgeId>, EdgePairHasher>;
 using EdgePairCounter = hll::hll_with_hasher<std::pair<EdgeId, EdgeId>>;
 
 std::shared_ptr<SequenceMapper<Graph>> ChooseProperMapper(const GraphPack& gp,
@@ -84,18 +92,19 @@ class DEFilter : public SequenceMapperListener {
 };
 
 class EdgePairCounterFiller : public SequenceMapperListener {
-    static uint64_t EdgePairHash(const std::pair<EdgeId, EdgeId> &e) {
-        uint64_t h1 = e.first.hash();
-
-        return XXH3_64bits_withSeed(&h1, sizeof(h1), e.second.hash());
+  public:
+    EdgePairCounterFiller()
+            : counter_(EdgePairHasher()) {}
+
+    void StartProcessLibrary(size_t threads_count) override {
+        buf_.clear();
+        buf_.reserve(threads_count);
+        for (size_t i = 0; i < threads_count; ++i)
+          buf_.emplace_back(EdgePairHasher());
     }
 
-  public:
-    EdgePairCounterFiller(size_t thread_num)
-            : counter_(EdgePairHash) {
-        buf_.reserve(thread_num);
-        for (unsigned i = 0; i < thread_num; ++i)
-          buf_.emplace_back(EdgePairHash);
+    void StopProcessLibrary() override {
+        buf_.clear();
     }
 
     void MergeBuffer(size_t i) override {
@@ -198,10 +207,11 @@ bool ShouldObtainSingleReadsPaths(size_t ilib) {
 
 bool CollectLibInformation(const GraphPack &gp,
                            size_t &edgepairs,
-                           size_t ilib, size_t edge_length_threshold) {
+                           size_t ilib, size_t edge_length_threshold,
+                           MappingPathCache &cache) {
     INFO("Estimating insert size (takes a while)");
     InsertSizeCounter hist_counter(gp.get<Graph>(), edge_length_threshold);
-    EdgePairCounterFiller pcounter(cfg::get().max_threads);
+    EdgePairCounterFiller pcounter;
 
     SequenceMapperNotifier notifier(gp, cfg::get_writable().ds.reads.lib_count());
     notifier.Subscribe(ilib, &hist_counter);
@@ -212,7 +222,7 @@ bool CollectLibInformation(const GraphPack &gp,
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, /*insert_size*/0,
                                                 /*include_merged*/true);
 
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads), cache);
     //Check read length after lib processing since mate pairs a not used until this step
     VERIFY(reads.data().unmerged_read_length != 0);
 
@@ -285,7 +295,7 @@ size_t ProcessSingleReads(GraphPack &gp, size_t ilib,
 void ProcessPairedReads(GraphPack &gp,
                                std::unique_ptr<PairedInfoFilter> filter,
                                unsigned filter_threshold,
-                               size_t ilib) {
+                               size_t ilib, MappingPathCache &cache) {
     SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
     const auto &data = reads.data();
 
@@ -320,7 +330,7 @@ void ProcessPairedReads(GraphPack &gp,
 
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
                                                 /*include merged*/true);
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads), cache);
 }
 
 } // namespace
@@ -352,8 +362,12 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
                 size_t rl = lib_data.unmerged_read_length;
                 size_t k = cfg::get().K;
 
+                // All the passes over paired reads below share the mapping
+                // results of the first one
+                MappingPathCache cache(fs::tmp::make_temp_dir(gp.workdir(), "mapping_cache"));
+
                 size_t edgepairs = 0;
-                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold)) {
+                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold, cache)) {
                     cfg::get_writable().ds.reads[i].data().mean_insert_size = 0.0;
                     WARN("Unable to estimate insert size for paired library #" << i);
                     if (rl > 0 && rl <= k) {
@@ -381,11 +395,7 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
 
                 // Only filter paired-end libraries
                 if (filter_threshold && lib.type() == io::LibraryType::PairedEnd) {
-                    filter.reset(new PairedInfoFilter([](const std::pair<EdgeId, EdgeId> &e, uint64_t seed) {
-                                uint64_t h1 = e.first.hash();
-                                return XXH3_64bits_withSeed(&h1, sizeof(h1), (e.second.hash() * seed) ^ seed);
-                            },
-                            12 * edgepairs));
+                    filter.reset(new PairedInfoFilter(12 * edgepairs));
 
                     INFO("Filtering data for library #" << i);
                     {
@@ -395,14 +405,14 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
 
                         VERIFY(lib.data().unmerged_read_length != 0);
                         auto reads = paired_binary_readers(lib, /*followed by rc*/false, 0, /*include merged*/true);
-                        notifier.ProcessLibrary(reads, i, *ChooseProperMapper(gp, lib));
+                        notifier.ProcessLibrary(reads, i, *ChooseProperMapper(gp, lib), cache);
                     }
                 }
 
                 INFO("Mapping library #" << i);
                 if (lib.data().mean_insert_size != 0.0) {
                     INFO("Mapping paired reads (takes a while) ");
-                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i);
+                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i, cache);
                 }
             }
 
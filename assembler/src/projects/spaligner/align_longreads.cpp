@@ -127,6 +127,7 @@ class LongReadsAligner {
             n += read_buffer.size();
             INFO("Processed " << n << " reads");
         }
+        galigner_.ReportStats();
     }
 
   private:
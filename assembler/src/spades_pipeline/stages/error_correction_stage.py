@@ -40,6 +40,11 @@ class ECRunningToolStage(stage.Stage):
             subst_dict["count_filter_singletons"] = cfg.count_filter_singletons
         if "read_buffer_size" in cfg.__dict__:
             subst_dict["count_split_buffer"] = cfg.read_buffer_size
+        # BayesHammer compresses the corrected reads itself
+        if "output_gzip" not in process_cfg.vars_from_lines(process_cfg.file_lines(filename)):
+            with open(filename, "a") as f:
+                f.write("output_gzip false\n")
+        subst_dict["output_gzip"] = process_cfg.bool_to_str(cfg.gzip_output)
         process_cfg.substitute_params(filename, subst_dict, log)
 
     def prepare_config_ih(self, filename, cfg, ext_python_modules_home):
@@ -106,7 +111,8 @@ class ErrorCorrectionCompressingStage(stage.Stage):
                 "--output_dir", cfg.output_dir]
         if cfg.not_used_dataset_yaml_filename != "":
             args += ["--not_used_yaml_file", cfg.not_used_dataset_yaml_filename]
-        if cfg.gzip_output:
+        # BayesHammer output is already compressed
+        if cfg.gzip_output and cfg.iontorrent:
             args.append("--gzip_output")
 
         command = [commands_parser.Command(STAGE="corrected reads compression",
@@ -0,0 +1,82 @@
+#include "adt/bf.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/logger/log_writers.hpp"
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+struct Hasher {
+    uint64_t operator()(uint64_t key) const {
+        return XXH3_64bits(&key, sizeof(key));
+    }
+};
+
+uint64_t SeededHash(const uint64_t &key, uint64_t seed) {
+    return XXH3_64bits_withSeed(&key, sizeof(key), seed);
+}
+
+const size_t N = 1000000;
+
+template<class Filter>
+double FalsePositiveRate(const Filter &filter) {
+    size_t fp = 0;
+    for (uint64_t i = N; i < 2 * N; ++i)
+        fp += filter.lookup(i) > 0;
+
+    return double(fp) / double(N);
+}
+
+}
+
+TEST(BloomFilterTest, BlockedCounting) {
+    bf::blocked_counting_bloom_filter<uint64_t, Hasher> filter(12 * N);
+    for (unsigned cnt = 1; cnt <= 20; ++cnt) {
+        filter.add(42);
+        EXPECT_GE(filter.lookup(42), std::min(cnt, 15u));
+    }
+    EXPECT_EQ(filter.lookup(42), 15);
+
+    filter.clear();
+    EXPECT_EQ(filter.lookup(42), 0);
+}
+
+TEST(BloomFilterTest, BlockedFalsePositiveRate) {
+    bf::counting_bloom_filter<uint64_t> filter(SeededHash, 12 * N);
+    bf::blocked_counting_bloom_filter<uint64_t, Hasher> blocked(12 * N);
+
+#   pragma omp parallel for
+    for (uint64_t i = 0; i < N; ++i) {
+        filter.add(i);
+        blocked.add(i);
+    }
+
+    for (uint64_t i = 0; i < N; ++i) {
+        ASSERT_GT(filter.lookup(i), 0);
+        ASSERT_GT(blocked.lookup(i), 0);
+    }
+
+    double fpr = FalsePositiveRate(filter), blocked_fpr = FalsePositiveRate(blocked);
+    INFO("False positive rate: " << fpr << ", blocked: " << blocked_fpr);
+    // Unevenly loaded blocks cost a bit of precision
+    EXPECT_LT(blocked_fpr, 1.5 * fpr);
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+  create_console_logger();
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
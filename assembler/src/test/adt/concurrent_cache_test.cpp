@@ -0,0 +1,114 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "adt/concurrent_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#include <cstdint>
+
+namespace {
+
+uint64_t Value(uint64_t key) {
+    return key * key + 1;
+}
+
+}
+
+TEST(ConcurrentCache, HitsAndMisses) {
+    adt::concurrent_cache<uint64_t, uint64_t> cache(1 << 16);
+    uint64_t value = 0;
+    EXPECT_FALSE(cache.find(1, value));
+
+    for (uint64_t key = 0; key < 100; ++key)
+        cache.insert(key, Value(key));
+    for (uint64_t key = 0; key < 100; ++key) {
+        ASSERT_TRUE(cache.find(key, value));
+        EXPECT_EQ(Value(key), value);
+    }
+    EXPECT_FALSE(cache.find(100, value));
+
+    // Insertion of the cached key updates the value
+    cache.insert(5, 42);
+    ASSERT_TRUE(cache.find(5, value));
+    EXPECT_EQ(42u, value);
+
+    auto stats = cache.stats();
+    EXPECT_EQ(100u, stats.size);
+    EXPECT_EQ(101u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(0u, stats.evictions);
+
+    cache.clear();
+    EXPECT_FALSE(cache.find(5, value));
+    EXPECT_EQ(0u, cache.stats().size);
+}
+
+TEST(ConcurrentCache, ClockEviction) {
+    adt::concurrent_cache<uint64_t, uint64_t> cache(4, 1);
+    for (uint64_t key = 1; key <= 4; ++key)
+        cache.insert(key, Value(key));
+
+    uint64_t value;
+    ASSERT_TRUE(cache.find(1, value));
+    ASSERT_TRUE(cache.find(3, value));
+
+    // Referenced entries get the second chance
+    cache.insert(5, Value(5));
+    EXPECT_FALSE(cache.find(2, value));
+    cache.insert(6, Value(6));
+    EXPECT_FALSE(cache.find(4, value));
+    // ...but only once
+    cache.insert(7, Value(7));
+    EXPECT_FALSE(cache.find(1, value));
+
+    for (uint64_t key : { 3, 5, 6, 7 }) {
+        ASSERT_TRUE(cache.find(key, value));
+        EXPECT_EQ(Value(key), value);
+    }
+
+    auto stats = cache.stats();
+    EXPECT_EQ(4u, stats.size);
+    EXPECT_EQ(3u, stats.evictions);
+    EXPECT_EQ(6u, stats.hits);
+    EXPECT_EQ(3u, stats.misses);
+}
+
+TEST(ConcurrentCache, ConcurrentAccess) {
+    const uint64_t N = 1000000, KEYS = 10000, CAPACITY = 2048;
+    // Smaller than the number of keys, so the entries are evicted concurrently
+    adt::concurrent_cache<uint64_t, uint64_t> cache(CAPACITY, 16);
+    std::atomic<size_t> computed{0}, wrong{0};
+
+#   pragma omp parallel for num_threads(8)
+    for (uint64_t i = 0; i < N; ++i) {
+        uint64_t key = (i * 7919) % KEYS, value;
+        if (i % 3) {
+            value = cache.get_or_compute(key, [&]() { computed += 1; return Value(key); });
+        } else if (!cache.find(key, value)) {
+            cache.insert(key, Value(key));
+            continue;
+        }
+
+        if (value != Value(key))
+            wrong += 1;
+    }
+
+    EXPECT_EQ(0u, wrong);
+    auto stats = cache.stats();
+    EXPECT_EQ(CAPACITY, stats.size);
+    EXPECT_EQ(N, stats.hits + stats.misses);
+    EXPECT_LT(0u, stats.evictions);
+    // Every computed value is the result of a miss
+    EXPECT_LE(computed, stats.misses);
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
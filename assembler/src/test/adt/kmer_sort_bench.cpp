@@ -0,0 +1,54 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "adt/kmer_radix_sort.hpp"
+#include "adt/kmer_vector.hpp"
+#include "sequence/rtseq.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <libcxx/sort.hpp>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <cstdlib>
+
+// Compares MSD radix sort of packed k-mers with comparison sort used in k-mer counting
+int main(int argc, char *argv[]) {
+    size_t n = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000);
+
+    std::mt19937_64 rng(42);
+    for (unsigned k : { 21, 33, 55, 77, 127 }) {
+        adt::KMerVector<RtSeq> kmers(k, n);
+        std::string s(k, 'A');
+        for (size_t i = 0; i < n; ++i) {
+            for (auto &c : s)
+                c = "ACGT"[rng() & 3];
+            kmers.push_back(RtSeq(k, s.c_str()));
+        }
+
+        adt::KMerVector<RtSeq> sorted(kmers);
+        utils::perf_counter pc;
+        libcxx::sort(sorted.begin(), sorted.end(), adt::KMerVector<RtSeq>::less2_fast());
+        double sort_time = pc.time();
+
+        adt::KMerVector<RtSeq> radix_sorted(kmers);
+        pc.reset();
+        adt::kmer_radix_sort(radix_sorted);
+        double radix_time = pc.time();
+
+        bool same = (memcmp(sorted.data(), radix_sorted.data(), n * sorted.el_data_size()) == 0);
+        std::cout << "K = " << k << ", " << n << " k-mers: "
+                  << "libcxx::sort " << sort_time << "s, "
+                  << "radix sort " << radix_time << "s, "
+                  << "speedup " << sort_time / radix_time
+                  << (same ? "" : " RESULTS DIFFER") << std::endl;
+        if (!same)
+            return 1;
+    }
+
+    return 0;
+}
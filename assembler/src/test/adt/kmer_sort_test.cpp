@@ -0,0 +1,78 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "adt/kmer_radix_sort.hpp"
+#include "adt/kmer_vector.hpp"
+#include "sequence/rtseq.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef adt::KMerVector<RtSeq> KMers;
+typedef std::vector<RtSeq::DataType> Record;
+
+// Reference order: records compared word by word, as array_less does
+std::vector<Record> StdSorted(const KMers &kmers) {
+    std::vector<Record> res;
+    for (size_t i = 0; i < kmers.size(); ++i)
+        res.emplace_back(kmers[i], kmers[i] + kmers.el_size());
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+void CheckSort(KMers kmers) {
+    auto expected = StdSorted(kmers);
+    adt::kmer_radix_sort(kmers);
+
+    ASSERT_EQ(expected.size(), kmers.size());
+    for (size_t i = 0; i < kmers.size(); ++i)
+        ASSERT_EQ(expected[i], Record(kmers[i], kmers[i] + kmers.el_size())) << "at " << i;
+}
+
+// K-mers made of the nucleotides drawn from the given alphabet
+KMers Random(unsigned k, size_t n, const std::string &alphabet, const std::string &prefix, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    KMers kmers(k, n);
+    std::string s = prefix;
+    s.resize(k);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = prefix.size(); j < k; ++j)
+            s[j] = alphabet[rng() % alphabet.size()];
+        kmers.push_back(RtSeq(k, s.c_str()));
+    }
+    return kmers;
+}
+
+}
+
+TEST(KMerRadixSort, Random) {
+    for (unsigned k : { 21, 33, 55, 77, 127 })
+        for (size_t n : { 0, 1, 2, 31, 32, 1000, 100000 })
+            CheckSort(Random(k, n, "ACGT", "", k + unsigned(n)));
+}
+
+TEST(KMerRadixSort, Skewed) {
+    for (unsigned k : { 21, 55, 127 }) {
+        // Long common prefix, the buckets are split only by the last bytes
+        CheckSort(Random(k, 50000, "ACGT", std::string(k - 5, 'G'), k));
+        // Few distinct k-mers, many duplicates
+        CheckSort(Random(k, 50000, "A", std::string(k - 3, 'C') + "T", k));
+        CheckSort(Random(k, 50000, "AT", std::string(k - 4, 'A'), k));
+        // Mostly one letter
+        CheckSort(Random(k, 50000, "AAAAAAAAAAAAAAAC", "", k));
+    }
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
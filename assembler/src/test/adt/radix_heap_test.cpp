@@ -0,0 +1,116 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "adt/radix_heap.hpp"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+namespace {
+
+// Reference order: the least key first, the greatest value among equal keys
+template<typename Key>
+struct ReferenceCompare {
+    bool operator()(const std::pair<Key, int> &a, const std::pair<Key, int> &b) const {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    }
+};
+
+// Pushes random keys not less than the last popped one, popping in between,
+// and compares the popped sequence with std::priority_queue
+template<typename Key>
+void CheckRandom(adt::radix_heap<Key, int> &heap, size_t n, Key max_step, unsigned seed) {
+    typedef std::pair<Key, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, ReferenceCompare<Key>> expected;
+    std::mt19937_64 rng(seed);
+    Key last = 0;
+    for (size_t i = 0; i < n; ++i) {
+        Key key = Key(last + rng() % (max_step + 1));
+        int value = int(rng() % 1000);
+        heap.push(key, value);
+        expected.emplace(key, value);
+        ASSERT_EQ(expected.size(), heap.size());
+
+        // Pop roughly every other element on the way
+        while (!expected.empty() && rng() % 2) {
+            ASSERT_EQ(expected.top().first, heap.top_key());
+            ASSERT_EQ(expected.top().second, heap.top());
+            last = expected.top().first;
+            expected.pop();
+            heap.pop();
+        }
+    }
+
+    while (!expected.empty()) {
+        ASSERT_FALSE(heap.empty());
+        ASSERT_EQ(expected.top().first, heap.top_key());
+        ASSERT_EQ(expected.top().second, heap.top());
+        expected.pop();
+        heap.pop();
+    }
+    EXPECT_TRUE(heap.empty());
+    EXPECT_EQ(0u, heap.size());
+}
+
+}
+
+TEST(RadixHeap, EqualKeys) {
+    adt::radix_heap<uint64_t, int> heap;
+    for (int value : { 3, 7, 1, 5 })
+        heap.push(10, value);
+    heap.push(12, 100);
+    heap.push(11, 0);
+
+    std::vector<std::pair<uint64_t, int>> popped;
+    while (!heap.empty()) {
+        popped.emplace_back(heap.top_key(), heap.top());
+        heap.pop();
+    }
+    std::vector<std::pair<uint64_t, int>> expected = { {10, 7}, {10, 5}, {10, 3}, {10, 1}, {11, 0}, {12, 100} };
+    EXPECT_EQ(expected, popped);
+}
+
+TEST(RadixHeap, Random) {
+    adt::radix_heap<uint64_t, int> heap, sparse_heap;
+    CheckRandom<uint64_t>(heap, 100000, 1000, 1);
+    CheckRandom<uint64_t>(sparse_heap, 1000, uint64_t(1) << 40, 2);
+}
+
+TEST(RadixHeap, Reuse) {
+    // Keys start from zero again after clear()
+    adt::radix_heap<uint64_t, int> heap;
+    for (uint64_t key = 1000; key < 1100; ++key)
+        heap.push(key, 0);
+    heap.pop();
+    EXPECT_EQ(1001u, heap.top_key());
+    heap.clear();
+    EXPECT_TRUE(heap.empty());
+    CheckRandom<uint64_t>(heap, 10000, 100, 3);
+}
+
+TEST(RadixHeap, SmallKeys) {
+    adt::radix_heap<uint32_t, int> heap;
+    CheckRandom<uint32_t>(heap, 100000, 50, 5);
+    heap.clear();
+    heap.push(std::numeric_limits<uint32_t>::max(), 1);
+    heap.push(0, 2);
+    EXPECT_EQ(0u, heap.top_key());
+    heap.pop();
+    EXPECT_EQ(std::numeric_limits<uint32_t>::max(), heap.top_key());
+    EXPECT_EQ(1, heap.top());
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
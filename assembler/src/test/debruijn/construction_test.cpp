@@ -13,6 +13,11 @@
 #include "pipeline/graph_pack.hpp" // FIXME: get rid of it
 #include "modules/graph_construction.hpp"
 #include "modules/alignment/edge_index.hpp"
+#include "utils/kmer_counting.hpp"
+#include "utils/extension_index/kmer_extension_index_builder.hpp"
+#include "utils/kmer_mph/kmer_splitters.hpp"
+#include "io/binary/binary.hpp"
+#include "stages/construction_storage.hpp"
 
 #include "test_utils.hpp"
 #include "tmp_folder_fixture.hpp"
@@ -20,6 +25,11 @@
 #include <vector>
 #include <set>
 #include <string>
+#include <random>
+#include <unordered_map>
+#include <sstream>
+
+#include <sys/stat.h>
 
 #include <gtest/gtest.h>
 
@@ -106,3 +116,145 @@ TEST_F( GraphConstruction, SimpleTestEarlyPairedInfo ) {
 
     AssertGraph(3, paired_reads, 5, 6, edges, coverage_info, edge_pair_info);
 }
+
+namespace {
+
+struct HashCollector {
+    std::unordered_map<uint64_t, size_t> counts;
+
+    void ProcessKmer(const RtSeq &/*kmer*/, uint64_t hash) {
+        counts[hash] += 1;
+    }
+};
+
+// Reads of the given length sampled from a random genome
+std::vector<std::string> RandomReads(size_t genome_size, size_t read_num, size_t read_len, unsigned seed) {
+    std::mt19937 rnd(seed);
+    std::string genome;
+    for (size_t i = 0; i < genome_size; ++i)
+        genome += nucl(char(rnd() % 4));
+
+    std::vector<std::string> reads;
+    for (size_t i = 0; i < read_num; ++i)
+        reads.push_back(genome.substr(rnd() % (genome_size - read_len), read_len));
+    return reads;
+}
+
+void CheckCoverageHistogram(size_t buffer_size) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    const unsigned k = 22, thr = 3;
+    rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(k);
+
+    auto reads = RandomReads(5000, 1000, 100, 17);
+    std::vector<std::string> first(reads.begin(), reads.begin() + 600), second(reads.begin() + 600, reads.end());
+    io::ReadStreamList<io::SingleRead> streams;
+    streams.push_back(RawStream(MakeReads(first)));
+    streams.push_back(RawStream(MakeReads(second)));
+
+    HashCollector collector;
+    utils::KmerSequenceProcessor<decltype(hasher), HashCollector> kmer_processor(hasher, collector);
+    for (const auto &read : reads)
+        kmer_processor.ProcessSequence(Sequence(read), k);
+
+    qf::cqf reference(utils::EstimateCardinalityUpperBound(k, streams, hasher));
+    utils::FillCoverageHistogram(reference, k, hasher, streams, thr);
+
+    auto workdir = fs::tmp::make_temp_dir(".", "sketch");
+    auto fused = utils::SketchCoverageHistogram(k, hasher, streams, thr, workdir, buffer_size);
+
+    // The filters may be of different size and have different false
+    // positives, but never lose the k-mers
+    size_t mismatches = 0;
+    for (const auto &entry : collector.counts) {
+        size_t expected = std::min<size_t>(entry.second, thr);
+        size_t count = std::min<size_t>(fused->lookup(entry.first), thr);
+        ASSERT_LE(expected, count);
+        ASSERT_LE(expected, std::min<size_t>(reference.lookup(entry.first), thr));
+        mismatches += count != std::min<size_t>(reference.lookup(entry.first), thr);
+    }
+    EXPECT_LE(mismatches, collector.counts.size() / 100);
+}
+
+}
+
+TEST( CoverageHistogram, SinglePass ) {
+    // The whole input fits into the buffers
+    CheckCoverageHistogram(1 << 20);
+}
+
+TEST( CoverageHistogram, Spilled ) {
+    // The buffers overflow and are spilled to disk many times
+    CheckCoverageHistogram(1 << 10);
+}
+
+namespace {
+
+std::string BucketContents(const kmers::KMerDiskStorage<RtSeq> &storage, size_t i) {
+    std::string res;
+    for (const auto &kmer : storage.bucket(i))
+        res.append(reinterpret_cast<const char*>(kmer.first), kmer.second);
+    return res;
+}
+
+// The map itself followed by its k-mers
+std::string ExtIndexContents(const utils::DeBruijnExtensionIndex<> &index) {
+    std::ostringstream os;
+    io::binary::BinWrite(os, index);
+    size_t kmer_bytes = RtSeq::GetDataSize(index.k()) * sizeof(RtSeq::DataType);
+    for (auto it = index.kmer_begin(1)[0]; it.good(); ++it)
+        os.write(reinterpret_cast<const char*>(*it), std::streamsize(kmer_bytes));
+    return os.str();
+}
+
+}
+
+TEST_F( GraphConstruction, StorageSaveLoad ) {
+    typedef io::VectorReadStream<io::SingleReadSeq> RawStream;
+    const unsigned k = 21;
+
+    ConstructionStorage storage(k);
+    storage.workdir = fs::tmp::make_temp_dir(tmp_folder(), "storage");
+
+    storage.cqf.reset(new qf::cqf(1000));
+    for (uint64_t i = 0; i < 500; ++i)
+        storage.cqf->add(i * 7919, i % 5 + 1);
+
+    std::vector<io::SingleReadSeq> reads;
+    for (const auto &read : RandomReads(2000, 100, 100, 5))
+        reads.emplace_back(Sequence(read));
+    io::ReadStreamList<io::SingleReadSeq> streams(RawStream{reads});
+    using Splitter = utils::DeBruijnReadKMerSplitter<io::SingleReadSeq,
+                                                     utils::StoringTypeFilter<utils::DefaultStoring>>;
+    kmers::KMerDiskCounter<RtSeq> counter(storage.workdir, Splitter(storage.workdir, k + 1, streams));
+    storage.kmers.reset(new kmers::KMerDiskStorage<RtSeq>(counter.Count(4, 1)));
+    utils::DeBruijnExtensionIndexBuilder().BuildExtensionIndexFromKPOMers(storage.workdir, storage.ext_index,
+                                                                          *storage.kmers, 1);
+
+    // The second checkpoint reuses the CQF file of the first one
+    std::string first = fs::append_path(tmp_folder(), "first"), second = fs::append_path(tmp_folder(), "second");
+    storage.save(first);
+    storage.save(second);
+    struct stat st;
+    ASSERT_EQ(0, stat(fs::append_path(second, "cqf").c_str(), &st));
+    EXPECT_EQ(2u, st.st_nlink);
+    fs::remove_dir(first);
+
+    ConstructionStorage loaded(k);
+    loaded.workdir = fs::tmp::make_temp_dir(tmp_folder(), "loaded");
+    loaded.load(second);
+
+    ASSERT_TRUE(loaded.cqf);
+    for (uint64_t i = 0; i < 500; ++i)
+        EXPECT_EQ(storage.cqf->lookup(i * 7919), loaded.cqf->lookup(i * 7919));
+
+    ASSERT_TRUE(loaded.kmers);
+    EXPECT_EQ(storage.kmers->k(), loaded.kmers->k());
+    ASSERT_EQ(storage.kmers->num_buckets(), loaded.kmers->num_buckets());
+    EXPECT_LT(0u, storage.kmers->total_kmers());
+    for (size_t i = 0; i < storage.kmers->num_buckets(); ++i)
+        EXPECT_EQ(BucketContents(*storage.kmers, i), BucketContents(*loaded.kmers, i));
+
+    EXPECT_LT(0u, storage.ext_index.size());
+    EXPECT_EQ(storage.ext_index.size(), loaded.ext_index.size());
+    EXPECT_EQ(ExtIndexContents(storage.ext_index), ExtIndexContents(loaded.ext_index));
+}
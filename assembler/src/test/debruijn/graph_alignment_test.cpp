@@ -196,3 +196,31 @@ TEST(GraphAligner, DijkstraGrowEndsTest ) {
     int score = ends_filler.edit_distance();
     EXPECT_EQ(ideal_score, score);
 }
+
+TEST(GraphAligner, DijkstraWorkspaceTest) {
+    size_t K = 55;
+    Graph g(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    typedef omnigraph::DijkstraHelper<Graph> DijkstraHelper;
+    DijkstraHelper::BoundedDijkstra::Workspace workspace;
+    size_t cnt = 0;
+    for (VertexId v : g) {
+        if (cnt++ % 7)
+            continue;
+
+        auto dijkstra = DijkstraHelper::CreateBoundedDijkstra(g, 5000, 1000, true);
+        dijkstra.Run(v);
+        auto reused = DijkstraHelper::CreateBoundedDijkstra(g, 5000, 1000, true, &workspace);
+        reused.Run(v);
+
+        auto reached = dijkstra.ReachedVertices();
+        ASSERT_EQ(reached, reused.ReachedVertices());
+        EXPECT_EQ(dijkstra.VertexLimitExceeded(), reused.VertexLimitExceeded());
+        for (VertexId u : reached) {
+            EXPECT_EQ(dijkstra.GetDistance(u), reused.GetDistance(u));
+            EXPECT_EQ(dijkstra.VertexProcessed(u), reused.VertexProcessed(u));
+            EXPECT_EQ(dijkstra.GetShortestPathTo(u), reused.GetShortestPathTo(u));
+        }
+    }
+}
@@ -5,8 +5,12 @@
 //***************************************************************************
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/core/graph_iterators.hpp"
+#include "modules/alignment/edge_index.hpp"
+#include "utils/filesystem/temporary.hpp"
 
 #include <vector>
+#include <random>
 #include <set>
 #include <string>
 
@@ -106,3 +110,187 @@ TEST( GraphCore, SelfRCEdgeMerge ) {
     EXPECT_EQ(1u, g.OutgoingEdgeCount(v1));
     EXPECT_EQ(Sequence("AACGCTATTCACGTGAATAGCGTT"), g.EdgeNucls(g.GetUniqueOutgoingEdge(v1)));
 }
+
+TEST( GraphCore, IdDistributor ) {
+    omnigraph::ReclaimingIdDistributor ids(3, 100);
+    for (size_t i = 0; i < 100; ++i)
+        EXPECT_EQ(i + 3, ids.allocate());
+    EXPECT_EQ(0u, ids.free());
+
+    // Released ids are reused, the map grows when there are none
+    ids.release(10);
+    ids.release(70);
+    EXPECT_EQ(2u, ids.free());
+    EXPECT_FALSE(ids.occupied(70));
+    std::set<uint64_t> reused = { ids.allocate(), ids.allocate() };
+    EXPECT_EQ(std::set<uint64_t>({ 10, 70 }), reused);
+    EXPECT_EQ(103u, ids.allocate());
+    EXPECT_EQ(200u, ids.size());
+
+    for (uint64_t id = 3; id < 104; id += 2)
+        ids.release(id);
+
+    std::vector<uint64_t> expected;
+    for (uint64_t id = 4; id < 104; id += 2)
+        expected.push_back(id);
+    EXPECT_EQ(expected, std::vector<uint64_t>(ids.begin(), ids.end()));
+
+    for (size_t chunk_cnt : { 1, 3, 7, 64 }) {
+        auto chunks = ids.chunks(chunk_cnt);
+        ASSERT_EQ(chunk_cnt + 1, chunks.size());
+        std::vector<uint64_t> all;
+        for (size_t i = 0; i < chunk_cnt; ++i)
+            all.insert(all.end(), chunks[i], chunks[i + 1]);
+        EXPECT_EQ(expected, all);
+    }
+}
+
+TEST( GraphCore, ParallelIdAllocation ) {
+    omnigraph::ReclaimingIdDistributor ids(0, 10000);
+    std::vector<uint64_t> allocated(5000);
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < allocated.size(); ++i)
+        allocated[i] = ids.allocate();
+
+    std::set<uint64_t> unique(allocated.begin(), allocated.end());
+    EXPECT_EQ(allocated.size(), unique.size());
+    EXPECT_EQ(5000u, ids.free());
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < allocated.size(); i += 2)
+        ids.release(allocated[i]);
+
+    EXPECT_EQ(7500u, ids.free());
+    for (size_t i = 0; i < allocated.size(); ++i)
+        EXPECT_EQ(i % 2 == 1, ids.occupied(allocated[i]));
+}
+
+TEST( GraphCore, ParallelIdGrowth ) {
+    // The map grows many times while the other threads allocate and release
+    omnigraph::ReclaimingIdDistributor ids(0, 1);
+    std::vector<uint64_t> allocated(20000);
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < allocated.size(); ++i) {
+        allocated[i] = ids.allocate();
+        if (i % 4 == 0)
+            ids.release(allocated[i]);
+    }
+
+    // The released ids might have been taken again, the kept ones are distinct
+    std::set<uint64_t> unique;
+    for (size_t i = 0; i < allocated.size(); ++i) {
+        if (i % 4 == 0)
+            continue;
+        EXPECT_TRUE(ids.occupied(allocated[i]));
+        unique.insert(allocated[i]);
+    }
+    EXPECT_EQ(15000u, unique.size());
+    EXPECT_EQ(ids.size() - 15000u, ids.free());
+}
+
+TEST( GraphCore, VertexChunks ) {
+    Graph g(11);
+    createGraph(g, 100);
+    std::vector<VertexId> all(g.begin(), g.end());
+    for (size_t chunk_cnt : { 2, 5, 1000 }) {
+        auto chunks = omnigraph::IterationHelper<Graph, VertexId>(g).Chunks(chunk_cnt);
+        ASSERT_EQ(chunk_cnt + 1, chunks.size());
+        std::vector<VertexId> vertices;
+        for (size_t i = 0; i < chunk_cnt; ++i)
+            vertices.insert(vertices.end(), chunks[i], chunks[i + 1]);
+        EXPECT_EQ(all, vertices);
+    }
+}
+
+class EventCounter : public omnigraph::GraphActionHandler<Graph> {
+  public:
+    size_t added = 0, deleted = 0, merged = 0, delete_batches = 0;
+
+    EventCounter(const Graph &g)
+            : omnigraph::GraphActionHandler<Graph>(g, "EventCounter") {}
+
+    void HandleAdd(EdgeId) override { added += 1; }
+    void HandleDelete(EdgeId) override { deleted += 1; }
+    void HandleMerge(const std::vector<EdgeId> &, EdgeId) override { merged += 1; }
+
+    void HandleDeleteBatch(const std::vector<EdgeId> &edges) override {
+        delete_batches += 1;
+        omnigraph::GraphActionHandler<Graph>::HandleDeleteBatch(edges);
+    }
+};
+
+// Chain of edges spelling a random sequence, so that distinct edges share no (k+1)-mers
+std::pair<std::vector<VertexId>, std::vector<EdgeId>> createRandomGraph(Graph &graph, size_t edgeNumber) {
+    const size_t step = 20;
+    std::mt19937 rnd(239);
+    std::string genome;
+    for (size_t i = 0; i < edgeNumber * step + graph.k(); ++i)
+        genome += nucl(char(rnd() % 4));
+
+    std::vector<VertexId> v;
+    std::vector<EdgeId> e;
+    v.push_back(graph.AddVertex());
+    for (size_t i = 0; i < edgeNumber; i++) {
+        v.push_back(graph.AddVertex());
+        e.push_back(graph.AddEdge(v[i], v[i + 1], Sequence(genome.substr(i * step, step + graph.k()))));
+    }
+    return make_pair(v, e);
+}
+
+std::vector<RtSeq> EdgeKMers(const Graph &g, EdgeId e) {
+    std::vector<RtSeq> res;
+    const Sequence &nucls = g.EdgeNucls(e);
+    for (size_t i = 0; i + g.k() + 1 <= nucls.size(); ++i)
+        res.emplace_back(g.k() + 1, nucls, i);
+    return res;
+}
+
+TEST( GraphCore, BatchedEvents ) {
+    Graph g(11);
+    auto data = createRandomGraph(g, 4);
+    EventCounter counter(g);
+
+    auto tmp_dir = fs::tmp::make_temp_dir(".", "edge_index");
+    EdgeIndex<Graph> index(g, tmp_dir->dir());
+    index.Refill();
+    std::vector<RtSeq> kmers;
+    for (EdgeId e : g.edges()) {
+        auto edge_kmers = EdgeKMers(g, e);
+        kmers.insert(kmers.end(), edge_kmers.begin(), edge_kmers.end());
+    }
+
+    g.BatchEvents();
+    g.DeleteEdge(data.second[3]);
+    g.DeleteVertex(data.first[4]);
+    g.CompressVertex(data.first[1]);
+
+    // The structure is updated at once, the handlers are not
+    EdgeId merged = g.GetUniqueOutgoingEdge(data.first[0]);
+    EXPECT_EQ(data.first[2], g.EdgeEnd(merged));
+    EXPECT_EQ(0u, g.OutgoingEdgeCount(data.first[3]));
+    EXPECT_EQ(0u, counter.deleted + counter.added + counter.merged);
+
+    g.FlushEvents();
+    EXPECT_EQ(2u, counter.added);
+    EXPECT_EQ(6u, counter.deleted);
+    EXPECT_EQ(2u, counter.merged);
+    // Edge deletions of the tip and of the merge are delivered as a single batch
+    EXPECT_EQ(1u, counter.delete_batches);
+    EXPECT_EQ(6u, g.size());
+    EXPECT_EQ(4u, g.e_size());
+
+    // Batched updates leave the index in the same state as the rebuilt one:
+    // the k-mers of the deleted edges are gone, the merged ones moved
+    EdgeIndex<Graph> rebuilt(g, tmp_dir->dir());
+    rebuilt.Refill();
+    size_t found = 0;
+    for (const auto &kmer : kmers) {
+        auto pos = index.get(kmer);
+        EXPECT_EQ(rebuilt.get(kmer), pos);
+        found += pos.second != EdgeIndex<Graph>::NOT_FOUND;
+    }
+    // The remaining three edges of the chain and their conjugates
+    EXPECT_EQ(6 * 20u, found);
+}
@@ -8,8 +8,14 @@
 #include "random_graph.hpp"
 #include "assembly_graph/handlers/id_track_handler.hpp"
 #include "io/binary/graph.hpp"
+#include "io/binary/graph_snapshot.hpp"
 #include "io/binary/kmer_mapper.hpp"
 #include "io/binary/paired_index.hpp"
+#include "io/reads/binary_converter.hpp"
+#include "io/reads/binary_streams.hpp"
+#include "io/reads/vector_reader.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "threadpool/threadpool.hpp"
 
 #include <gtest/gtest.h>
 
@@ -63,6 +69,34 @@ TEST(Io, Order) {
     CompareGraphIterators(graph.SmartEdgeBegin(), new_graph.SmartEdgeBegin());
 }
 
+TEST(Io, GraphSnapshot) {
+    const auto &graph = CommonGraph();
+
+    GraphSnapshotIO<Graph>().Save(file_name, graph);
+
+    Graph new_graph(graph.k());
+    ASSERT_TRUE(GraphSnapshotIO<Graph>().Load(file_name, new_graph));
+
+    CompareGraphIterators(graph.SmartVertexBegin(), new_graph.SmartVertexBegin());
+    CompareGraphIterators(graph.SmartEdgeBegin(), new_graph.SmartEdgeBegin());
+    EXPECT_EQ(graph.size(), new_graph.size());
+    EXPECT_EQ(graph.e_size(), new_graph.e_size());
+    for (EdgeId e : graph.edges()) {
+        ASSERT_TRUE(new_graph.contains(e));
+        EXPECT_EQ(graph.conjugate(e), new_graph.conjugate(e));
+        EXPECT_EQ(graph.EdgeStart(e), new_graph.EdgeStart(e));
+        EXPECT_EQ(graph.EdgeEnd(e), new_graph.EdgeEnd(e));
+        EXPECT_EQ(graph.EdgeNucls(e), new_graph.EdgeNucls(e));
+        EXPECT_EQ(graph.coverage_index().RawCoverage(e), new_graph.coverage_index().RawCoverage(e));
+    }
+    for (VertexId v : graph) {
+        EXPECT_EQ(graph.conjugate(v), new_graph.conjugate(v));
+        EXPECT_EQ(graph.OutgoingEdgeCount(v), new_graph.OutgoingEdgeCount(v));
+    }
+
+    EXPECT_FALSE(GraphSnapshotIO<Graph>().Load(std::string(file_name) + "_missing", new_graph));
+}
+
 TEST(Io, PairedInfo) {
     using namespace omnigraph::de;
     using Index = UnclusteredPairedInfoIndexT<Graph>;
@@ -109,3 +143,61 @@ TEST(Io, KmerMapper) {
 
     CompareContainers(kmer_mapper, new_mapper);
 }
+
+TEST(Io, BinaryReads) {
+    auto tmp_dir = fs::tmp::make_temp_dir(".", "binary_reads");
+    const std::string prefix = tmp_dir->dir() + "/reads";
+
+    std::vector<io::SingleReadSeq> reads;
+    // Several blocks of reads
+    for (size_t i = 0; i < 200000; ++i)
+        reads.emplace_back(RandomSequence(i % 157 + 1), io::SequenceOffsetT(i % 7), io::SequenceOffsetT(i % 5));
+
+    {
+        io::BinaryWriter writer(prefix);
+        io::ReadStream<io::SingleReadSeq> stream{io::VectorReadStream<io::SingleReadSeq>(reads)};
+        writer.ToBinary(stream);
+    }
+
+    // Blocks compressed by the pool are written in the same order
+    {
+        io::BinaryWriter writer(prefix + "_pool");
+        io::ReadStream<io::SingleReadSeq> stream{io::VectorReadStream<io::SingleReadSeq>(reads)};
+        ThreadPool::ThreadPool pool(4);
+        writer.ToBinary(stream, &pool);
+    }
+    auto contents = [](const std::string &file_name) {
+        std::ifstream is(file_name, std::ios_base::binary);
+        return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    };
+    for (const char *ext : { ".seq", ".blk" })
+        EXPECT_EQ(contents(prefix + ext), contents(prefix + "_pool" + ext)) << ext;
+
+    // More portions than blocks as well, every portion gets its equal share
+    for (size_t portions : { 1, 3, 20 }) {
+        size_t i = 0;
+        for (size_t portion = 0; portion < portions; ++portion) {
+            io::BinaryFileSingleStream stream(prefix, portions, portion);
+            const size_t start = i;
+            // The second pass goes over the same mapped reads
+            for (size_t pass = 0; pass < 2; ++pass) {
+                stream.reset();
+                size_t j = i;
+                io::SingleReadSeq read;
+                while (!stream.eof()) {
+                    stream >> read;
+                    ASSERT_LT(j, reads.size());
+                    EXPECT_EQ(reads[j].sequence(), read.sequence());
+                    EXPECT_EQ(reads[j].sequence().str(), read.sequence().str());
+                    EXPECT_EQ(reads[j].GetLeftOffset(), read.GetLeftOffset());
+                    EXPECT_EQ(reads[j].GetRightOffset(), read.GetRightOffset());
+                    ++j;
+                }
+                if (pass == 1)
+                    i = j;
+            }
+            EXPECT_EQ(reads.size() / portions + (portion < reads.size() % portions ? 1 : 0), i - start);
+        }
+        EXPECT_EQ(reads.size(), i);
+    }
+}
@@ -0,0 +1,97 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "modules/alignment/sharded_kmer_map.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <sstream>
+
+using namespace debruijn_graph;
+
+namespace {
+
+const unsigned K = 55;
+
+std::vector<std::pair<RtSeq, RtSeq>> RandomEntries(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::pair<RtSeq, RtSeq>> res;
+    std::string key(K, 'A'), value(K, 'A');
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < K; ++j) {
+            key[j] = "ACGT"[rng() & 3];
+            value[j] = "ACGT"[rng() & 3];
+        }
+        res.emplace_back(RtSeq(K, key.c_str()), RtSeq(K, value.c_str()));
+    }
+    return res;
+}
+
+std::vector<std::pair<RtSeq, RtSeq>> Contents(const ShardedKMerMap &map) {
+    return std::vector<std::pair<RtSeq, RtSeq>>(map.begin(), map.end());
+}
+
+}
+
+TEST(ShardedKMerMap, Lookup) {
+    ShardedKMerMap map(K);
+    std::map<RtSeq, RtSeq, RtSeq::less2> expected;
+    auto entries = RandomEntries(20000, 1);
+    for (const auto &entry : entries) {
+        map.set(entry.first, entry.second);
+        expected[entry.first] = entry.second;
+    }
+    // Updates and erasures
+    for (size_t i = 0; i < entries.size(); i += 3) {
+        map.set(entries[i].first, entries[i + 1].second);
+        expected[entries[i].first] = entries[i + 1].second;
+    }
+    for (size_t i = 1; i < entries.size(); i += 5) {
+        map.erase(entries[i].first);
+        expected.erase(entries[i].first);
+    }
+
+    EXPECT_EQ(expected.size(), map.size());
+    EXPECT_EQ(expected.size(), Contents(map).size());
+    for (const auto &entry : entries) {
+        auto it = expected.find(entry.first);
+        const auto *value = map.find(entry.first);
+        ASSERT_EQ(it != expected.end(), value != nullptr);
+        if (value) {
+            EXPECT_EQ(it->second, RtSeq(K, value));
+        }
+    }
+}
+
+TEST(ShardedKMerMap, InsertionOrderIndependence) {
+    auto entries = RandomEntries(20000, 2);
+    ShardedKMerMap map(K), shuffled_map(K);
+    for (const auto &entry : entries)
+        map.set(entry.first, entry.second);
+
+    std::shuffle(entries.begin(), entries.end(), std::mt19937(3));
+    for (const auto &entry : entries)
+        shuffled_map.set(entry.first, entry.second);
+
+    EXPECT_EQ(Contents(map), Contents(shuffled_map));
+}
+
+TEST(ShardedKMerMap, SaveLoad) {
+    ShardedKMerMap map(K);
+    for (const auto &entry : RandomEntries(50000, 4))
+        map.set(entry.first, entry.second);
+
+    std::stringstream ss;
+    map.BinWrite(ss);
+
+    ShardedKMerMap loaded(K);
+    loaded.BinRead(ss);
+    EXPECT_EQ(map.size(), loaded.size());
+    EXPECT_EQ(Contents(map), Contents(loaded));
+}
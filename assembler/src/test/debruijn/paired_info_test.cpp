@@ -6,6 +6,7 @@
 
 #include "random_graph.hpp"
 
+#include "paired_info/frozen_paired_info.hpp"
 #include "paired_info/index_point.hpp"
 #include "paired_info/paired_info_helpers.hpp"
 //#include "io/binary/paired_index.hpp"
@@ -458,3 +459,33 @@ TEST(PairedInfo, RandomSymmetry) {
         }
     }
 }
+
+TEST(PairedInfo, FrozenIndex) {
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/100).Generate(/*iterations*/1000);
+
+    std::vector<debruijn_graph::EdgeId> edges(graph.edges().begin(), graph.edges().end());
+    PairedInfoIndexT<debruijn_graph::Graph> pi(graph);
+    for (size_t i = 0; i < 500; ++i)
+        pi.Add(edges[rand() % edges.size()], edges[rand() % edges.size()],
+               Point(DEDistance(rand() % 100), DEWeight(1 + rand() % 5), DEVariance(rand() % 3)));
+
+    FrozenPairedIndex<debruijn_graph::Graph> frozen(graph);
+    frozen.Build(pi);
+    EXPECT_EQ(pi.size(), frozen.size());
+
+    for (auto e1 : edges) {
+        std::vector<std::pair<debruijn_graph::EdgeId, Histogram<Point>>> expected, actual;
+        for (auto i : pi.Get(e1))
+            expected.emplace_back(i.first, i.second.Unwrap());
+        for (auto i : frozen.Get(e1))
+            actual.emplace_back(i.first, Histogram<Point>(i.second.begin(), i.second.end()));
+        EXPECT_EQ(expected, actual);
+
+        for (auto e2 : edges) {
+            auto hist = frozen.Get(e1, e2);
+            EXPECT_EQ(pi.Get(e1, e2).Unwrap(), Histogram<Point>(hist.begin(), hist.end()));
+            EXPECT_EQ(pi.contains(e1, e2), frozen.contains(e1, e2));
+        }
+    }
+}
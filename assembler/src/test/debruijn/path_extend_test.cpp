@@ -5,10 +5,13 @@
 //***************************************************************************
 
 
+#include "modules/path_extend/path_extender.hpp"
 #include "modules/path_extend/path_visualizer.hpp"
 #include "modules/path_extend/pe_utils.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include "graphio.hpp"
+#include "random_graph.hpp"
 
 #include <gtest/gtest.h>
 
@@ -580,6 +583,56 @@ TEST( PathExtend, BidirectionalPathAddRemoveConjugate ) {
     EXPECT_EQ(cp->LengthAt(3), 426);
 }
 
+TEST( PathExtend, BidirectionalPathBulkAdd ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+    EdgeId start = *g.ConstEdgeBegin();
+
+    EdgeId e1 = g.conjugate(start);
+    EdgeId e2 = *(g.OutgoingEdges(g.EdgeEnd(e1)).begin());
+    EdgeId e3 = *(g.OutgoingEdges(g.EdgeEnd(e2)).begin());
+    EdgeId e4 = *(g.OutgoingEdges(g.EdgeEnd(e3)).begin());
+
+    auto tail = BidirectionalPath::create(g);
+    tail->PushBack(e2);
+    tail->PushBack(e3, Gap(10));
+    tail->PushBack(e4, Gap(10));
+
+    auto p = BidirectionalPath::create(g);
+    auto cp = BidirectionalPath::create(g);
+    cp->Subscribe(*p);
+    p->Subscribe(*cp);
+
+    GraphCoverageMap coverage_map(g);
+    p->Subscribe(coverage_map);
+    cp->Subscribe(coverage_map);
+
+    p->PushBack(e1);
+    p->PushBack(*tail, Gap(100));
+    EXPECT_EQ(cp->Conjugate(), *p);
+    EXPECT_EQ(cp->Front(), g.conjugate(e4));
+    EXPECT_EQ(cp->Back(), g.conjugate(e1));
+    EXPECT_EQ(cp->GapAt(3).gap, 100);
+    EXPECT_EQ(cp->LengthAt(0), 1182);
+    EXPECT_EQ(cp->LengthAt(1), 1116);
+    EXPECT_EQ(cp->LengthAt(2), 527);
+    EXPECT_EQ(cp->LengthAt(3), 426);
+    EXPECT_EQ(p->Length(), 1182);
+    EXPECT_EQ(p->LengthAt(1), 1182 - g.length(e1) - 100);
+
+    EXPECT_EQ(coverage_map.Count(e3, *p), 1);
+    EXPECT_EQ(coverage_map.Count(g.conjugate(e3), *cp), 1);
+
+    p->PopBack(3);
+    p->PushBack(std::vector<EdgeId>{e2, e3, e4});
+    EXPECT_EQ(cp->Conjugate(), *p);
+    EXPECT_EQ(p->Length(), 1182 - 100 - 10 - 10);
+    EXPECT_EQ(p->LengthAt(3), g.length(e4));
+    EXPECT_EQ(coverage_map.Count(e4, *p), 1);
+    EXPECT_EQ(coverage_map.Count(g.conjugate(e4), *cp), 1);
+    EXPECT_EQ(coverage_map.GetCoverage(e2), 1);
+}
+
 
 TEST( PathExtend, BidirectionalPathSearch ) {
     Graph g(13);
@@ -755,3 +808,78 @@ TEST( PathExtend, BidirectionalPathLoopDetector ) {
     EXPECT_EQ(path1->Size(), 12);
     EXPECT_EQ(path1->Back(), e7);
 }
+
+namespace {
+
+// Extends the path by the least covered outgoing edge, until every edge is
+// covered at least twice
+class LeastCoveredExtender : public PathExtender {
+public:
+    LeastCoveredExtender(const Graph &g, const GraphCoverageMap &cov_map, UsedUniqueStorage &used_storage)
+            : PathExtender(g), cov_map_(cov_map), used_storage_(used_storage) {}
+
+    bool MakeGrowStep(BidirectionalPath &path, PathContainer*) override {
+        if (path.Size() >= 30)
+            return false;
+
+        EdgeId next;
+        size_t min_coverage = 2;
+        for (EdgeId e : g_.OutgoingEdges(g_.EdgeEnd(path.Back()))) {
+            size_t coverage = cov_map_.GetCoverage(e) + cov_map_.Count(e, path);
+            if (coverage < min_coverage) {
+                next = e;
+                min_coverage = coverage;
+            }
+        }
+        return next && used_storage_.TryUseEdge(path, next, Gap());
+    }
+
+private:
+    const GraphCoverageMap &cov_map_;
+    UsedUniqueStorage &used_storage_;
+};
+
+void ExtendSeeds(const Graph &g, const ScaffoldingUniqueEdgeStorage &unique, bool parallel,
+                 PathContainer &result) {
+    PathContainer seeds;
+    for (EdgeId e : g.canonical_edges())
+        seeds.Create(g, e);
+
+    GraphCoverageMap cover_map(g);
+    UsedUniqueStorage used_storage(unique, g);
+    auto factory = [&](const GraphCoverageMap &cm, UsedUniqueStorage &us) {
+        return CompositeExtender::ExtendersT{ std::make_shared<LeastCoveredExtender>(g, cm, us) };
+    };
+    CompositeExtender extender(g, cover_map, used_storage, factory(cover_map, used_storage),
+                               parallel ? factory : CompositeExtender::ExtendersFactory());
+    extender.GrowAll(seeds, result);
+}
+
+}
+
+TEST( PathExtend, ParallelExtension ) {
+    Graph g(21);
+    RandomGraph<Graph>(g, /*max_size*/100).Generate(/*iterations*/1000);
+    ScaffoldingUniqueEdgeStorage unique;
+    for (EdgeId e : g.edges()) {
+        if (g.int_id(e) % 3 == 0)
+            unique.insert(e);
+    }
+
+    PathContainer expected;
+    ExtendSeeds(g, unique, false, expected);
+    ASSERT_LT(0u, expected.size());
+
+    size_t max_threads = omp_get_max_threads();
+    for (size_t threads : { 1, 2, 4 }) {
+        omp_set_num_threads(int(threads));
+        PathContainer paths;
+        ExtendSeeds(g, unique, true, paths);
+        ASSERT_EQ(expected.size(), paths.size());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            EXPECT_TRUE(expected.Get(i) == paths.Get(i));
+            EXPECT_TRUE(expected.GetConjugate(i) == paths.GetConjugate(i));
+        }
+    }
+    omp_set_num_threads(int(max_threads));
+}
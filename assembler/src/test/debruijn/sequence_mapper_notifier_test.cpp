@@ -0,0 +1,157 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "modules/alignment/sequence_mapper_notifier.hpp"
+#include "modules/alignment/mapping_path_cache.hpp"
+#include "modules/graph_construction.hpp"
+#include "pipeline/graph_pack.hpp"
+#include "io/reads/vector_reader.hpp"
+#include "io/reads/read_stream_vector.hpp"
+#include "utils/filesystem/temporary.hpp"
+
+#include "tmp_folder_fixture.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace debruijn_graph;
+
+namespace {
+
+// Records the reads with the sizes of their mapping paths in the order the
+// buffers are merged
+class RecordingListener : public SequenceMapperListener {
+public:
+    void StartProcessLibrary(size_t threads_count) override {
+        buffers_.assign(threads_count, {});
+        merged_.clear();
+    }
+
+    void ProcessSingleRead(size_t thread_index, const io::SingleRead &r, const MappingPath<EdgeId> &path) override {
+        buffers_[thread_index].push_back(r.name() + ":" + std::to_string(path.size()));
+    }
+
+    void MergeBuffer(size_t thread_index) override {
+        auto &buffer = buffers_[thread_index];
+        merged_.insert(merged_.end(), buffer.begin(), buffer.end());
+        buffer.clear();
+    }
+
+    const std::vector<std::string> &merged() const { return merged_; }
+
+private:
+    std::vector<std::vector<std::string>> buffers_;
+    std::vector<std::string> merged_;
+};
+
+std::string RandomGenome(size_t length, std::mt19937 &rnd) {
+    std::string genome;
+    for (size_t i = 0; i < length; ++i)
+        genome += "ACGT"[rnd() % 4];
+    return genome;
+}
+
+// Reads of the genome, every tenth one does not map
+std::vector<io::SingleRead> SampleReads(const std::string &genome, size_t stream, size_t count,
+                                        std::mt19937 &rnd) {
+    const size_t READ_LENGTH = 100;
+    std::vector<io::SingleRead> reads;
+    for (size_t i = 0; i < count; ++i) {
+        std::string seq = (i % 10 ? genome.substr(rnd() % (genome.size() - READ_LENGTH), READ_LENGTH)
+                                  : RandomGenome(READ_LENGTH, rnd));
+        reads.emplace_back(std::to_string(stream) + "_" + std::to_string(i), seq, std::string(READ_LENGTH, 'I'));
+    }
+    return reads;
+}
+
+void ConstructGraph(GraphPack &gp, const std::string &genome, fs::TmpDir workdir) {
+    io::ReadStreamList<io::SingleRead> genome_stream(
+        io::VectorReadStream<io::SingleRead>(io::SingleRead("genome", genome, std::string(genome.size(), 'I'))));
+    ConstructGraphWithCoverage(config::debruijn_config::construction(), workdir, genome_stream,
+                               gp.get_mutable<Graph>(), gp.get_mutable<EdgeIndex<Graph>>(),
+                               gp.get_mutable<omnigraph::FlankingCoverage<Graph>>());
+    gp.get_mutable<KmerMapper<Graph>>().Attach();
+    gp.EnsureBasicMapping();
+}
+
+}
+
+class SequenceMapperNotifierTest : public ::testing::Test, public TmpFolderFixture {};
+
+TEST_F( SequenceMapperNotifierTest, DeterministicMergeOrder ) {
+    GraphPack gp(21, tmp_folder(), 1);
+    std::mt19937 rnd(42);
+    std::string genome = RandomGenome(5000, rnd);
+    ConstructGraph(gp, genome, fs::tmp::make_temp_dir(gp.workdir(), "tests"));
+
+    // Skewed streams, the last one ends exactly at a chunk boundary
+    std::vector<std::vector<io::SingleRead>> reads;
+    for (size_t size : { 40000, 100, 1 << 15 })
+        reads.push_back(SampleReads(genome, reads.size(), size, rnd));
+
+    auto mapper = MapperInstance(gp);
+    std::vector<std::string> expected;
+    for (size_t threads : { 1, 2, 3, 5 }) {
+        io::ReadStreamList<io::SingleRead> streams;
+        for (const auto &stream_reads : reads)
+            streams.push_back(io::VectorReadStream<io::SingleRead>(stream_reads));
+
+        SequenceMapperNotifier notifier(gp, 1);
+        RecordingListener listener;
+        notifier.Subscribe(0, &listener);
+        notifier.ProcessLibrary(streams, 0, *mapper, threads);
+
+        ASSERT_EQ(40000u + 100u + (1u << 15), listener.merged().size());
+        if (expected.empty())
+            expected = listener.merged();
+        EXPECT_EQ(expected, listener.merged()) << "threads: " << threads;
+    }
+
+    // Chunks are merged in (chunk, stream) order
+    EXPECT_EQ(0u, expected[0].find("0_0:"));
+    EXPECT_EQ(0u, expected[1 << 14].find("1_0:"));
+    EXPECT_EQ(0u, expected[(1 << 14) + 100].find("2_0:"));
+}
+
+TEST_F( SequenceMapperNotifierTest, MappingPathCacheReplay ) {
+    GraphPack gp(21, tmp_folder(), 1);
+    std::mt19937 rnd(17);
+    std::string genome = RandomGenome(5000, rnd);
+    ConstructGraph(gp, genome, fs::tmp::make_temp_dir(gp.workdir(), "tests"));
+
+    std::vector<std::vector<io::SingleRead>> reads;
+    for (size_t size : { 20000, 3000 })
+        reads.push_back(SampleReads(genome, reads.size(), size, rnd));
+
+    auto mapper = MapperInstance(gp);
+    MappingPathCache cache(fs::tmp::make_temp_dir(gp.workdir(), "mapping_cache"));
+    auto process = [&](MappingPathCache *cache, size_t threads) {
+        io::ReadStreamList<io::SingleRead> streams;
+        for (const auto &stream_reads : reads)
+            streams.push_back(io::VectorReadStream<io::SingleRead>(stream_reads));
+
+        SequenceMapperNotifier notifier(gp, 1);
+        RecordingListener listener;
+        notifier.Subscribe(0, &listener);
+        if (cache)
+            notifier.ProcessLibrary(streams, 0, *mapper, *cache, threads);
+        else
+            notifier.ProcessLibrary(streams, 0, *mapper, threads);
+        return listener.merged();
+    };
+
+    auto expected = process(nullptr, 2);
+    ASSERT_EQ(23000u, expected.size());
+
+    // The first pass stores the paths, the following ones replay them
+    EXPECT_EQ(expected, process(&cache, 3));
+    ASSERT_TRUE(cache.ready());
+    for (size_t threads : { 1, 2, 5 })
+        EXPECT_EQ(expected, process(&cache, threads)) << "threads: " << threads;
+}
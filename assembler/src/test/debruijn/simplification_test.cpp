@@ -14,6 +14,8 @@
 
 #include <gtest/gtest.h>
 
+#include <set>
+
 using namespace debruijn_graph;
 using namespace debruijn_graph::config;
 
@@ -153,6 +155,40 @@ TEST_F( Simplification,  SimpleTipClipperTest ) {
     EXPECT_EQ(4, g.size());
 }
 
+TEST_F( Simplification,  BatchedTipClipperTest ) {
+    std::string path = "./src/test/debruijn/graph_fragments/tipobulge/tipobulge";
+    Graph g1(55), g2(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph(path, g1));
+    ASSERT_TRUE(graphio::ScanBasicGraph(path, g2));
+
+    auto info = standard_simplif_relevant_info();
+    debruijn::simplification::ConditionParser<Graph> parser(g1, standard_tc_config().condition, info);
+    auto condition = AddTipCondition(g1, parser());
+    ParallelEdgeRemovingAlgorithm<Graph, LengthComparator<Graph>> sequential(g1, condition, info.chunk_cnt(),
+                                                                             nullptr, /*canonical_only*/true,
+                                                                             LengthComparator<Graph>(g1));
+    size_t triggered = sequential.Run();
+
+    // Small batches make the elements conflict
+    debruijn::simplification::ConditionParser<Graph> parser2(g2, standard_tc_config().condition, info);
+    ParallelEdgeRemovingAlgorithm<Graph, LengthComparator<Graph>> batched(g2, AddTipCondition(g2, parser2()),
+                                                                          info.chunk_cnt(),
+                                                                          nullptr, /*canonical_only*/true,
+                                                                          LengthComparator<Graph>(g2));
+    batched.ProcessInBatches(2);
+
+    EXPECT_EQ(triggered, batched.Run());
+    EXPECT_EQ(g1.size(), g2.size());
+    // Merged edges might get different ids, so the edges are compared by sequence
+    auto edge_set = [](const Graph &g) {
+        std::multiset<std::string> res;
+        for (EdgeId e : g.edges())
+            res.insert(g.EdgeNucls(e).str());
+        return res;
+    };
+    EXPECT_EQ(edge_set(g1), edge_set(g2));
+}
+
 TEST_F( Simplification,  SimpleBulgeRemovalTest ) {
     Graph g(55);
     ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/simpliest_bulge/simpliest_bulge", g));
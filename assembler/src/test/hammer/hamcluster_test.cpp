@@ -0,0 +1,108 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "hamcluster.hpp"
+#include "globals.hpp"
+
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/logger/log_writers.hpp"
+
+#include <random>
+#include <set>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Groups of k-mers sharing the prefix (so some sub-k-mer blocks are big),
+// each k-mer followed by a few close variants
+void FillKMers(KMerData &data, unsigned seed) {
+    std::mt19937 rnd(seed);
+    std::set<std::string> kmers;
+    for (size_t group = 0; group < 20; ++group) {
+        std::string prefix;
+        for (size_t i = 0; i < 7; ++i)
+            prefix += nucl(char(rnd() % 4));
+
+        for (size_t n = 0; n < 100; ++n) {
+            std::string kmer = prefix;
+            while (kmer.size() < hammer::K)
+                kmer += nucl(char(rnd() % 4));
+            kmers.insert(kmer);
+
+            for (size_t variant = rnd() % 4; variant > 0; --variant) {
+                std::string mutated = kmer;
+                for (size_t m = rnd() % 3 + 1; m > 0; --m)
+                    mutated[rnd() % hammer::K] = nucl(char(rnd() % 4));
+                kmers.insert(mutated);
+            }
+        }
+    }
+
+    for (const auto &kmer : kmers)
+        data.push_back(hammer::KMer(kmer), KMerStat());
+}
+
+std::vector<size_t> Clusters(const dsu::ConcurrentDSU &uf, size_t size) {
+    // Every element is mapped to the smallest element of its cluster
+    std::vector<size_t> res(size, -1ULL), min(size, -1ULL);
+    for (size_t i = 0; i < size; ++i) {
+        size_t root = uf.find_set(i);
+        if (min[root] == -1ULL)
+            min[root] = i;
+        res[i] = min[root];
+    }
+    return res;
+}
+
+void CheckEngines(unsigned tau, unsigned block_thr) {
+    Globals::subKMerPositions = new std::vector<uint32_t>(tau + 2);
+    for (uint32_t i = 0; i < tau + 1; ++i)
+        (*Globals::subKMerPositions)[i] = i * hammer::K / (tau + 1);
+    (*Globals::subKMerPositions)[tau + 1] = hammer::K;
+
+    KMerData data;
+    FillKMers(data, 239 + tau);
+    KMerHamClusterer clusterer(tau, block_thr);
+
+    auto tmp_dir = fs::tmp::make_temp_dir(".", "hamcluster");
+    dsu::ConcurrentDSU disk_uf(data.size()), memory_uf(data.size());
+    clusterer.cluster_on_disk(fs::append_path(tmp_dir->dir(), "kmers.hamcls"), data, disk_uf);
+    clusterer.cluster_in_memory(data, memory_uf);
+
+    EXPECT_LT(disk_uf.num_sets(), data.size());
+    EXPECT_EQ(Clusters(disk_uf, data.size()), Clusters(memory_uf, data.size()));
+
+    delete Globals::subKMerPositions;
+    Globals::subKMerPositions = nullptr;
+}
+
+}
+
+TEST(HammingClustering, InMemoryEqualsOnDisk) {
+    CheckEngines(2, 50);
+}
+
+TEST(HammingClustering, InMemoryEqualsOnDiskSmallBlocks) {
+    // Most of the blocks go to the second pass
+    CheckEngines(3, 5);
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+  create_console_logger();
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "read_cache.hpp"
+
+#include "io/reads/ireadstream.hpp"
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/filesystem/temporary.hpp"
+
+#include <fstream>
+#include <random>
+
+#include <sys/stat.h>
+#include <utime.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Reads with N's, other IUPAC codes and lowercase (soft-masked) bases
+std::string RandomReads(size_t n, unsigned seed) {
+    std::mt19937 rnd(seed);
+    std::string text;
+    for (size_t i = 0; i < n; ++i) {
+        std::string seq, qual;
+        for (size_t j = rnd() % 150 + 1; j > 0; --j) {
+            seq += (rnd() % 10 ? "ACGT"[rnd() % 4] : "NacgtnRY"[rnd() % 8]);
+            qual += char('!' + rnd() % 42);
+        }
+        text += "@read_" + std::to_string(i) + " comment\n" + seq + "\n+\n" + qual + "\n";
+    }
+    return text;
+}
+
+void WriteFile(const std::string &filename, const std::string &text) {
+    std::ofstream os(filename, std::ios::binary);
+    os << text;
+}
+
+void SetMTime(const std::string &filename, time_t mtime) {
+    struct utimbuf times = { mtime, mtime };
+    ASSERT_EQ(0, utime(filename.c_str(), &times));
+}
+
+}
+
+TEST(ReadCache, SameReadsAsFastq) {
+    auto tmp_dir = fs::tmp::make_temp_dir(".", "read_cache");
+    std::string input = fs::append_path(tmp_dir->dir(), "reads.fastq");
+    WriteFile(input, RandomReads(5000, 1));
+
+    hammer::ReadCache::Prepare({ input }, tmp_dir->dir());
+    ASSERT_TRUE(hammer::ReadCache::Valid(input, hammer::ReadCache::Filename(input, tmp_dir->dir())));
+
+    for (int offset : { 33, 0 }) {
+        hammer::ReadCacheStream cached(input, offset, tmp_dir->dir());
+        // The second pass goes after reset()
+        for (size_t pass = 0; pass < 2; ++pass) {
+            cached.reset();
+            ireadstream expected(input, offset);
+            size_t reads = 0;
+            while (!expected.eof()) {
+                Read r, cr;
+                expected >> r;
+                ASSERT_FALSE(cached.eof());
+                cached >> cr;
+                EXPECT_EQ(r.getName(), cr.getName());
+                EXPECT_EQ(r.getSequenceString(), cr.getSequenceString());
+                EXPECT_EQ(r.getQualityString(), cr.getQualityString());
+                ++reads;
+            }
+            EXPECT_TRUE(cached.eof());
+            EXPECT_EQ(5000u, reads);
+        }
+    }
+}
+
+TEST(ReadCache, Invalidation) {
+    auto tmp_dir = fs::tmp::make_temp_dir(".", "read_cache");
+    std::string input = fs::append_path(tmp_dir->dir(), "reads.fastq");
+    std::string cache = hammer::ReadCache::Filename(input, tmp_dir->dir());
+    std::string text = RandomReads(100, 2);
+    WriteFile(input, text);
+    SetMTime(input, 1000000);
+
+    EXPECT_FALSE(hammer::ReadCache::Valid(input, cache));
+    hammer::ReadCache::Build(input, cache);
+    EXPECT_TRUE(hammer::ReadCache::Valid(input, cache));
+
+    // Same size, other mtime
+    SetMTime(input, 2000000);
+    EXPECT_FALSE(hammer::ReadCache::Valid(input, cache));
+    hammer::ReadCache::Prepare({ input }, tmp_dir->dir());
+    EXPECT_TRUE(hammer::ReadCache::Valid(input, cache));
+
+    // Same mtime, other size
+    WriteFile(input, text + RandomReads(1, 3));
+    SetMTime(input, 2000000);
+    EXPECT_FALSE(hammer::ReadCache::Valid(input, cache));
+    hammer::ReadCache::Prepare({ input }, tmp_dir->dir());
+    EXPECT_TRUE(hammer::ReadCache::Valid(input, cache));
+
+    hammer::ReadCacheStream cached(input, 33, tmp_dir->dir());
+    size_t reads = 0;
+    for (Read r; !cached.eof(); ++reads)
+        cached >> r;
+    EXPECT_EQ(101u, reads);
+
+    // Unfinished store
+    std::string part = cache + ".part";
+    hammer::ReadCache::Build(input, part);
+    {
+        std::fstream os(part, std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t magic = 0;
+        os.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    }
+    EXPECT_FALSE(hammer::ReadCache::Valid(input, part));
+}
@@ -0,0 +1,104 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "read_output.hpp"
+
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/filesystem/temporary.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <random>
+
+#include <zlib.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string RandomReads(size_t n, unsigned seed) {
+    std::mt19937 rnd(seed);
+    std::string text;
+    for (size_t i = 0; i < n; ++i) {
+        std::string seq, qual;
+        for (size_t j = rnd() % 150 + 1; j > 0; --j) {
+            seq += "ACGTN"[rnd() % 5];
+            qual += char('!' + rnd() % 42);
+        }
+        text += "@read_" + std::to_string(i) + "\n" + seq + "\n+\n" + qual + "\n";
+    }
+    return text;
+}
+
+std::string ReadFile(const std::string &filename) {
+    std::ifstream is(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+// gzread goes through all the concatenated gzip members
+std::string Decompress(const std::string &filename) {
+    gzFile file = gzopen(filename.c_str(), "rb");
+    std::string res;
+    char buf[1 << 16];
+    int len;
+    while ((len = gzread(file, buf, sizeof(buf))) > 0)
+        res.append(buf, size_t(len));
+    EXPECT_EQ(0, len);
+    gzclose(file);
+    return res;
+}
+
+// Checks the BGZF framing: every member has the "BC" field with its size
+void CheckBlocks(const std::string &data) {
+    size_t pos = 0, blocks = 0;
+    while (pos < data.size()) {
+        ASSERT_LE(pos + 18, data.size());
+        ASSERT_EQ('\x1f', data[pos]);
+        ASSERT_EQ('\x8b', data[pos + 1]);
+        ASSERT_EQ('B', data[pos + 12]);
+        ASSERT_EQ('C', data[pos + 13]);
+        size_t bsize = uint8_t(data[pos + 16]) | (size_t(uint8_t(data[pos + 17])) << 8);
+        pos += bsize + 1;
+        blocks += 1;
+    }
+    EXPECT_EQ(data.size(), pos);
+    EXPECT_LE(2u, blocks);
+}
+
+}
+
+TEST(ReadOutput, CompressedRoundTrip) {
+    auto tmp_dir = fs::tmp::make_temp_dir(".", "read_output");
+    std::string filename = fs::append_path(tmp_dir->dir(), "reads.fastq.gz");
+
+    // Pieces packed separately (some of them empty) and written in order
+    std::vector<std::string> pieces = { RandomReads(2000, 1), "", RandomReads(1, 2), RandomReads(5000, 3) };
+    std::string expected;
+    {
+        hammer::ReadOutput output(filename, true);
+        EXPECT_TRUE(output.compressed());
+        for (const auto &piece : pieces) {
+            output.Write(output.Pack(piece));
+            expected += piece;
+        }
+    }
+
+    CheckBlocks(ReadFile(filename));
+    EXPECT_EQ(expected, Decompress(filename));
+}
+
+TEST(ReadOutput, Plain) {
+    auto tmp_dir = fs::tmp::make_temp_dir(".", "read_output");
+    std::string filename = fs::append_path(tmp_dir->dir(), "reads.fastq");
+
+    std::string text = RandomReads(100, 4);
+    {
+        hammer::ReadOutput output(filename, false);
+        EXPECT_EQ(text, output.Pack(text));
+        output.Write(output.Pack(text));
+    }
+
+    EXPECT_EQ(text, ReadFile(filename));
+}
@@ -6,6 +6,7 @@
 
 #include "sequence/sequence.hpp"
 #include "sequence/nucl.hpp"
+#include "sequence/kmer_extractor.hpp"
 #include <string>
 #include <gtest/gtest.h>
 
@@ -42,3 +43,24 @@ TEST( Sequence, ReverseComplement ) {
     Sequence s2 = Sequence("ACG");
     EXPECT_EQ("CGT", (!s2).str());
 }
+
+TEST( Sequence, KMerExtractor ) {
+    std::string str = "ACGTTGCAACGGTACCTTAGGCATCGATCGGACTTACGATCGATCGGCATGCTAGCTAGGCTAACGTTGCAAGCT";
+    for (unsigned k : { 1, 5, 21, 32, 33, 55 }) {
+        for (const Sequence &s : { Sequence(str), !Sequence(str), Sequence(str).Subseq(7), (!Sequence(str)).Subseq(3, 70) }) {
+            KMerExtractor extractor(k, s);
+            ASSERT_EQ(s.size() - k + 1, extractor.size());
+
+            std::vector<RtSeq> kmers(extractor.size());
+            std::unique_ptr<bool[]> is_minimal(new bool[extractor.size()]);
+            extractor.kmers(0, extractor.size(), kmers.data(), is_minimal.get());
+
+            RtSeq kmer = s.start<RtSeq>(k) >> 'A';
+            for (size_t j = k - 1; j < s.size(); ++j) {
+                kmer <<= s[j];
+                EXPECT_EQ(kmer, kmers[j - k + 1]);
+                EXPECT_EQ(kmer.IsMinimal(), is_minimal[j - k + 1]);
+            }
+        }
+    }
+}